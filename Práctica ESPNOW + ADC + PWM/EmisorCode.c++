@@ -1,46 +1,230 @@
-Código del Emisor ESP32 (Potenciómetro):
+// Código del Emisor ESP32 (Potenciómetro):
 
 #include <Arduino.h>             // Librería principal de Arduino para funciones básicas
 #include <WiFi.h>                // Librería para funciones de Wi-Fi
 #include <esp_now.h>             // Librería para protocolo ESP-NOW
 #include <esp_wifi.h>            // Librería adicional para configuración Wi-Fi de bajo nivel
-#include "driver/adc.h"          // Librería para configurar el ADC de bajo nivel
+#include "../comun/adc_continuo.h" // ADC en modo continuo (DMA) con filtrado en segundo plano
+#include "../comun/calibracion_adc.h" // Crudo -> porcentaje con tabla de calibración en punto fijo
+#include "trama_espnow.h"        // Formato binario compacto de las tramas (secuencia + CRC)
 
-// Definimos el pin del potenciómetro como ADC1_CHANNEL_6 (GPIO34)
-#define Potenciometro ADC1_CHANNEL_6
-#define ADC_WIDTH ADC_WIDTH_BIT_12  // Resolución del ADC a 12 bits (valores de 0 a 4095)
-#define ADC_ATTEN ADC_ATTEN_DB_11   // Atenuación de 11 dB (permite leer hasta ~3.3V)
+// Definimos el pin del potenciómetro como el canal 6 del ADC1 (GPIO34)
+// (12 bits, atenuación de 11 dB: lee hasta ~3.3V)
+#define Potenciometro ADC_CHANNEL_6
 
 const float ADC_VOLT_MAX = 3.3;  // Voltaje máximo de referencia del ADC (no se usa directamente aquí)
 
-// Dirección MAC del receptor (peer) a la cual se enviarán los datos
-uint8_t broadcastAddress[] = {0x5C, 0x01, 0x3B, 0x72, 0x58, 0x7C};
+// Porcentaje de la perilla: lineal en voltaje sobre la ventana útil del ADC (corrige
+// la curva del ADC a 11 dB). La tabla se genera al compilar.
+constexpr punto_calibracion_t PUNTOS_POT[] = {{ADC_11DB_MIN_MV, 0}, {ADC_11DB_MAX_MV, 100}};
+constexpr calibracion_adc_t CAL_POT = calibracion::tabla(PUNTOS_POT);
 
-// Definimos la estructura de los datos que se enviarán mediante ESP-NOW
-typedef struct estructura_del_mensaje {
-    char a[32];  // Cadena de texto de hasta 31 caracteres + terminador nulo
-    int b;       // Valor entero (por ejemplo, lectura cruda del potenciómetro)
-    float c;     // Valor flotante (porcentaje u otro cálculo)
-    bool d;      // Valor booleano (bandera de control, si se quiere)
-} estructura_del_mensaje;
+// Emparejamiento automático: el emisor pide pareja por difusión y aprende la MAC del
+// receptor de su respuesta (ya no hace falta copiarla a mano con CodeMAC.txt)
+const uint8_t DIFUSION[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+uint8_t direccionReceptor[6];               // MAC del receptor, válida si 'emparejado'
+bool emparejado = false;
+unsigned long ultimaSolicitudMs = 0;
 
-estructura_del_mensaje Datos;  // Instancia de la estructura para almacenar los datos a enviar
+// Respuesta de emparejamiento recibida (la escribe OnDataRecv desde la tarea de WiFi)
+volatile bool respuestaRecibida = false;
+uint8_t macRespuesta[6];
+volatile uint8_t salidaAsignada = trama::SIN_SALIDA;
+
+// Identificación de este emisor dentro de las tramas
+#define ID_EMISOR 1                 // Identificador del emisor
+#define CANAL_POT 6                 // Sensor dentro del emisor (canal 6 del ADC1)
+
+// Muestreo adaptativo: se muestrea rápido y solo se transmite cuando la señal cambia
+#define PERIODO_MUESTREO_MS 5       // Muestreo interno (el ADC filtrado entrega ~312 valores/s)
+#define UMBRAL_CAMBIO 40            // Cambio mínimo (cuentas del ADC, ~1 %) que dispara un envío inmediato
+#define PERIODO_MIN_ENVIO_MS 20     // Separación mínima entre tramas mientras la perilla se mueve
+#define PERIODO_LATIDO_MS 5000      // Keep-alive cuando la señal está quieta
+
+// Reintentos según el estado que reporta OnDataSent
+#define REINTENTO_BASE_MS 10        // Espera antes del primer reintento; se duplica en cada fallo
+#define REINTENTO_MAX_MS 1000       // Tope de la espera
+#define MAX_REINTENTOS 5            // Después se descarta la trama y se sigue con muestras nuevas
+
+#define PERIODO_EMPAREJAMIENTO_MS 1000  // Solicitudes de emparejamiento mientras no hay receptor
+#define MAX_DESCARTES_SEGUIDOS 3        // Tramas descartadas seguidas para dar al receptor por perdido
+
+#define PERIODO_METRICAS_MS 10000   // Resumen de latencia y tramas por minuto
+
+trama::Lote lote;                           // Muestras pendientes de enviar
+uint8_t bufferTrama[trama::TAM_MAXIMO];     // Trama codificada (se conserva para reintentarla)
+size_t lenTrama = 0;                        // 0 = no hay trama pendiente de confirmar
+
+// Estado del envío en curso: lo cambia OnDataSent desde la tarea de WiFi
+enum EstadoEnvio : uint8_t { ENVIO_LIBRE, ENVIO_EN_VUELO, ENVIO_OK, ENVIO_FALLIDO };
+volatile EstadoEnvio estadoEnvio = ENVIO_LIBRE;
+volatile uint32_t confirmadoUs = 0;         // micros() de la última confirmación
+
+// Qué abrió un lote: la latencia cambio->confirmacion solo se mide en los que abrió un
+// cruce del umbral con el receptor ya emparejado; los latidos se cuentan aparte
+enum OrigenLote : uint8_t { LOTE_CAMBIO, LOTE_LATIDO, LOTE_SIN_MEDIR };
+
+int ultimoEncolado = -1;          // Último valor agregado al lote
+OrigenLote origenLote = LOTE_SIN_MEDIR;
+uint32_t cambioUs = 0;            // micros() del cambio que abrió el lote pendiente
+OrigenLote origenTrama = LOTE_SIN_MEDIR;  // Lo mismo para la trama en vuelo
+uint32_t cambioTramaUs = 0;
+unsigned long ultimoEnvioMs = 0;
+unsigned long esperaHastaMs = 0;  // Backoff: no se envía antes de este instante
+uint8_t reintentos = 0;
+uint8_t descartesSeguidos = 0;
+
+// Métricas del periodo en curso
+uint32_t tramasOk = 0, tramasFallidas = 0, tramasDescartadas = 0;
+uint32_t latidosOk = 0;           // Parte de tramasOk que solo eran keep-alive
+uint32_t latenciaMinUs = UINT32_MAX, latenciaMaxUs = 0, latenciaN = 0;
+uint64_t latenciaSumaUs = 0;
+unsigned long inicioMetricasMs = 0;
+
+adc_continuo_t adcPot;         // Adquisición continua y filtrada del potenciómetro
 
 esp_now_peer_info_t peerInfo;  // Estructura para guardar información del peer (receptor)
 
-// Callback que se ejecuta cuando se completa un envío
+// Callback que se ejecuta cuando se completa un envío: solo registra el resultado,
+// el lazo principal decide si reintenta
 void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
-    Serial.print("\r\nEstatus del envio del mensaje: \t");
-    // Imprime si el envío fue exitoso o fallido
-    Serial.println(status == ESP_NOW_SEND_SUCCESS ? "Envio completado" : "Envio fallido");
+    if (memcmp(mac_addr, DIFUSION, 6) == 0) return;  // Solicitud de emparejamiento: no se confirma
+    confirmadoUs = micros();
+    estadoEnvio = status == ESP_NOW_SEND_SUCCESS ? ENVIO_OK : ENVIO_FALLIDO;
+}
+
+// Callback de recepción: solo interesa la respuesta de emparejamiento del receptor
+void OnDataRecv(const esp_now_recv_info_t *info, const uint8_t *incomingData, int len) {
+    trama::Control tipo = {};
+    uint8_t salida = 0;
+    if (respuestaRecibida || trama::decodificarControl(incomingData, len, tipo, salida) != trama::Error::Ninguno ||
+        tipo != trama::Control::Respuesta) {
+        return;
+    }
+    memcpy(macRespuesta, info->src_addr, 6);
+    salidaAsignada = salida;
+    respuestaRecibida = true;
+}
+
+// Registra al receptor que respondió como el destino de las tramas
+void emparejar() {
+    memcpy(peerInfo.peer_addr, macRespuesta, 6);  // Copia la dirección MAC del receptor
+    peerInfo.channel = 0;                         // Canal Wi-Fi (0 usa el canal actual)
+    peerInfo.encrypt = false;                     // Comunicación sin cifrado
+    esp_err_t err = esp_now_add_peer(&peerInfo);
+    if (err != ESP_OK && err != ESP_ERR_ESPNOW_EXIST) {
+        Serial.println("Error al agregar semilla");
+        return;
+    }
+    memcpy(direccionReceptor, macRespuesta, 6);
+    emparejado = true;
+    descartesSeguidos = 0;
+    Serial.printf("Emparejado con %02x:%02x:%02x:%02x:%02x:%02x (salida %d)\n", direccionReceptor[0],
+                  direccionReceptor[1], direccionReceptor[2], direccionReceptor[3], direccionReceptor[4],
+                  direccionReceptor[5], salidaAsignada == trama::SIN_SALIDA ? -1 : salidaAsignada);
+}
+
+// Sin respuesta del receptor: vuelve a pedir pareja por difusión
+void desemparejar() {
+    Serial.println("Receptor perdido, buscando uno nuevo");
+    esp_now_del_peer(direccionReceptor);
+    emparejado = false;
+    origenLote = LOTE_SIN_MEDIR;   // El lote pendiente espera al próximo receptor: no es latencia de radio
+    ultimaSolicitudMs = millis();  // Se deja correr un periodo antes de la primera solicitud
+}
+
+void solicitarEmparejamiento(unsigned long ahora) {
+    uint8_t solicitud[trama::TAM_CONTROL];
+    trama::codificarControl(trama::Control::Solicitud, ID_EMISOR, solicitud, sizeof(solicitud));
+    esp_now_send(DIFUSION, solicitud, sizeof(solicitud));
+    ultimaSolicitudMs = ahora;
+}
+
+// Envía (o reenvía) la trama de bufferTrama
+void enviarTrama(unsigned long ahora) {
+    ultimoEnvioMs = ahora;
+    estadoEnvio = ENVIO_EN_VUELO;
+    if (esp_now_send(direccionReceptor, bufferTrama, lenTrama) != ESP_OK) {
+        estadoEnvio = ENVIO_FALLIDO;  // No llegó ni a la cola de la radio: se trata como un fallo
+    }
+}
+
+// Procesa el resultado del último envío: confirma, programa un reintento o descarta
+void revisarEnvio(unsigned long ahora) {
+    if (estadoEnvio == ENVIO_OK) {
+        if (origenTrama == LOTE_CAMBIO) {
+            uint32_t latencia = confirmadoUs - cambioTramaUs;  // Del cambio detectado a la confirmación
+            if (latencia < latenciaMinUs) latenciaMinUs = latencia;
+            if (latencia > latenciaMaxUs) latenciaMaxUs = latencia;
+            latenciaSumaUs += latencia;
+            latenciaN++;
+        } else if (origenTrama == LOTE_LATIDO) {
+            latidosOk++;
+        }
+        tramasOk++;
+        lenTrama = 0;
+        reintentos = 0;
+        descartesSeguidos = 0;
+        estadoEnvio = ENVIO_LIBRE;
+    } else if (estadoEnvio == ENVIO_FALLIDO) {
+        tramasFallidas++;
+        estadoEnvio = ENVIO_LIBRE;
+        if (++reintentos > MAX_REINTENTOS) {
+            Serial.println("Envio fallido: trama descartada");
+            tramasDescartadas++;
+            lenTrama = 0;
+            reintentos = 0;
+            esperaHastaMs = ahora + REINTENTO_MAX_MS;  // El enlace sigue caído: no insistir enseguida
+            if (++descartesSeguidos >= MAX_DESCARTES_SEGUIDOS) desemparejar();
+        } else {
+            unsigned long espera = (unsigned long)REINTENTO_BASE_MS << (reintentos - 1);
+            esperaHastaMs = ahora + (espera < REINTENTO_MAX_MS ? espera : REINTENTO_MAX_MS);
+        }
+    }
+}
+
+// Imprime latencia y tramas por minuto del periodo y reinicia los contadores
+void imprimirMetricas(unsigned long ahora, int raw) {
+    unsigned long periodo = ahora - inicioMetricasMs;
+    Serial.print("Tramas/min: ");
+    Serial.print(periodo ? tramasOk * 60000UL / periodo : 0);
+    Serial.print(" (ok ");
+    Serial.print(tramasOk);
+    Serial.print(", latidos ");
+    Serial.print(latidosOk);
+    Serial.print(", fallidas ");
+    Serial.print(tramasFallidas);
+    Serial.print(", descartadas ");
+    Serial.print(tramasDescartadas);
+    Serial.println(")");
+    if (latenciaN) {
+        Serial.print("Latencia cambio->confirmacion: min ");
+        Serial.print(latenciaMinUs);
+        Serial.print(" prom ");
+        Serial.print((uint32_t)(latenciaSumaUs / latenciaN));
+        Serial.print(" max ");
+        Serial.print(latenciaMaxUs);
+        Serial.println(" us");
+    }
+    Serial.print("Valor: ");
+    Serial.print(raw);
+    Serial.print(" (");
+    int32_t centesimas = calibracion_centesimas(&CAL_POT, raw);  // Porcentaje (0-100%) en punto fijo
+    Serial.printf("%ld.%02ld", (long)(centesimas / 100), (long)(centesimas % 100));
+    Serial.println("%)");
+
+    tramasOk = tramasFallidas = tramasDescartadas = latidosOk = 0;
+    latenciaMinUs = UINT32_MAX;
+    latenciaMaxUs = latenciaN = 0;
+    latenciaSumaUs = 0;
+    inicioMetricasMs = ahora;
 }
 
 void setup() {
     Serial.begin(115200);  // Inicializa la comunicación serial a 115200 baudios
     
-    // Configura el ADC de 12 bits para leer desde GPIO34 (canal 6 de ADC1)
-    adc1_config_width(ADC_WIDTH);
-    adc1_config_channel_atten(Potenciometro, ADC_ATTEN);
+    // Arranca el muestreo continuo de GPIO34 (canal 6 de ADC1) con su cadena de filtros
+    adc_continuo_iniciar(&adcPot, Potenciometro);
     
     // Configura el ESP32 como estación WiFi (no se conecta a ninguna red)
     WiFi.mode(WIFI_STA);
@@ -52,15 +236,14 @@ void setup() {
         return;  // Detiene el setup si hubo error
     }
     
-    // Registra la función de callback que se ejecutará después de cada intento de envío
+    // Registra las funciones de callback de fin de envío y de recepción (emparejamiento)
     esp_now_register_send_cb(OnDataSent);
+    esp_now_register_recv_cb(OnDataRecv);
     
-    // Configura la información del peer (receptor) al que se enviarán los datos
-    memcpy(peerInfo.peer_addr, broadcastAddress, 6);  // Copia la dirección MAC del receptor
+    // Añade la dirección de difusión para las solicitudes de emparejamiento
+    memcpy(peerInfo.peer_addr, DIFUSION, 6);
     peerInfo.channel = 0;                             // Canal Wi-Fi (0 usa el canal actual)
     peerInfo.encrypt = false;                         // Comunicación sin cifrado
-    
-    // Añade el peer (receptor) a la lista de dispositivos conocidos
     if (esp_now_add_peer(&peerInfo) != ESP_OK) {
         Serial.println("Error al agregar semilla");  // Mensaje en caso de error
         return;
@@ -70,28 +253,43 @@ void setup() {
 }
 
 void loop() {
-    int raw = adc1_get_raw(Potenciometro);  // Lee el valor crudo del potenciómetro (0-4095)
-    float porcentaje = (raw / 4095.0) * 100.0;  // Convierte ese valor a porcentaje (0-100%)
-    
-    // Llena la estructura con los datos a enviar
-    strcpy(Datos.a, "Valor ADC GPIO34");  // Texto descriptivo
-    Datos.b = raw;                        // Valor crudo leído del ADC
-    Datos.c = porcentaje;                 // Porcentaje calculado
-    Datos.d = true;                       // Bandera en true (puede usarse como indicador de estado)
-
-    // Envía los datos mediante ESP-NOW al receptor
-    esp_err_t result = esp_now_send(broadcastAddress, (uint8_t *) &Datos, sizeof(Datos));
-    
-    // Imprime si el envío fue exitoso
-    if (result == ESP_OK) {
-        Serial.print("Enviado - Valor: ");
-        Serial.print(raw);
-        Serial.print(" (");
-        Serial.print(porcentaje);
-        Serial.println("%)");
-    } else {
-        Serial.println("Error al enviar");  // Mensaje de error si el envío falla
+    unsigned long ahora = millis();
+    int raw = adc_continuo_valor(&adcPot);  // Valor filtrado del potenciómetro (0-4095), sin bloquear
+
+    revisarEnvio(ahora);
+
+    if (respuestaRecibida) {
+        if (!emparejado) emparejar();
+        respuestaRecibida = false;
     }
-    
-    delay(500);  // Espera medio segundo antes del siguiente envío
+    if (!emparejado && (ultimaSolicitudMs == 0 || ahora - ultimaSolicitudMs >= PERIODO_EMPAREJAMIENTO_MS)) {
+        solicitarEmparejamiento(ahora);
+    }
+
+    // Encola la muestra si cambió más que el umbral, o como keep-alive si no se envía nada hace rato
+    bool cambio = ultimoEncolado < 0 || abs(raw - ultimoEncolado) >= UMBRAL_CAMBIO;
+    bool latido = lote.cantidad() == 0 && lenTrama == 0 && ahora - ultimoEnvioMs >= PERIODO_LATIDO_MS;
+    if ((cambio || latido) && lote.agregar(ahora, raw)) {
+        if (lote.cantidad() == 1) {
+            origenLote = !cambio ? LOTE_LATIDO : emparejado ? LOTE_CAMBIO : LOTE_SIN_MEDIR;
+            cambioUs = micros();
+        }
+        ultimoEncolado = raw;
+    }
+
+    // Un solo envío en vuelo: primero los reintentos, luego el lote nuevo
+    if (emparejado && estadoEnvio == ENVIO_LIBRE && (long)(ahora - esperaHastaMs) >= 0) {
+        if (lenTrama) {
+            enviarTrama(ahora);
+        } else if (lote.cantidad() && ahora - ultimoEnvioMs >= PERIODO_MIN_ENVIO_MS) {
+            lenTrama = lote.cerrar(ID_EMISOR, CANAL_POT, bufferTrama, sizeof(bufferTrama));
+            origenTrama = origenLote;  // El lote siguiente puede abrirse con esta trama en vuelo
+            cambioTramaUs = cambioUs;
+            enviarTrama(ahora);
+        }
+    }
+
+    if (ahora - inicioMetricasMs >= PERIODO_METRICAS_MS) imprimirMetricas(ahora, raw);
+
+    delay(PERIODO_MUESTREO_MS);  // Espera hasta la siguiente muestra
 }
@@ -1,49 +1,281 @@
-Código del Receptor ESP32 (LED PWM):
+// Código del Receptor ESP32 (gateway: varios emisores, una salida PWM o relé por emisor):
 
 #include <esp_now.h>         // Librería para usar el protocolo ESP-NOW
 #include <WiFi.h>            // Librería para funciones de red Wi-Fi
+#include <esp_wifi.h>        // MAC propia para el mensaje de arranque
+#include <atomic>
+#include "trama_espnow.h"    // Formato binario compacto de las tramas (secuencia + CRC)
+#include "tabla_pares.h"     // Emisores conocidos y sus estadísticas
+#include "../comun/cola_spsc.h"  // Cola sin bloqueos entre el callback y la tarea consumidora
 
-#define LED 5                // Definimos el pin GPIO5 para el LED
-
-// Configuración del canal PWM
+// Configuración de los canales PWM
 const int frecuencia = 5000;     // Frecuencia de la señal PWM en Hz
-const int canal = 0;             // Número del canal PWM (0-15 disponibles en ESP32)
 const int resolucion = 12;       // Resolución del PWM en bits (12 bits = 0 a 4095)
 
-// Definición de la estructura para recibir los datos del emisor
-typedef struct struct_message {
-  char a[32];            // Cadena de texto (hasta 31 caracteres + '\0')
-  int raw;               // Valor entero (ej. valor crudo del ADC)
-  float Porcentaje;      // Valor en porcentaje
-  bool d;                // Valor booleano
-} struct_message;
+// Salidas disponibles: cada emisor recibe la primera libre al pedir emparejamiento y
+// la devuelve cuando deja de transmitir. Las PWM usan el canal LEDC igual a su
+// posición en la tabla.
+enum TipoSalida : uint8_t { SALIDA_PWM, SALIDA_RELE };
+struct Salida {
+  TipoSalida tipo;
+  uint8_t pin;
+};
+const Salida SALIDAS[] = {
+  {SALIDA_PWM, 5},    // Canal 0: el LED del montaje con un solo emisor
+  {SALIDA_PWM, 18},
+  {SALIDA_PWM, 19},
+  {SALIDA_PWM, 21},
+  {SALIDA_PWM, 22},
+  {SALIDA_PWM, 23},
+  {SALIDA_RELE, 25},
+  {SALIDA_RELE, 26},
+  {SALIDA_RELE, 27},
+  {SALIDA_RELE, 32},
+};
+const uint8_t NUM_SALIDAS = sizeof(SALIDAS) / sizeof(SALIDAS[0]);
+
+// Histéresis de los relés sobre el valor del ADC del emisor
+const int RELE_ENCENDER = 2458;  // ~60 %
+const int RELE_APAGAR = 1638;    // ~40 %
+
+// Tramas validadas que esperan a la tarea consumidora. El callback de ESP-NOW corre
+// en la tarea de WiFi: solo valida y copia la trama aquí, sin imprimir ni tocar salidas.
+struct TramaRecibida {
+  uint8_t mac[6];
+  int8_t rssi;
+  uint8_t len;
+  uint8_t datos[trama::TAM_MAXIMO];
+};
+
+const size_t TAM_COLA = 64;                 // Tramas en vuelo (potencia de 2): ~130 ms a 500 tramas/s
+const unsigned long PERIODO_LOG_MS = 1000;  // Un resumen por segundo en el monitor serial...
+const size_t PARES_POR_LOG = 4;             // ...con unos pocos emisores por vez (rotando)
+
+// Un emisor quieto manda un latido cada 5 s: sin tramas durante cuatro latidos se da
+// por apagado, se borra de la tabla y su salida queda libre para otro
+const unsigned long VENCIMIENTO_PAR_MS = 20000;
+
+ColaSPSC<TramaRecibida, TAM_COLA> cola;
+TaskHandle_t tareaConsumidor = nullptr;
+
+// Contadores del lado del callback (los lee la tarea consumidora)
+std::atomic<uint32_t> tramasInvalidas{0};  // Tramas descartadas por longitud, versión o CRC
+std::atomic<uint8_t> ultimoError{0};
 
-// Creamos una variable de tipo struct_message para almacenar los datos recibidos
-struct_message Datos;
+// Estado que solo toca la tarea consumidora
+pares::Tabla tabla;
+bool salidaAsignada[NUM_SALIDAS] = {};
+bool releEncendido[NUM_SALIDAS] = {};
+uint32_t tramasSinPar = 0;  // Tramas de datos de emisores que no pidieron emparejamiento
 
 // Función callback que se ejecuta automáticamente al recibir datos vía ESP-NOW
-void OnDataRecv(const uint8_t * mac, const uint8_t *incomingData, int len) {
-  // Copia los datos recibidos del buffer 'incomingData' a la estructura 'Datos'
-  memcpy(&Datos, incomingData, sizeof(Datos));
-
-  // Imprime en el monitor serial los datos recibidos
-  Serial.print("Data received: ");
-  Serial.println(len);
-  Serial.print("Character Value: ");
-  Serial.println(Datos.a);
-  Serial.print("Integer Value: ");
-  Serial.println(Datos.raw);
-  Serial.print("Float Value: ");
-  Serial.println(Datos.Porcentaje);
-  Serial.print("Boolean Value: ");
-  Serial.println(Datos.d);
-  Serial.println();
-
-  // Convierte el valor recibido (raw) en un duty cycle válido para el PWM
-  int duty = constrain(Datos.raw, 0, 4095);  // Asegura que el valor esté entre 0 y 4095
-
-  // Aplica el valor PWM al LED usando ledcWrite
-  ledcWrite(canal, duty);  // Cambia el brillo del LED según el duty cycle recibido
+void OnDataRecv(const esp_now_recv_info_t *info, const uint8_t *incomingData, int len) {
+  // Valida longitud, versión y CRC antes de encolar
+  trama::Control tipo = {};
+  uint8_t dato = 0;
+  trama::Error error = trama::esControl(incomingData, len)
+                           ? trama::decodificarControl(incomingData, len, tipo, dato)
+                           : trama::validar(incomingData, len);
+  if (error != trama::Error::Ninguno) {
+    ultimoError.store((uint8_t)error, std::memory_order_relaxed);
+    tramasInvalidas.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  TramaRecibida *t = cola.reservar();
+  if (!t) return;  // Cola llena: la trama se descarta y queda contada en cola.descartes()
+
+  memcpy(t->mac, info->src_addr, sizeof(t->mac));
+  t->rssi = info->rx_ctrl->rssi;  // La pila lo entrega con cada trama (IDF 5)
+  t->len = (uint8_t)len;
+  memcpy(t->datos, incomingData, len);
+  cola.publicar();
+  xTaskNotifyGive(tareaConsumidor);
+}
+
+// Las respuestas de emparejamiento usan un par temporal: se borra al terminar el envío
+// para no agotar los 20 pares que admite el driver de ESP-NOW
+void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
+  (void)status;  // Entregada o no, el par temporal ya no hace falta
+  esp_now_del_peer(mac_addr);
+}
+
+// Responde una solicitud de emparejamiento con la salida asignada
+void responderEmparejamiento(const uint8_t *mac, uint8_t salida) {
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;       // Canal Wi-Fi actual
+  peer.encrypt = false;
+  esp_err_t err = esp_now_add_peer(&peer);
+  if (err != ESP_OK && err != ESP_ERR_ESPNOW_EXIST) return;  // El emisor volverá a pedirlo
+
+  uint8_t respuesta[trama::TAM_CONTROL];
+  trama::codificarControl(trama::Control::Respuesta, salida, respuesta, sizeof(respuesta));
+  if (esp_now_send(mac, respuesta, sizeof(respuesta)) != ESP_OK) esp_now_del_peer(mac);
+}
+
+// Lleva la salida del emisor al último valor recibido
+void aplicarSalida(uint8_t salida, uint16_t valor) {
+  if (salida >= NUM_SALIDAS) return;
+  if (SALIDAS[salida].tipo == SALIDA_PWM) {
+    ledcWrite(SALIDAS[salida].pin, constrain((int)valor, 0, 4095));  // Cambia el brillo según el duty cycle recibido
+  } else {
+    bool encender = releEncendido[salida] ? valor > RELE_APAGAR : valor >= RELE_ENCENDER;
+    if (encender != releEncendido[salida]) {
+      releEncendido[salida] = encender;
+      digitalWrite(SALIDAS[salida].pin, encender ? HIGH : LOW);
+    }
+  }
+}
+
+// Primera salida libre, o SIN_SALIDA si todas tienen emisor
+uint8_t asignarSalida() {
+  for (uint8_t s = 0; s < NUM_SALIDAS; s++) {
+    if (!salidaAsignada[s]) {
+      salidaAsignada[s] = true;
+      return s;
+    }
+  }
+  return trama::SIN_SALIDA;
+}
+
+// Apaga la salida de un emisor dado de baja y la deja para el próximo que se empareje
+void liberarSalida(uint8_t salida) {
+  if (salida >= NUM_SALIDAS) return;
+  if (SALIDAS[salida].tipo == SALIDA_PWM) {
+    ledcWrite(SALIDAS[salida].pin, 0);
+  } else {
+    releEncendido[salida] = false;
+    digitalWrite(SALIDAS[salida].pin, LOW);
+  }
+  salidaAsignada[salida] = false;
+}
+
+// Procesa una trama de la cola: registra al emisor, actualiza sus estadísticas y su salida
+void procesarTrama(const TramaRecibida &t, uint32_t &procesadas) {
+  if (trama::esControl(t.datos, t.len)) {
+    trama::Control tipo = {};
+    uint8_t emisor = 0;
+    trama::decodificarControl(t.datos, t.len, tipo, emisor);  // Ya validada
+    if (tipo != trama::Control::Solicitud) return;
+
+    // Solo una solicitud de emparejamiento da de alta a un emisor y le asigna salida
+    bool nuevo;
+    size_t i = tabla.registrar(t.mac, nuevo);
+    if (i == pares::NINGUNO) return;  // Tabla llena
+    pares::Par &par = tabla[i];
+    // Un emisor conocido que vuelve a pedir emparejamiento reinició y su secuencia
+    // arranca de nuevo en 0: sin esto sus primeras tramas parecerían duplicados
+    if (!nuevo) par.secuencia.reiniciar();
+    if (par.salida == trama::SIN_SALIDA) par.salida = asignarSalida();
+    par.emisor = emisor;
+    par.ultimaVezMs = millis();
+    responderEmparejamiento(t.mac, par.salida);
+    return;
+  }
+
+  // Las tramas de datos de una MAC que no pidió emparejamiento no ocupan lugar en la tabla
+  size_t i = tabla.buscar(t.mac);
+  if (i == pares::NINGUNO) {
+    tramasSinPar++;
+    return;
+  }
+  pares::Par &par = tabla[i];
+
+  trama::Encabezado enc = {};
+  trama::Muestra muestras[trama::MAX_MUESTRAS];
+  trama::decodificar(t.datos, t.len, enc, muestras, trama::MAX_MUESTRAS);  // Ya validada
+  const trama::Muestra &ultima = muestras[enc.cantidad - 1];  // Solo interesa la más reciente
+
+  // Ignora duplicados y tramas que llegan después de una más nueva
+  if (!par.secuencia.registrar(enc.secuencia)) return;
+  par.emisor = enc.emisor;
+  par.ultimaVezMs = millis();
+  par.ultimoValor = ultima.valor;
+  par.registrarRssi(t.rssi);
+  procesadas++;
+
+  aplicarSalida(par.salida, ultima.valor);
+}
+
+// Da de baja a los emisores que dejaron de transmitir y libera sus salidas
+void vencerPares(unsigned long ahora) {
+  for (size_t i = 0; i < pares::CAPACIDAD;) {
+    if (!tabla.ocupada(i) || ahora - tabla[i].ultimaVezMs <= VENCIMIENTO_PAR_MS) {
+      i++;
+      continue;
+    }
+    uint8_t mac[6];
+    tabla.mac(i, mac);
+    Serial.printf("Emisor %02x:%02x:%02x:%02x:%02x:%02x sin tramas hace %lu ms: baja, salida %d libre\n", mac[0],
+                  mac[1], mac[2], mac[3], mac[4], mac[5], ahora - tabla[i].ultimaVezMs,
+                  tabla[i].salida == trama::SIN_SALIDA ? -1 : tabla[i].salida);
+    liberarSalida(tabla[i].salida);
+    tabla.borrar(i);  // Otro par puede correrse a la casilla i: se vuelve a examinar
+  }
+}
+
+// Resumen periódico: totales y algunos emisores, rotando para no saturar el puerto serie
+void imprimirResumen(uint32_t tramasPorSegundo, size_t &siguientePar) {
+  Serial.printf("Emisores: %u  Tramas/s: %lu  Invalidas: %lu (ultimo error %d)  Sin par: %lu  Cola: max %lu/%u, "
+                "descartadas %lu\n",
+                (unsigned)tabla.cantidad(), (unsigned long)tramasPorSegundo,
+                (unsigned long)tramasInvalidas.load(std::memory_order_relaxed),
+                (int)ultimoError.load(std::memory_order_relaxed), (unsigned long)tramasSinPar,
+                (unsigned long)cola.maximaOcupacion(),
+                (unsigned)cola.capacidad(), (unsigned long)cola.descartes());
+
+  size_t impresos = 0;
+  for (size_t n = 0; n < pares::CAPACIDAD && impresos < PARES_POR_LOG && impresos < tabla.cantidad(); n++) {
+    size_t i = siguientePar;
+    siguientePar = (siguientePar + 1) % pares::CAPACIDAD;
+    if (!tabla.ocupada(i)) continue;
+
+    const pares::Par &par = tabla[i];
+    uint8_t mac[6];
+    tabla.mac(i, mac);
+    Serial.printf("  %02x:%02x:%02x:%02x:%02x:%02x id %u salida %d  valor %u  recibidas %lu  perdidas %lu.%lu%%"
+                  "  reinicios %lu  RSSI %d (prom %d) dBm  hace %lu ms\n",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], par.emisor,
+                  par.salida == trama::SIN_SALIDA ? -1 : par.salida, par.ultimoValor,
+                  (unsigned long)par.secuencia.recibidas(), (unsigned long)(par.perdidaPorMil() / 10),
+                  (unsigned long)(par.perdidaPorMil() % 10), (unsigned long)par.secuencia.reinicios(), par.rssi,
+                  par.rssiPromedio(),
+                  (unsigned long)(millis() - par.ultimaVezMs));
+    impresos++;
+  }
+}
+
+// Tarea consumidora: vacía la cola, aplica las salidas y registra
+void tareaTramas(void *arg) {
+  (void)arg;
+  uint32_t procesadas = 0;
+  uint32_t procesadasLog = 0;  // 'procesadas' en el último resumen impreso
+  unsigned long ultimoLog = 0;
+  unsigned long ultimoVencimiento = 0;
+  size_t siguientePar = 0;
+
+  while (true) {
+    // Despierta con cada trama o, como mucho, al vencer el periodo del resumen
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PERIODO_LOG_MS));
+
+    const TramaRecibida *t;
+    while ((t = cola.frente()) != nullptr) {
+      procesarTrama(*t, procesadas);
+      cola.retirar();
+    }
+
+    unsigned long ahora = millis();
+    if (ahora - ultimoVencimiento >= PERIODO_LOG_MS) {
+      vencerPares(ahora);
+      ultimoVencimiento = ahora;
+    }
+    if (procesadas != procesadasLog && ahora - ultimoLog >= PERIODO_LOG_MS) {
+      imprimirResumen((procesadas - procesadasLog) * 1000UL / (ahora - ultimoLog), siguientePar);
+      procesadasLog = procesadas;
+      ultimoLog = ahora;
+    }
+  }
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------*/
@@ -58,16 +290,31 @@ void setup() {
     return;  // Sale del setup si hubo error
   }
 
-  // Registra la función callback para manejar los datos recibidos
-  esp_now_register_recv_cb(OnDataRecv);
+  // Configura las salidas: canales PWM con frecuencia y resolución especificadas, o relés
+  for (uint8_t i = 0; i < NUM_SALIDAS; i++) {
+    if (SALIDAS[i].tipo == SALIDA_PWM) {
+      ledcAttachChannel(SALIDAS[i].pin, frecuencia, resolucion, i);
+    } else {
+      pinMode(SALIDAS[i].pin, OUTPUT);
+      digitalWrite(SALIDAS[i].pin, LOW);
+    }
+  }
+
+  // La tarea consumidora debe existir antes de la primera trama. Va en el núcleo 1
+  // para no competir con la pila de WiFi (núcleo 0).
+  xTaskCreatePinnedToCore(tareaTramas, "tramas", 4096, nullptr, 2, &tareaConsumidor, 1);
 
-  // Configura el canal PWM con frecuencia y resolución especificadas
-  ledcSetup(canal, frecuencia, resolucion);
+  // Registra las funciones callback de recepción y de fin de envío
+  esp_now_register_recv_cb(OnDataRecv);
+  esp_now_register_send_cb(OnDataSent);
 
-  // Asocia el canal PWM al pin GPIO definido (LED)
-  ledcAttachPin(LED, canal);
+  uint8_t mac[6];
+  esp_wifi_get_mac(WIFI_IF_STA, mac);
+  Serial.printf("Gateway listo en %02x:%02x:%02x:%02x:%02x:%02x, esperando emisores\n",
+                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 }
 
 void loop() {
-  // No se necesita lógica en el loop, ya que el control del LED ocurre en la función callback
+  // No se necesita lógica en el loop: las salidas las controla la tarea consumidora
+  vTaskDelay(pdMS_TO_TICKS(1000));
 }
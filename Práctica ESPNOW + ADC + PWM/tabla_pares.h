@@ -0,0 +1,124 @@
+// Tabla de emisores (pares) conocidos por el receptor en modo gateway
+//
+// Capacidad fija y sin memoria dinámica. Las MAC se guardan como enteros de 48 bits
+// en un arreglo contiguo con direccionamiento abierto (sondeo lineal), así que una
+// búsqueda típica toca una sola línea de caché. Las estadísticas de cada par viven
+// en otro arreglo con el mismo índice para que la búsqueda no arrastre datos fríos.
+// Los pares que dejan de transmitir se borran corriendo hacia atrás el resto de su
+// cadena de sondeo (sin lápidas), así una búsqueda sigue terminando en la primera
+// casilla vacía aunque la tabla haya tenido muchas altas y bajas.
+//
+// No depende de Arduino: se puede compilar y medir en Linux.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "trama_espnow.h"
+
+namespace pares {
+
+constexpr size_t BITS = 6;
+constexpr size_t CAPACIDAD = 1u << BITS;       // 64 casillas
+constexpr size_t MAXIMO = CAPACIDAD * 3 / 4;   // Ocupación máxima: mantiene cortas las cadenas de sondeo
+constexpr size_t NINGUNO = SIZE_MAX;
+
+// Estadísticas y configuración de un emisor
+struct Par {
+    trama::Secuencia secuencia;   // Recibidas, perdidas, duplicadas, desordenadas y reinicios
+    uint32_t ultimaVezMs;         // millis() de la última trama válida
+    int32_t rssiFiltrado;         // EMA del RSSI en dBm x 16 (alfa = 1/8)
+    int8_t rssi;                  // RSSI de la última trama
+    uint8_t emisor;               // Identificador que viaja en las tramas
+    uint8_t salida;               // Índice de la salida asignada o trama::SIN_SALIDA
+    uint16_t ultimoValor;
+
+    void registrarRssi(int8_t nuevo) {
+        rssi = nuevo;
+        rssiFiltrado = rssiFiltrado == 0 ? nuevo * 16 : rssiFiltrado + (nuevo * 16 - rssiFiltrado) / 8;  // 0 = sin lecturas
+    }
+    int rssiPromedio() const { return rssiFiltrado / 16; }
+
+    // Porcentaje de tramas perdidas x 10 (una décima de resolución)
+    uint32_t perdidaPorMil() const {
+        uint32_t total = secuencia.recibidas() + secuencia.perdidas();
+        return total ? secuencia.perdidas() * 1000 / total : 0;
+    }
+};
+
+inline uint64_t clave(const uint8_t mac[6]) {
+    uint64_t k = 0;
+    for (int i = 0; i < 6; i++) k = (k << 8) | mac[i];
+    return k;
+}
+
+class Tabla {
+public:
+    Tabla() {
+        for (size_t i = 0; i < CAPACIDAD; i++) claves_[i] = VACIA;
+    }
+
+    // Índice del par con esa MAC, o NINGUNO
+    size_t buscar(const uint8_t mac[6]) const {
+        uint64_t k = clave(mac);
+        for (size_t i = inicio(k);; i = (i + 1) & (CAPACIDAD - 1)) {
+            if (claves_[i] == k) return i;
+            if (claves_[i] == VACIA) return NINGUNO;
+        }
+    }
+
+    // Índice del par (lo crea si no existe). 'nuevo' indica si se acaba de crear.
+    // Devuelve NINGUNO si la tabla está llena.
+    size_t registrar(const uint8_t mac[6], bool &nuevo) {
+        uint64_t k = clave(mac);
+        nuevo = false;
+        size_t i = inicio(k);
+        for (; claves_[i] != VACIA; i = (i + 1) & (CAPACIDAD - 1)) {
+            if (claves_[i] == k) return i;
+        }
+        if (n_ == MAXIMO) return NINGUNO;
+        claves_[i] = k;
+        pares_[i] = Par();
+        pares_[i].salida = trama::SIN_SALIDA;
+        n_++;
+        nuevo = true;
+        return i;
+    }
+
+    // Borra el par de la casilla i. Los pares que seguían en la cadena de sondeo se
+    // corren para llenar el hueco, así que otro par puede quedar en la casilla i:
+    // quien recorre la tabla borrando debe volver a examinarla.
+    void borrar(size_t i) {
+        for (size_t j = (i + 1) & (CAPACIDAD - 1); claves_[j] != VACIA; j = (j + 1) & (CAPACIDAD - 1)) {
+            // El de la casilla j se corre a i si su casilla de inicio no cae entre i (exclusive) y j
+            size_t desplazamiento = (j - inicio(claves_[j])) & (CAPACIDAD - 1);
+            if (desplazamiento < ((j - i) & (CAPACIDAD - 1))) continue;
+            claves_[i] = claves_[j];
+            pares_[i] = pares_[j];
+            i = j;
+        }
+        claves_[i] = VACIA;
+        n_--;
+    }
+
+    bool ocupada(size_t i) const { return claves_[i] != VACIA; }
+    Par &operator[](size_t i) { return pares_[i]; }
+    const Par &operator[](size_t i) const { return pares_[i]; }
+    size_t cantidad() const { return n_; }
+
+    void mac(size_t i, uint8_t salida[6]) const {
+        for (int b = 0; b < 6; b++) salida[b] = (uint8_t)(claves_[i] >> (40 - 8 * b));
+    }
+
+private:
+    static constexpr uint64_t VACIA = UINT64_MAX;  // Ninguna MAC de 48 bits la alcanza
+
+    // Hash multiplicativo (Fibonacci): los bits altos del producto dispersan MAC consecutivas
+    static size_t inicio(uint64_t k) { return (size_t)((k * 0x9E3779B97F4A7C15ull) >> (64 - BITS)); }
+
+    uint64_t claves_[CAPACIDAD];
+    Par pares_[CAPACIDAD];
+    size_t n_ = 0;
+};
+
+}  // namespace pares
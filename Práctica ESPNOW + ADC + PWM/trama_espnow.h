@@ -0,0 +1,299 @@
+// Formato binario de las tramas ESP-NOW entre el emisor y el receptor
+//
+// Trama (little-endian, sin relleno, máximo 250 bytes):
+//   [0]      versión del formato (TRAMA_VERSION)
+//   [1]      identificador del emisor
+//   [2]      canal / sensor dentro del emisor
+//   [3]      cantidad de muestras N
+//   [4..5]   número de secuencia (uint16)
+//   [6..9]   marca de tiempo de la primera muestra en ms (uint32)
+//   N x 4    muestras: desfase en ms respecto a la primera (uint16) + valor del ADC (uint16)
+//   [..+2]   CRC-16/CCITT de todo lo anterior
+//
+// Una trama con una sola muestra ocupa 16 bytes (antes 44) y una llena transporta
+// 59 muestras, unos 4.2 bytes por muestra. No depende de Arduino: se puede
+// compilar y medir en Linux.
+//
+// Trama de control para el emparejamiento automático (5 bytes):
+//   [0]      MARCA_CONTROL (nunca coincide con una versión de datos)
+//   [1]      tipo: solicitud (emisor -> difusión) o respuesta (receptor -> emisor)
+//   [2]      dato: id del emisor en la solicitud, salida asignada en la respuesta
+//   [3..4]   CRC-16/CCITT de todo lo anterior
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace trama {
+
+constexpr uint8_t VERSION = 1;
+constexpr size_t TAM_MAXIMO = 250;       // Carga útil máxima de ESP-NOW
+constexpr size_t TAM_ENCABEZADO = 10;
+constexpr size_t TAM_MUESTRA = 4;
+constexpr size_t TAM_CRC = 2;
+constexpr size_t MAX_MUESTRAS = (TAM_MAXIMO - TAM_ENCABEZADO - TAM_CRC) / TAM_MUESTRA;  // 59
+
+constexpr uint8_t MARCA_CONTROL = 0xC7;
+constexpr size_t TAM_CONTROL = 5;
+constexpr uint8_t SIN_SALIDA = 0xFF;     // Respuesta: el receptor no tiene salidas libres
+
+enum class Control : uint8_t {
+    Solicitud = 1,
+    Respuesta = 2,
+};
+
+struct Encabezado {
+    uint8_t emisor;
+    uint8_t canal;
+    uint8_t cantidad;
+    uint16_t secuencia;
+    uint32_t t0_ms;
+};
+
+struct Muestra {
+    uint32_t t_ms;    // Marca de tiempo absoluta (ms del emisor)
+    uint16_t valor;   // Lectura del ADC (0-4095)
+};
+
+enum class Error : uint8_t {
+    Ninguno,
+    Corta,      // Menos bytes que un encabezado + CRC
+    Version,    // Versión de formato desconocida
+    Longitud,   // La longitud no coincide con la cantidad de muestras
+    CRC,        // Datos corruptos
+};
+
+// ----------------------------------------------------------------------------
+// CRC-16/CCITT-FALSE (polinomio 0x1021, valor inicial 0xFFFF) con tabla
+// generada en tiempo de compilación
+// ----------------------------------------------------------------------------
+struct TablaCRC {
+    uint16_t v[256];
+    constexpr TablaCRC() : v() {
+        for (int i = 0; i < 256; i++) {
+            uint16_t c = (uint16_t)(i << 8);
+            for (int b = 0; b < 8; b++) c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+            v[i] = c;
+        }
+    }
+};
+
+constexpr TablaCRC TABLA_CRC;
+
+inline uint16_t crc16(const uint8_t *datos, size_t n) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < n; i++) {
+        crc = (uint16_t)((crc << 8) ^ TABLA_CRC.v[(uint8_t)((crc >> 8) ^ datos[i])]);
+    }
+    return crc;
+}
+
+// ----------------------------------------------------------------------------
+// Lectura y escritura little-endian independientes del procesador
+// ----------------------------------------------------------------------------
+inline void escribir16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void escribir32(uint8_t *p, uint32_t v) {
+    escribir16(p, (uint16_t)v);
+    escribir16(p + 2, (uint16_t)(v >> 16));
+}
+
+inline uint16_t leer16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+inline uint32_t leer32(const uint8_t *p) { return leer16(p) | ((uint32_t)leer16(p + 2) << 16); }
+
+// Tamaño de una trama con 'n' muestras
+constexpr size_t tamano(size_t n) { return TAM_ENCABEZADO + n * TAM_MUESTRA + TAM_CRC; }
+
+// ----------------------------------------------------------------------------
+// Codifica 'n' muestras en 'salida'. Todas deben estar dentro de los 65.5 s
+// siguientes a la primera. Devuelve el largo de la trama, o 0 si no cabe.
+// ----------------------------------------------------------------------------
+inline size_t codificar(uint8_t emisor, uint8_t canal, uint16_t secuencia, const Muestra *muestras, size_t n,
+                        uint8_t *salida, size_t capacidad) {
+    if (n == 0 || n > MAX_MUESTRAS || tamano(n) > capacidad) return 0;
+
+    uint32_t t0 = muestras[0].t_ms;
+    salida[0] = VERSION;
+    salida[1] = emisor;
+    salida[2] = canal;
+    salida[3] = (uint8_t)n;
+    escribir16(salida + 4, secuencia);
+    escribir32(salida + 6, t0);
+
+    uint8_t *p = salida + TAM_ENCABEZADO;
+    for (size_t i = 0; i < n; i++, p += TAM_MUESTRA) {
+        uint32_t desfase = muestras[i].t_ms - t0;
+        if (desfase > 0xFFFF) return 0;
+        escribir16(p, (uint16_t)desfase);
+        escribir16(p + 2, muestras[i].valor);
+    }
+    escribir16(p, crc16(salida, (size_t)(p - salida)));
+    return (size_t)(p - salida) + TAM_CRC;
+}
+
+// ----------------------------------------------------------------------------
+// Valida longitud, versión y CRC sin decodificar las muestras
+// ----------------------------------------------------------------------------
+inline Error validar(const uint8_t *datos, size_t len) {
+    if (len < TAM_ENCABEZADO + TAM_CRC) return Error::Corta;
+    if (datos[0] != VERSION) return Error::Version;
+    if (datos[3] == 0 || datos[3] > MAX_MUESTRAS || len != tamano(datos[3])) return Error::Longitud;
+    if (crc16(datos, len - TAM_CRC) != leer16(datos + len - TAM_CRC)) return Error::CRC;
+    return Error::Ninguno;
+}
+
+// ----------------------------------------------------------------------------
+// Valida y decodifica una trama. Copia como máximo 'capacidad' muestras.
+// ----------------------------------------------------------------------------
+inline Error decodificar(const uint8_t *datos, size_t len, Encabezado &enc, Muestra *muestras, size_t capacidad) {
+    Error error = validar(datos, len);
+    if (error != Error::Ninguno) return error;
+
+    enc.emisor = datos[1];
+    enc.canal = datos[2];
+    enc.cantidad = datos[3];
+    enc.secuencia = leer16(datos + 4);
+    enc.t0_ms = leer32(datos + 6);
+
+    const uint8_t *p = datos + TAM_ENCABEZADO;
+    for (size_t i = 0; i < enc.cantidad && i < capacidad; i++, p += TAM_MUESTRA) {
+        muestras[i].t_ms = enc.t0_ms + leer16(p);
+        muestras[i].valor = leer16(p + 2);
+    }
+    return Error::Ninguno;
+}
+
+// ----------------------------------------------------------------------------
+// Tramas de control del emparejamiento
+// ----------------------------------------------------------------------------
+inline bool esControl(const uint8_t *datos, size_t len) { return len > 0 && datos[0] == MARCA_CONTROL; }
+
+inline size_t codificarControl(Control tipo, uint8_t dato, uint8_t *salida, size_t capacidad) {
+    if (capacidad < TAM_CONTROL) return 0;
+    salida[0] = MARCA_CONTROL;
+    salida[1] = (uint8_t)tipo;
+    salida[2] = dato;
+    escribir16(salida + 3, crc16(salida, 3));
+    return TAM_CONTROL;
+}
+
+inline Error decodificarControl(const uint8_t *datos, size_t len, Control &tipo, uint8_t &dato) {
+    if (len != TAM_CONTROL) return Error::Longitud;
+    if (datos[0] != MARCA_CONTROL) return Error::Version;
+    if (crc16(datos, 3) != leer16(datos + 3)) return Error::CRC;
+    tipo = (Control)datos[1];
+    dato = datos[2];
+    return Error::Ninguno;
+}
+
+// ----------------------------------------------------------------------------
+// Lote de muestras pendientes de enviar (lado del emisor)
+// ----------------------------------------------------------------------------
+class Lote {
+public:
+    // Agrega una muestra; devuelve false si ya no cabe (hay que enviar primero)
+    bool agregar(uint32_t t_ms, uint16_t valor) {
+        if (n_ == MAX_MUESTRAS || (n_ > 0 && t_ms - muestras_[0].t_ms > 0xFFFF)) return false;
+        muestras_[n_++] = {t_ms, valor};
+        return true;
+    }
+
+    // Codifica el lote con el siguiente número de secuencia y lo vacía
+    size_t cerrar(uint8_t emisor, uint8_t canal, uint8_t *salida, size_t capacidad) {
+        size_t len = codificar(emisor, canal, secuencia_, muestras_, n_, salida, capacidad);
+        if (len) {
+            secuencia_++;
+            n_ = 0;
+        }
+        return len;
+    }
+
+    size_t cantidad() const { return n_; }
+    const Muestra &ultima() const { return muestras_[n_ - 1]; }
+    uint16_t secuencia() const { return secuencia_; }
+
+private:
+    Muestra muestras_[MAX_MUESTRAS];
+    size_t n_ = 0;
+    uint16_t secuencia_ = 0;
+};
+
+// ----------------------------------------------------------------------------
+// Seguimiento de la secuencia de un emisor (lado del receptor): detecta tramas
+// perdidas, duplicadas y fuera de orden con aritmética módulo 2^16.
+//
+// Solo un retroceso de hasta VENTANA_REORDEN números es una trama tardía o un
+// duplicado; una máscara recuerda cuáles de esos números llegaron, así una tardía
+// descuenta una pérdida que sí se había contado y un duplicado no. Un retroceso
+// mayor es un reinicio del emisor (la secuencia volvió a 0): se acepta la trama y
+// se sigue desde ahí. Si el emisor avisa que reinició (vuelve a pedir
+// emparejamiento), reiniciar() olvida la posición aunque el retroceso sea menor.
+// ----------------------------------------------------------------------------
+class Secuencia {
+public:
+    static constexpr int VENTANA_REORDEN = 32;
+
+    // Devuelve true si la trama es nueva y debe procesarse
+    bool registrar(uint16_t seq) {
+        int16_t salto = (int16_t)(seq - esperada_);
+        if (!iniciada_ || salto < -VENTANA_REORDEN) {
+            if (iniciada_) reinicios_++;
+            iniciada_ = true;
+            vistas_ = ~0u;  // Lo anterior no se contó como perdido: si llega, se toma como duplicado
+            return aceptar(seq);
+        }
+        if (salto < 0) {
+            // Ya pasó: llegó tarde (estaba contada como perdida) o es un duplicado.
+            // Bit i de la máscara = número esperada_ - 1 - i.
+            uint32_t bit = 1u << (-salto - 1);
+            if (vistas_ & bit) {
+                duplicadas_++;
+            } else {
+                vistas_ |= bit;
+                desordenadas_++;
+                perdidas_--;
+            }
+            return false;
+        }
+        perdidas_ += (uint16_t)salto;
+        vistas_ = salto + 1 < VENTANA_REORDEN ? vistas_ << (salto + 1) : 0;
+        return aceptar(seq);
+    }
+
+    // El emisor reinició: la próxima trama se acepta sea cual sea su número. Las
+    // estadísticas se conservan y el reinicio se cuenta.
+    void reiniciar() {
+        if (iniciada_) reinicios_++;
+        iniciada_ = false;
+    }
+
+    uint32_t recibidas() const { return recibidas_; }
+    uint32_t perdidas() const { return perdidas_; }
+    uint32_t duplicadas() const { return duplicadas_; }
+    uint32_t desordenadas() const { return desordenadas_; }
+    uint32_t reinicios() const { return reinicios_; }
+
+private:
+    bool aceptar(uint16_t seq) {
+        esperada_ = (uint16_t)(seq + 1);
+        vistas_ |= 1;
+        recibidas_++;
+        return true;
+    }
+
+    bool iniciada_ = false;
+    uint16_t esperada_ = 0;
+    uint32_t vistas_ = 0;         // Números de la ventana ya recibidos
+    uint32_t recibidas_ = 0;
+    uint32_t perdidas_ = 0;
+    uint32_t duplicadas_ = 0;
+    uint32_t desordenadas_ = 0;
+    uint32_t reinicios_ = 0;
+};
+
+}  // namespace trama
@@ -1,44 +1,146 @@
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/adc.h"
+#include "freertos/timers.h"
 #include "driver/gpio.h"
+#include "driver/uart.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_pm.h"                // Sueño ligero automático cuando no hay nada que hacer
+#include "esp_sleep.h"
+#include "comun/adc_continuo.h"   // ADC continuo (DMA) con filtrado en segundo plano
+#include "comun/calibracion_adc.h" // Crudo -> porcentaje con tabla de calibración en punto fijo
 
 #define TOUCH_PIN1 GPIO_NUM_13     // Cambiar el pin táctil a GPIO_NUM_13
 #define TOUCH_PIN2 GPIO_NUM_4      // Mantener el pin táctil 2 en GPIO_NUM_4
-#define ADC_CHANNEL ADC1_CHANNEL_6 // GPIO34 por ejemplo
+#define ADC_CHANNEL ADC_CHANNEL_6  // GPIO34 por ejemplo (canal 6 del ADC1)
+#define ANTIRREBOTE_MS 30          // Tiempo que el nivel debe quedarse quieto tras un cambio
+
+static adc_continuo_t adc;         // Muestreo continuo y filtrado del canal
+static calibracion_adc_t porcentajeAdc; // Tabla crudo -> porcentaje (se construye al arrancar)
+
+// Curva del ADC a 11 dB y del canal: porcentaje lineal en voltaje sobre la ventana útil
+static const punto_calibracion_t CURVA_ADC[] = ADC_11DB_TIPICA;
+static const punto_calibracion_t CURVA_PORCENTAJE[] = {{ADC_11DB_MIN_MV, 0}, {ADC_11DB_MAX_MV, 100}};
+
+// Pines que se atienden por interrupción; bit i de botonesPresionados = BOTONES[i]
+static const gpio_num_t BOTONES[] = {TOUCH_PIN1, TOUCH_PIN2};
+#define NUM_BOTONES (sizeof(BOTONES) / sizeof(BOTONES[0]))
+
+static TaskHandle_t tareaPrincipal;            // La de app_main: duerme hasta que cambian los botones
+static TimerHandle_t temporizadorAntirrebote;
+static volatile uint32_t botonesPresionados = 0; // Estado ya filtrado (lo escribe el antirrebote)
+static uint32_t interrupciones = 0;              // ISR atendidas (estadística)
+static uint32_t despertares = 0;                 // Veces que la tarea principal salió del reposo
+
+// -----------------------------------------------------------------------------
+// Arma la interrupción del pin para el nivel contrario al actual. Es de nivel y no
+// de flanco porque así también despierta al chip del sueño ligero.
+// -----------------------------------------------------------------------------
+static void armarBoton(gpio_num_t pin, int nivel)
+{
+    gpio_wakeup_enable(pin, nivel ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    gpio_intr_enable(pin);
+}
+
+// -----------------------------------------------------------------------------
+// ISR de los botones: apaga la interrupción del pin (los rebotes ya no generan
+// más) y deja que el temporizador confirme el nivel cuando se estabilice
+// -----------------------------------------------------------------------------
+static void IRAM_ATTR isrBoton(void *arg)
+{
+    gpio_intr_disable((gpio_num_t)(uintptr_t)arg);
+    interrupciones++;
+    BaseType_t despertar = pdFALSE;
+    xTimerResetFromISR(temporizadorAntirrebote, &despertar);
+    portYIELD_FROM_ISR(despertar);
+}
+
+// -----------------------------------------------------------------------------
+// Antirrebote: lee el nivel estable, rearma los pines y avisa a la tarea si cambió
+// -----------------------------------------------------------------------------
+static void antirrebote(TimerHandle_t temporizador)
+{
+    (void)temporizador;
+    uint32_t presionados = 0;
+    for (size_t i = 0; i < NUM_BOTONES; i++) {
+        int nivel = gpio_get_level(BOTONES[i]);
+        if (nivel == 0) presionados |= 1u << i;
+        armarBoton(BOTONES[i], nivel);
+    }
+    if (presionados != botonesPresionados) {
+        botonesPresionados = presionados;
+        xTaskNotifyGive(tareaPrincipal);
+    }
+}
 
 void app_main(void)
 {
-    // Configurar ADC (canal 6 corresponde a GPIO34 en ESP32)
-    adc1_config_width(ADC_WIDTH_BIT_12);
-    adc1_config_channel_atten(ADC_CHANNEL, ADC_ATTEN_DB_11);
+    // Configurar ADC en modo continuo (canal 6 corresponde a GPIO34 en ESP32).
+    // Solo se muestrea mientras se toma una lectura: en reposo el DMA queda detenido.
+    adc_continuo_iniciar(&adc, ADC_CHANNEL);
+    adc_continuo_pausar(&adc);
+    calibracion_construir(&porcentajeAdc, CURVA_ADC, sizeof(CURVA_ADC) / sizeof(CURVA_ADC[0]),
+                          CURVA_PORCENTAJE, sizeof(CURVA_PORCENTAJE) / sizeof(CURVA_PORCENTAJE[0]));
 
-    // Configurar pines táctiles como entrada
-    gpio_set_direction(TOUCH_PIN1, GPIO_MODE_INPUT);
-    gpio_set_direction(TOUCH_PIN2, GPIO_MODE_INPUT);
+    // Configurar pines táctiles como entrada con interrupción (se arman más abajo)
+    tareaPrincipal = xTaskGetCurrentTaskHandle();
+    temporizadorAntirrebote = xTimerCreate("antirrebote", pdMS_TO_TICKS(ANTIRREBOTE_MS), pdFALSE, NULL, antirrebote);
+    gpio_config_t config_botones = {
+        .pin_bit_mask = (1ULL << TOUCH_PIN1) | (1ULL << TOUCH_PIN2),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&config_botones);
+    gpio_install_isr_service(0);
+    for (size_t i = 0; i < NUM_BOTONES; i++) {
+        gpio_isr_handler_add(BOTONES[i], isrBoton, (void *)(uintptr_t)BOTONES[i]);
+    }
 
     // Mensaje inicial por serial
     printf("\n--- Sistema iniciado ---\n");
     printf("Escribe '1' y presiona Enter para comenzar:\n");
 
-    // Esperar que llegue '1' por serial
+    // Esperar que llegue '1' por serial: la tarea queda bloqueada en el driver de la
+    // UART y la interrupción de recepción la despierta
+    uart_driver_install(UART_NUM_0, 256, 0, 0, NULL, 0);
     char c = 0;
     while (c != '1') {
-        int r = scanf("%c", &c);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        uart_read_bytes(UART_NUM_0, &c, 1, portMAX_DELAY);
     }
 
+    // Desde aquí el chip entra en sueño ligero cuando todas las tareas esperan.
+    // Antes no, porque en sueño ligero la UART pierde lo que llega.
+    // Requiere CONFIG_PM_ENABLE y CONFIG_FREERTOS_USE_TICKLESS_IDLE en sdkconfig.
+    esp_pm_config_t energia = {
+        .max_freq_mhz = 240,
+        .min_freq_mhz = 40,
+        .light_sleep_enable = true,
+    };
+    esp_pm_configure(&energia);
+    esp_sleep_enable_gpio_wakeup();
+
+    // El primer antirrebote arma los pines y reporta si ya hay alguno presionado
+    xTimerStart(temporizadorAntirrebote, 0);
+
     while (1) {
-        // Verificar si se ha presionado algún pin táctil
-        if (gpio_get_level(TOUCH_PIN1) == 0 || gpio_get_level(TOUCH_PIN2) == 0) {
-            int adc_val = adc1_get_raw(ADC_CHANNEL);
-            float porcentaje = (adc_val / 4095.0) * 100.0;
+        // Sin botones presionados la tarea no usa CPU: espera el aviso del antirrebote
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        despertares++;
+        if (botonesPresionados == 0) continue;  // Fue una liberación: nada que medir
+
+        while (botonesPresionados != 0) {
+            adc_continuo_reanudar(&adc);
+            int adc_val = adc_continuo_valor(&adc);  // Valor filtrado y asentado
+            adc_continuo_pausar(&adc);
+            int32_t centesimas = calibracion_centesimas(&porcentajeAdc, adc_val);  // Porcentaje en punto fijo
 
-            printf("ADC: %d - Porcentaje: %.2f%%\n", adc_val, porcentaje);
+            printf("ADC: %d - Porcentaje: %ld.%02ld%%\n", adc_val, (long)(centesimas / 100), (long)(centesimas % 100));
             vTaskDelay(1000 / portTICK_PERIOD_MS); // Esperar 1 segundo
         }
+        printf("En reposo (%lu interrupciones, %lu despertares)\n",
+               (unsigned long)interrupciones, (unsigned long)despertares);
     }
 }
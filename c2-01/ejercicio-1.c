@@ -10,21 +10,96 @@ Enunciado:
 
 
 #include <stdio.h>              // Para funciones de entrada/salida estándar como printf
-#include <string.h>             // Para funciones de manejo de cadenas (strlen, strcmp, strtok)
-#include <stdlib.h>             // Para atoi y otras funciones útiles
+#include <string.h>             // Para funciones de manejo de cadenas
+#include <math.h>               // Para sqrt (desviación estándar)
 #include "freertos/FreeRTOS.h"  // Para usar FreeRTOS (sistema operativo del ESP32)
 #include "freertos/task.h"      // Para crear tareas y usar delays
+#include "freertos/queue.h"     // Para la cola de eventos del driver UART
 #include "driver/uart.h"        // Para configurar y usar el puerto UART (comunicación serial)
+#include "lineas_numeros.h"     // Armado de líneas entre lecturas y lectura de números
+#include "estadisticas_flujo.h" // Mínimo, máximo, media, varianza y percentiles en O(1) por dato
 
-// Tamaño del buffer de entrada serial
+// Velocidad de la UART: a 921600 baudios llegan ~92 KB/s (una línea cada ~30 us)
+#define BAUDIOS 921600
+
+// Tamaño del bloque que se lee de una vez y del buffer de recepción del driver.
+// El driver absorbe ~44 ms de datos mientras la tarea imprime o está desalojada.
 #define BUF_SIZE 1024
+#define RX_BUF_SIZE 4096
+#define TAM_COLA_UART 32
+
+// El resumen se imprime cuando la entrada hace una pausa (al terminar de escribir una
+// línea a mano o al final de una ráfaga) y, durante un flujo continuo, una vez por
+// segundo: imprimir por cada línea saturaría la propia UART de salida.
+#define PAUSA_REPORTE_MS 20
+#define PERIODO_REPORTE_MS 1000
+
+static QueueHandle_t colaUart;      // Eventos del driver (datos, desbordes)
+static lineas_t lineas;             // Línea a medio llegar entre lecturas
+static estadisticas_t estadisticas; // Estadísticas de los números válidos
+
+// Contadores desde el último resumen
+static uint32_t validos = 0;
+static uint32_t invalidos = 0;
+static uint32_t desbordes = 0;
+
+// -----------------------------------------------------------------------------
+// Valida una línea y la agrega a las estadísticas
+// -----------------------------------------------------------------------------
+static void procesarLinea(const linea_t *linea)
+{
+    int32_t numero;
+    // Validación completa: debe ser un número limpio (como lo imprimiría "%d") entre 0 y 99
+    if (!linea->desbordada && numero_leer(linea->texto, linea->largo, &numero) &&
+        numero >= 0 && numero <= 99) {
+        estadisticas_agregar(&estadisticas, numero);
+        validos++;
+    } else {
+        invalidos++;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Procesa todas las líneas de un bloque; lo que quede abierto se completa en la
+// próxima lectura
+// -----------------------------------------------------------------------------
+static void procesarBloque(const uint8_t *datos, size_t n)
+{
+    linea_t linea;
+    size_t i = 0;
+    while (i < n) {
+        i += lineas_agregar(&lineas, datos + i, n - i, &linea);
+        if (linea.texto != NULL) procesarLinea(&linea);
+    }
+}
 
-// Variables globales para estadísticas
-int minimo = 100;       // Valor mínimo ingresado (inicializado en 100 para que cualquier número menor lo reemplace)
-int maximo = -1;        // Valor máximo ingresado (inicializado en -1 para que cualquier número mayor lo reemplace)
-int ultimo = 0;         // Último número válido ingresado
-int suma = 0;           // Suma total de los números válidos
-int cantidad = 0;       // Cantidad de números válidos ingresados
+// -----------------------------------------------------------------------------
+// Imprime el resumen de lo recibido desde el anterior
+// -----------------------------------------------------------------------------
+static void reportar(void)
+{
+    if (desbordes > 0) {
+        printf("Se perdieron datos: %lu desbordes del buffer de recepción.\n", (unsigned long)desbordes);
+    }
+    if (invalidos == 1) {
+        printf("Número inválido. Ingrese un número entre 0 y 99.\n");
+    } else if (invalidos > 1) {
+        printf("%lu números inválidos. Ingrese números entre 0 y 99.\n", (unsigned long)invalidos);
+    }
+    if (validos > 0) {
+        printf("Último: %ld. Mínimo: %ld. Máximo: %ld. Promedio: %.2f\n",
+               (long)estadisticas.ultimo, (long)estadisticas.minimo, (long)estadisticas.maximo,
+               estadisticas_media(&estadisticas));
+        if (estadisticas.cantidad > 1) {
+            printf("Cantidad: %llu. Desviación: %.2f. P50: %ld. P90: %ld. P99: %ld\n",
+                   (unsigned long long)estadisticas.cantidad, sqrt(estadisticas_varianza(&estadisticas)),
+                   (long)estadisticas_percentil(&estadisticas, 50),
+                   (long)estadisticas_percentil(&estadisticas, 90),
+                   (long)estadisticas_percentil(&estadisticas, 99));
+        }
+    }
+    validos = invalidos = desbordes = 0;
+}
 
 // Función principal del programa en ESP-IDF
 void app_main(void) {
@@ -32,15 +107,18 @@ void app_main(void) {
 
     // Configura los parámetros de la comunicación UART
     uart_config_t uart_config = {
-        .baud_rate = 115200,                      // Velocidad de transmisión (baudios)
+        .baud_rate = BAUDIOS,                     // Velocidad de transmisión (baudios)
         .data_bits = UART_DATA_8_BITS,            // 8 bits de datos por byte
         .parity    = UART_PARITY_DISABLE,         // Sin bit de paridad
         .stop_bits = UART_STOP_BITS_1,            // 1 bit de parada
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE     // Sin control de flujo
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,    // Sin control de flujo
+        .rx_flow_ctrl_thresh = 0,                 // Umbral de RTS: no aplica sin control de flujo
+        .source_clk = UART_SCLK_DEFAULT           // Reloj por defecto (APB)
     };
 
-    // Instala el driver UART con un buffer de recepción
-    uart_driver_install(uart_num, BUF_SIZE, 0, 0, NULL, 0);
+    // Instala el driver UART con un buffer de recepción y una cola de eventos: la tarea
+    // duerme en la cola y la interrupción de recepción la despierta cuando hay datos
+    uart_driver_install(uart_num, RX_BUF_SIZE, 0, TAM_COLA_UART, &colaUart, 0);
 
     // Aplica la configuración UART
     uart_param_config(uart_num, &uart_config);
@@ -49,55 +127,58 @@ void app_main(void) {
     uart_set_pin(uart_num, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
                  UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
 
+    lineas_iniciar(&lineas);
+    estadisticas_iniciar(&estadisticas);
+
     // Mensaje inicial por consola
     printf("Esperando datos entre 0 y 99...\n");
 
-    // Buffer donde se guardará la entrada serial
-    uint8_t data[BUF_SIZE];
+    // Buffer donde se copia cada bloque leído
+    static uint8_t data[BUF_SIZE];
+    TickType_t ultimoReporte = xTaskGetTickCount();
 
     // Bucle infinito (típico en microcontroladores)
     while (1) {
-        // Leer bytes desde UART (con timeout de 1 segundo)
-        int len = uart_read_bytes(uart_num, data, BUF_SIZE - 1, pdMS_TO_TICKS(1000));
-
-        if (len > 0) {
-            data[len] = '\0'; // Agrega terminador nulo para que sea una cadena válida
-
-            // Extrae la primera línea (remueve saltos de línea y retorno de carro)
-            char *entrada = strtok((char *)data, "\r\n");
-
-            // Si la entrada es vacía, no hacer nada
-            if (entrada == NULL || strlen(entrada) == 0) continue;
-
-            // Convierte la entrada a entero
-            int numero = atoi(entrada);
-
-            // Convierte el número de vuelta a string para validar que fue un número limpio
-            char numero_str[16];
-            sprintf(numero_str, "%d", numero);
-
-            // Validación completa: debe estar entre 0 y 99, y debe coincidir exactamente con la entrada
-            if (numero >= 0 && numero <= 99 && strcmp(numero_str, entrada) == 0) {
-                // Si es válido, actualizar estadísticas
-                ultimo = numero;
-                if (numero < minimo) minimo = numero;
-                if (numero > maximo) maximo = numero;
-                suma += numero;
-                cantidad++;
-
-                // Calcular promedio
-                float promedio = (float)suma / cantidad;
-
-                // Imprimir resultados
-                printf("Último: %d. Mínimo: %d. Máximo: %d. Promedio: %.2f\n",
-                       ultimo, minimo, maximo, promedio);
-            } else {
-                // Si la entrada no es válida, mostrar error
-                printf("Número inválido. Ingrese un número entre 0 y 99.\n");
+        // Con datos sin reportar se espera solo hasta que la entrada haga una pausa
+        bool pendiente = validos > 0 || invalidos > 0 || desbordes > 0;
+        uart_event_t evento;
+        if (xQueueReceive(colaUart, &evento, pendiente ? pdMS_TO_TICKS(PAUSA_REPORTE_MS) : portMAX_DELAY) != pdTRUE) {
+            reportar();
+            ultimoReporte = xTaskGetTickCount();
+            continue;
+        }
+
+        switch (evento.type) {
+        case UART_DATA: {
+            // Se vacía todo lo que hay en el buffer, no solo lo que anunció el evento:
+            // los eventos siguientes encuentran poco o nada y cuestan solo la consulta
+            size_t disponibles = 0;
+            uart_get_buffered_data_len(uart_num, &disponibles);
+            while (disponibles > 0) {
+                size_t pedir = disponibles < BUF_SIZE ? disponibles : BUF_SIZE;
+                int len = uart_read_bytes(uart_num, data, pedir, 0);
+                if (len <= 0) break;
+                procesarBloque(data, (size_t)len);
+                disponibles -= (size_t)len;
             }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // Se perdieron bytes: se descarta lo acumulado y se resincroniza en el
+            // próximo fin de línea para no tomar pedazos de dos líneas como un número
+            uart_flush_input(uart_num);
+            xQueueReset(colaUart);
+            lineas_descartar(&lineas);
+            desbordes++;
+            break;
+        default:
+            break;
         }
 
-        // Esperar 100 ms antes de volver a leer
-        vTaskDelay(pdMS_TO_TICKS(100));
+        if (xTaskGetTickCount() - ultimoReporte >= pdMS_TO_TICKS(PERIODO_REPORTE_MS)) {
+            reportar();
+            ultimoReporte = xTaskGetTickCount();
+        }
     }
 }
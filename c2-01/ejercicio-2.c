@@ -13,15 +13,20 @@ Enunciado:
 #include <stdlib.h>     // Librería para funciones como atoi(), abs()
 #include <string.h>     // Para manejo de strings como strcpy, strcat, etc.
 #include <ctype.h>      // Para funciones de validación de caracteres como isdigit()
+#include <errno.h>      // Para detectar números fuera de rango en strtol()
+#include <stdint.h>     // Para enteros de 64 bits
 
 // Librerías de ESP-IDF
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/uart.h"
+#include "esp_timer.h"
+#include "serie_impares.h"  // Serie de impares en flujo, escrita por bloques
 
 // Definiciones de configuración de UART
 #define UART_PORT UART_NUM_0     // Usamos el puerto UART0
 #define BUF_SIZE 128             // Tamaño del buffer de recepción
+#define TERMINOS_INFORME 1000    // Desde cuántos términos se informa el tamaño y la duración
 
 // -----------------------------------------------------------------------------
 // Función que verifica si una cadena representa un número entero válido
@@ -40,33 +45,33 @@ bool is_integer(const char *str) {
 }
 
 // -----------------------------------------------------------------------------
-// Función que calcula el cuadrado de un número N sumando los N primeros impares
-// También genera una cadena de texto con la serie, por ejemplo: "1+3+5+...=N*N"
+// Función de escritura de la salida por bloques: cada bloque lleno va a la UART
 // -----------------------------------------------------------------------------
-int square_with_series(int n, char *series, size_t size) {
-    int sum = 0;
-    int odd = 1;  // El primer número impar es 1
-    int count = abs(n);  // Usamos valor absoluto por si el usuario ingresa negativo
-    char temp[16];       // Buffer temporal para ir armando la serie
-
-    series[0] = '\0';    // Inicializa la cadena vacía
-
-    for (int i = 0; i < count; i++) {
-        sum += odd;      // Suma el número impar actual
-
-        // Convierte el impar actual a texto y lo agrega a la serie
-        snprintf(temp, sizeof(temp), "%d", odd);
-        strncat(series, temp, size - strlen(series) - 1);
-
-        // Agrega el signo '+' si no es el último número
-        if (i < count - 1) {
-            strncat(series, "+", size - strlen(series) - 1);
-        }
-
-        odd += 2;  // El siguiente impar es 2 unidades mayor
-    }
+static void escribir_uart(void *contexto, const char *datos, size_t n) {
+    (void)contexto;
+    uart_write_bytes(UART_PORT, datos, n);
+}
 
-    return sum;  // Devuelve el resultado de la suma (cuadrado de N)
+// -----------------------------------------------------------------------------
+// Función que calcula el cuadrado de un número N sumando los N primeros impares
+// y envía la respuesta con la serie completa: "Cuadrado de N = 1+3+5+... = N*N".
+// La serie no se guarda en memoria: sale por la UART a medida que se genera, así
+// que no hay límite de largo. Devuelve la suma (se verifica contra N*N).
+// -----------------------------------------------------------------------------
+uint64_t square_with_series(long n, salida_bloques_t *salida) {
+    // Valor absoluto por si el usuario ingresa negativo (sin desbordar con el mínimo)
+    uint32_t count = n < 0 ? 0u - (uint32_t)n : (uint32_t)n;
+    char encabezado[32];
+    snprintf(encabezado, sizeof(encabezado), "Cuadrado de %ld = ", n);
+    salida_texto(salida, encabezado);
+
+    uint64_t sum = serie_impares(salida, count);
+
+    salida_texto(salida, " = ");
+    salida_entero(salida, sum);
+    salida_texto(salida, "\n");
+    salida_vaciar(salida);
+    return sum;
 }
 
 // -----------------------------------------------------------------------------
@@ -79,7 +84,9 @@ void app_main(void) {
         .data_bits = UART_DATA_8_BITS,            // 8 bits de datos
         .parity    = UART_PARITY_DISABLE,         // Sin bit de paridad
         .stop_bits = UART_STOP_BITS_1,            // 1 bit de parada
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE     // Sin control de flujo
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,    // Sin control de flujo
+        .rx_flow_ctrl_thresh = 0,                 // Umbral de RTS: no aplica sin control de flujo
+        .source_clk = UART_SCLK_DEFAULT           // Reloj por defecto (APB)
     };
 
     // Inicializa el controlador UART
@@ -91,7 +98,7 @@ void app_main(void) {
                  UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
 
     char buffer[BUF_SIZE];       // Buffer para almacenar lo leído por UART
-    char series[256];            // Para almacenar la serie de impares
+    salida_bloques_t salida;     // Bloque de salida de la serie (memoria fija)
 
     // Mensaje inicial que se envía al usuario
     const char *msg = "Ingresa un número entero para calcular su cuadrado como suma de impares:\n";
@@ -112,18 +119,32 @@ void app_main(void) {
 
             // Verifica si la entrada es un número entero válido
             if (is_integer(buffer)) {
-                int n = atoi(buffer);  // Convierte string a entero
-
-                // Calcula el cuadrado usando suma de impares y genera serie
-                int result = square_with_series(n, series, sizeof(series));
-
-                // Prepara el mensaje de salida con formato
-                char response[512];
-                snprintf(response, sizeof(response),
-                         "Cuadrado de %d = %s = %d\n", n, series, result);
-
-                // Envía el resultado por UART
-                uart_write_bytes(UART_PORT, response, strlen(response));
+                errno = 0;
+                long n = strtol(buffer, NULL, 10);  // Convierte string a entero
+
+                if (errno == ERANGE || n < INT32_MIN || n > INT32_MAX) {
+                    const char *err = "Número fuera de rango. Ingresa un número de hasta 32 bits.\n";
+                    uart_write_bytes(UART_PORT, err, strlen(err));
+                } else {
+                    // Calcula el cuadrado usando suma de impares y envía la serie por bloques
+                    int64_t inicio = esp_timer_get_time();
+                    salida_iniciar(&salida, escribir_uart, NULL);
+                    uint64_t result = square_with_series(n, &salida);
+                    int64_t duracion = esp_timer_get_time() - inicio;
+
+                    // Verificación con la forma cerrada N*N
+                    uint32_t count = n < 0 ? 0u - (uint32_t)n : (uint32_t)n;
+                    char informe[128];
+                    if (result != serie_cuadrado(count)) {
+                        snprintf(informe, sizeof(informe), "Error: la suma no coincide con N*N = %llu\n",
+                                 (unsigned long long)serie_cuadrado(count));
+                        uart_write_bytes(UART_PORT, informe, strlen(informe));
+                    } else if (count >= TERMINOS_INFORME) {
+                        snprintf(informe, sizeof(informe), "(%lu términos, verificado con N*N: %llu bytes en %lld ms)\n",
+                                 (unsigned long)count, (unsigned long long)salida.bytes, (long long)(duracion / 1000));
+                        uart_write_bytes(UART_PORT, informe, strlen(informe));
+                    }
+                }
             } else {
                 // Mensaje de error si la entrada no es un número entero
                 const char *err = "Entrada inválida. Por favor ingresa un número entero.\n";
@@ -13,9 +13,13 @@ Enunciado:
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"      // Temporizador que sigue los toques en curso
 #include "driver/touch_pad.h"     // Manejo de pines táctiles
 #include "esp_log.h"              // Para imprimir mensajes por consola
 #include "esp_timer.h"            // Para obtener tiempos de duración de los toques
+#include "esp_pm.h"               // Sueño ligero automático mientras no se toca nada
+#include "esp_sleep.h"
+#include "secuencia_toques.h"  // Reconocedor de la secuencia por tabla de transiciones
 
 // Pines táctiles definidos
 #define TOUCH_PIN      TOUCH_PAD_NUM0  // Pin táctil principal para ingresar la secuencia (GPIO 4)
@@ -28,31 +32,66 @@ Enunciado:
 // Umbral de lectura que indica si se ha tocado el pin táctil
 #define UMBRAL_TOQUE   120
 
+// Mientras hay un pad tocado se revisa su lectura con este periodo; el toque termina
+// tras LECTURAS_SOLTAR lecturas seguidas sobre el umbral (antirrebote de la liberación)
+#define SEGUIMIENTO_MS  50
+#define LECTURAS_SOLTAR 2
+
+// Eventos que la interrupción y el temporizador envían a la tarea (bits de la notificación)
+#define EVENTO_INICIO_TOQUE (1u << 0)   // Empezó un toque en TOUCH_PIN (marca en presionMs)
+#define EVENTO_FIN_TOQUE    (1u << 1)   // Terminó un toque en TOUCH_PIN (marca en liberacionMs)
+#define EVENTO_VALIDAR      (1u << 2)   // Empezó un toque en VALIDAR_PIN
+
 // Tag para los logs de ESP-IDF
 static const char *TAG = "TOQUE";
 
-// Secuencia esperada: {toques largos, toques cortos, toques largos}
-int secuenciaEsperada[] = {3, 1, 3}; // 3 -> largo, 1 -> corto
-int estado = 0;                      // Indica en qué parte de la secuencia estamos (0 a 2)
-int conteoToques = 0;                // Cuenta cuántos toques válidos se han hecho en el estado actual
-
-// Variables para manejar detección de toques
-bool tocando = false;
-int64_t tiempoInicio = 0;
+// Secuencia esperada: 3 toques largos, 3 cortos y 3 largos. Para cambiarla basta
+// con editar esta tabla; app_main la compila en la tabla de transiciones.
+static const grupo_toques_t SECUENCIA_ESPERADA[] = {
+    {3, TOQUE_LARGO},
+    {3, TOQUE_CORTO},
+    {3, TOQUE_LARGO},
+};
+static tabla_secuencia_t tablaSecuencia;
+static reconocedor_toques_t reconocedor;
+
+// Mensaje de cada tipo de toque (índice tipo_toque_t)
+static const char *const MENSAJE_TOQUE[NUM_TIPOS_TOQUE] = {
+    "Toque inválido (muy corto)",
+    "Toque corto detectado",
+    "Toque largo detectado",
+};
+
+// Pads atendidos; el índice en este arreglo es el de inicioToque[] y lecturasSobre[]
+static const touch_pad_t PADS[] = {TOUCH_PIN, VALIDAR_PIN};
+#define NUM_PADS (sizeof(PADS) / sizeof(PADS[0]))
+
+// Variables para manejar detección de toques (las escriben la ISR y el temporizador)
+static TaskHandle_t tareaToques;                 // La de app_main: duerme hasta recibir un evento
+static TimerHandle_t temporizadorSeguimiento;
+static uint32_t padsTocados = 0;                 // Bit por número de pad con un toque en curso
+static int64_t inicioToque[NUM_PADS];            // esp_timer_get_time() al empezar el toque (us)
+static int64_t finToque[NUM_PADS];               // Primera lectura sobre el umbral (us)
+static uint8_t lecturasSobre[NUM_PADS];          // Lecturas seguidas sobre el umbral
+static volatile uint32_t presionMs = 0;          // Marcas del último toque en TOUCH_PIN (ms)
+static volatile uint32_t liberacionMs = 0;
+
+// Estadísticas de reposo
+static uint32_t interrupciones = 0;              // ISR táctiles atendidas
+static uint32_t revisiones = 0;                  // Veces que corrió el temporizador
 
 // -----------------------------------------------------------------------------
 // Reinicia la secuencia al estado inicial
 // -----------------------------------------------------------------------------
 void resetearSecuencia() {
-    estado = 0;
-    conteoToques = 0;
+    secuencia_reiniciar(&reconocedor);
 }
 
 // -----------------------------------------------------------------------------
 // Valida si la secuencia ingresada es la correcta
 // -----------------------------------------------------------------------------
 void validarSecuencia() {
-    if (estado == 3) {
+    if (secuencia_completa(&reconocedor)) {
         ESP_LOGI(TAG, "APROBADO");  // Secuencia correcta
     } else {
         ESP_LOGI(TAG, "NO APROBADO");  // Secuencia incorrecta
@@ -60,85 +99,152 @@ void validarSecuencia() {
 }
 
 // -----------------------------------------------------------------------------
-// Registra un toque (tipo: 3 = largo, 1 = corto)
-// Verifica si es parte correcta de la secuencia
+// Pasa un evento del pin principal al reconocedor y reporta el toque terminado
 // -----------------------------------------------------------------------------
-void registrarToque(int tipoToque) {
-    if (estado < 3) {
-        // Si el toque es del tipo correcto para la etapa actual
-        if (tipoToque == secuenciaEsperada[estado]) {
-            conteoToques++;  // Se registra el toque
-
-            // Avanza al siguiente estado si ya se hicieron 3 toques válidos
-            if ((estado == 0 || estado == 2) && conteoToques == 3 && tipoToque == 3) {
-                estado++;
-                conteoToques = 0;
-            } else if (estado == 1 && conteoToques == 3 && tipoToque == 1) {
-                estado++;
-                conteoToques = 0;
-            }
+void registrarEvento(uint8_t tipo, uint32_t t_ms) {
+    evento_toque_t ev = {t_ms, tipo};
+    resultado_toque_t res = secuencia_evento(&reconocedor, ev);
+    if (tipo != TOQUE_LIBERACION) return;
+
+    ESP_LOGI(TAG, "%s", MENSAJE_TOQUE[res.tipo]);
+    if (res.reinicio) {
+        // Si el toque no corresponde con lo esperado, se reinicia
+        ESP_LOGI(TAG, "Secuencia incorrecta, reiniciando...");
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Interrupción táctil: la FSM midió una lectura bajo el umbral. El ESP32 solo
+// interrumpe al tocar (no al soltar) y lo hace en cada medición mientras dure el
+// toque, así que se apaga la interrupción y el temporizador sigue el toque.
+// -----------------------------------------------------------------------------
+static void IRAM_ATTR isrToque(void *arg) {
+    (void)arg;
+    uint32_t estado = touch_pad_get_status();
+    touch_pad_clear_status();
+    touch_pad_intr_disable();
+    interrupciones++;
+
+    BaseType_t despertar = pdFALSE;
+    int64_t ahora = esp_timer_get_time();
+    for (size_t i = 0; i < NUM_PADS; i++) {
+        uint32_t bit = 1u << PADS[i];
+        if (!(estado & bit) || (padsTocados & bit)) continue;
+        padsTocados |= bit;
+        inicioToque[i] = ahora;
+        lecturasSobre[i] = 0;
+        if (PADS[i] == TOUCH_PIN) {
+            presionMs = (uint32_t)(ahora / 1000);
+            xTaskNotifyFromISR(tareaToques, EVENTO_INICIO_TOQUE, eSetBits, &despertar);
         } else {
-            // Si el toque no corresponde con lo esperado, se reinicia
-            estado = 0;
-            conteoToques = 0;
-            ESP_LOGI(TAG, "Secuencia incorrecta, reiniciando...");
+            xTaskNotifyFromISR(tareaToques, EVENTO_VALIDAR, eSetBits, &despertar);
+        }
+    }
+    xTimerStartFromISR(temporizadorSeguimiento, &despertar);
+    portYIELD_FROM_ISR(despertar);
+}
+
+// -----------------------------------------------------------------------------
+// Seguimiento de los toques en curso (solo corre mientras haya alguno): detecta
+// la liberación con antirrebote y los toques que empiecen con la interrupción
+// apagada. Cuando no queda ningún pad tocado vuelve a la interrupción.
+// -----------------------------------------------------------------------------
+static void seguirToques(TimerHandle_t temporizador) {
+    revisiones++;
+    int64_t ahora = esp_timer_get_time();
+
+    for (size_t i = 0; i < NUM_PADS; i++) {
+        uint32_t bit = 1u << PADS[i];
+        uint16_t lectura = 0;
+        touch_pad_read_raw_data(PADS[i], &lectura);  // Última medición de la FSM, sin esperar
+
+        if (lectura < UMBRAL_TOQUE) {
+            lecturasSobre[i] = 0;
+            if (!(padsTocados & bit)) {
+                padsTocados |= bit;
+                inicioToque[i] = ahora;
+                if (PADS[i] == TOUCH_PIN) {
+                    presionMs = (uint32_t)(ahora / 1000);
+                    xTaskNotify(tareaToques, EVENTO_INICIO_TOQUE, eSetBits);
+                } else {
+                    xTaskNotify(tareaToques, EVENTO_VALIDAR, eSetBits);
+                }
+            }
+        } else if (padsTocados & bit) {
+            if (lecturasSobre[i]++ == 0) finToque[i] = ahora;
+            if (lecturasSobre[i] < LECTURAS_SOLTAR) continue;
+
+            padsTocados &= ~bit;
+            if (PADS[i] == TOUCH_PIN) {
+                liberacionMs = (uint32_t)(finToque[i] / 1000);
+                xTaskNotify(tareaToques, EVENTO_FIN_TOQUE, eSetBits);
+            }
         }
     }
+
+    if (padsTocados == 0) {
+        xTimerStop(temporizador, 0);
+        touch_pad_intr_enable();
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Función principal (app_main), punto de entrada en ESP-IDF
 // -----------------------------------------------------------------------------
 void app_main(void) {
-    // Inicializa los pines táctiles
+    // Compila la secuencia esperada y los umbrales de duración en la tabla de transiciones
+    if (!secuencia_compilar(&tablaSecuencia, SECUENCIA_ESPERADA,
+                            sizeof(SECUENCIA_ESPERADA) / sizeof(SECUENCIA_ESPERADA[0]), TOQUE_CORTO_MS, TOQUE_LARGO_MS)) {
+        // Con la tabla sin compilar el reconocedor no aprobaría nada: no se inicia
+        ESP_LOGE(TAG, "La secuencia esperada no cabe en la tabla de transiciones");
+        return;
+    }
+    secuencia_iniciar(&reconocedor, &tablaSecuencia);
+
+    tareaToques = xTaskGetCurrentTaskHandle();
+    temporizadorSeguimiento = xTimerCreate("toques", pdMS_TO_TICKS(SEGUIMIENTO_MS), pdTRUE, NULL, seguirToques);
+
+    // Inicializa los pines táctiles: la FSM del hardware los mide sola (sin CPU)
+    // e interrumpe cuando alguno baja del umbral
     touch_pad_init();
-    touch_pad_config(TOUCH_PIN, 0);       // Configura pin de entrada principal
-    touch_pad_config(VALIDAR_PIN, 0);     // Configura pin para validación
+    touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+    touch_pad_config(TOUCH_PIN, UMBRAL_TOQUE);    // Configura pin de entrada principal
+    touch_pad_config(VALIDAR_PIN, UMBRAL_TOQUE);  // Configura pin para validación
+    touch_pad_set_trigger_mode(TOUCH_TRIGGER_BELOW);
+    touch_pad_isr_register(isrToque, NULL);
+    touch_pad_intr_enable();
+
+    // Sueño ligero automático cuando la tarea espera; un toque despierta al chip.
+    // Requiere CONFIG_PM_ENABLE y CONFIG_FREERTOS_USE_TICKLESS_IDLE en sdkconfig.
+    esp_sleep_enable_touchpad_wakeup();
+    esp_pm_config_t energia = {
+        .max_freq_mhz = 240,
+        .min_freq_mhz = 40,
+        .light_sleep_enable = true,
+    };
+    esp_pm_configure(&energia);
 
     ESP_LOGI(TAG, "Sistema iniciado. Esperando secuencia...");
 
-    // Bucle principal del sistema
+    // Bucle principal del sistema: sin toques la tarea no usa CPU
     while (1) {
-        uint16_t lecturaToque = 0;
-        uint16_t lecturaValidar = 0;
-
-        // Lee el valor de los sensores táctiles
-        touch_pad_read(TOUCH_PIN, &lecturaToque);
-        touch_pad_read(VALIDAR_PIN, &lecturaValidar);
-
-        // Si se detecta un toque en el pin principal (valor menor al umbral)
-        if (lecturaToque < UMBRAL_TOQUE) {
-            if (!tocando) {
-                tocando = true;
-                tiempoInicio = esp_timer_get_time() / 1000; // Guarda el momento en que inició el toque (ms)
-            }
-        } else {
-            // Cuando se deja de tocar
-            if (tocando) {
-                tocando = false;
-                int64_t duracion = (esp_timer_get_time() / 1000) - tiempoInicio;
-
-                // Determina si fue un toque largo, corto o inválido
-                if (duracion >= TOQUE_LARGO_MS) {
-                    ESP_LOGI(TAG, "Toque largo detectado");
-                    registrarToque(3);  // Registra como toque largo
-                } else if (duracion >= TOQUE_CORTO_MS) {
-                    ESP_LOGI(TAG, "Toque corto detectado");
-                    registrarToque(1);  // Registra como toque corto
-                } else {
-                    ESP_LOGI(TAG, "Toque inválido (muy corto)");
-                }
-            }
+        uint32_t eventos = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &eventos, portMAX_DELAY);
+
+        // Presión antes que liberación: con las dos pendientes, el toque ya terminó
+        if (eventos & EVENTO_INICIO_TOQUE) {
+            registrarEvento(TOQUE_PRESION, presionMs);
+        }
+        if (eventos & EVENTO_FIN_TOQUE) {
+            registrarEvento(TOQUE_LIBERACION, liberacionMs);
         }
 
-        // Si se toca el pin de validación
-        if (lecturaValidar < UMBRAL_TOQUE) {
-            vTaskDelay(300 / portTICK_PERIOD_MS); // Delay antirebote
+        // Si se toca el pin de validación (una vez por toque: no necesita retardo antirrebote)
+        if (eventos & EVENTO_VALIDAR) {
             validarSecuencia();                   // Comprueba si la secuencia ingresada fue correcta
             resetearSecuencia();                  // Reinicia para ingresar una nueva secuencia
+            ESP_LOGI(TAG, "Reposo: %lu interrupciones, %lu revisiones del temporizador",
+                     (unsigned long)interrupciones, (unsigned long)revisiones);
         }
-
-        // Espera corta para evitar uso excesivo del procesador
-        vTaskDelay(50 / portTICK_PERIOD_MS);
     }
 }
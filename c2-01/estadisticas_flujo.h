@@ -0,0 +1,85 @@
+/*
+ * ESTADÍSTICAS EN FLUJO PARA VALORES ENTEROS ACOTADOS
+ *
+ * Mínimo, máximo, media, varianza y percentiles de una secuencia de enteros en
+ * [0, ESTADISTICAS_RANGO) sin guardar las muestras: cada muestra cuesta O(1) y la
+ * memoria es fija. Los acumuladores son de 64 bits, así que no se desbordan en
+ * ninguna corrida realista (con valores < 100, la suma de cuadrados aguanta más
+ * de 10^15 muestras); el int del ejercicio original se desbordaba a los ~21
+ * millones de números.
+ *
+ * Como el dominio tiene solo ESTADISTICAS_RANGO valores, el "resumen" para los
+ * percentiles es un histograma con un contador por valor: ocupa lo mismo que
+ * cualquier sketch aproximado y da el percentil exacto recorriendo 100 casillas.
+ *
+ * C puro (compila como C99 y como C++), sin dependencias del ESP32.
+ */
+
+#ifndef ESTADISTICAS_FLUJO_H
+#define ESTADISTICAS_FLUJO_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define ESTADISTICAS_RANGO 100  // Valores admitidos: 0 .. ESTADISTICAS_RANGO - 1
+
+typedef struct {
+    uint64_t cantidad;
+    uint64_t suma;
+    uint64_t suma_cuadrados;
+    int32_t minimo;
+    int32_t maximo;
+    int32_t ultimo;
+    uint64_t histograma[ESTADISTICAS_RANGO];
+} estadisticas_t;
+
+static inline void estadisticas_iniciar(estadisticas_t *e) {
+    memset(e, 0, sizeof(*e));
+    e->minimo = ESTADISTICAS_RANGO;
+    e->maximo = -1;
+}
+
+// El llamador garantiza 0 <= valor < ESTADISTICAS_RANGO
+static inline void estadisticas_agregar(estadisticas_t *e, int32_t valor) {
+    uint32_t v = (uint32_t)valor;
+    e->cantidad++;
+    e->suma += v;
+    e->suma_cuadrados += (uint64_t)v * v;
+    e->histograma[v]++;
+    e->ultimo = valor;
+    if (valor < e->minimo) e->minimo = valor;
+    if (valor > e->maximo) e->maximo = valor;
+}
+
+static inline double estadisticas_media(const estadisticas_t *e) {
+    return e->cantidad ? (double)e->suma / (double)e->cantidad : 0.0;
+}
+
+// -----------------------------------------------------------------------------
+// Varianza poblacional. E[x^2] - E[x]^2 en doble precisión es exacta hasta ~1e-12
+// con valores < 100: suma_cuadrados / cantidad nunca supera 9801.
+// -----------------------------------------------------------------------------
+static inline double estadisticas_varianza(const estadisticas_t *e) {
+    if (e->cantidad == 0) return 0.0;
+    double media = estadisticas_media(e);
+    double v = (double)e->suma_cuadrados / (double)e->cantidad - media * media;
+    return v > 0.0 ? v : 0.0;
+}
+
+// -----------------------------------------------------------------------------
+// Percentil p (0-100) por rango más cercano: el menor valor que deja al menos el
+// p % de las muestras a su izquierda (inclusive). -1 si no hay muestras.
+// -----------------------------------------------------------------------------
+static inline int32_t estadisticas_percentil(const estadisticas_t *e, uint32_t p) {
+    if (e->cantidad == 0) return -1;
+    uint64_t rango = ((uint64_t)p * e->cantidad + 99) / 100;
+    if (rango == 0) rango = 1;
+    uint64_t acumulado = 0;
+    for (int32_t v = 0; v < ESTADISTICAS_RANGO; v++) {
+        acumulado += e->histograma[v];
+        if (acumulado >= rango) return v;
+    }
+    return e->maximo;
+}
+
+#endif // ESTADISTICAS_FLUJO_H
@@ -0,0 +1,145 @@
+/*
+ * ARMADO INCREMENTAL DE LÍNEAS Y LECTURA DE NÚMEROS SIN MEMORIA DINÁMICA
+ *
+ * La UART entrega bloques de bytes que no respetan los fines de línea: un bloque
+ * puede traer varias líneas, una línea puede llegar partida en dos lecturas, y un
+ * "\r\n" puede quedar repartido entre ambas. lineas_agregar() recorre el bloque y
+ * devuelve las líneas completas de a una; si la línea está entera dentro del
+ * bloque la devuelve apuntando al bloque mismo (sin copiar) y solo los pedazos que
+ * quedan abiertos entre lecturas se guardan en un buffer fijo.
+ *
+ * numero_leer() reemplaza al atoi() + sprintf() + strcmp() del ejercicio: acepta
+ * exactamente las cadenas que sprintf("%d") produciría (sin espacios, sin ceros a
+ * la izquierda, sin "+", sin "-0") y rechaza las que no caben en 32 bits, en una
+ * sola pasada y sin buffers auxiliares.
+ *
+ * C puro (compila como C99 y como C++), sin dependencias del ESP32.
+ */
+
+#ifndef LINEAS_NUMEROS_H
+#define LINEAS_NUMEROS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LINEA_MAX 32    // Más larga que cualquier número de 32 bits; las más largas se marcan
+
+// Una línea completa, sin su fin de línea. 'texto' vale hasta la próxima llamada.
+typedef struct {
+    const char *texto;
+    size_t largo;
+    bool desbordada;    // Tenía más de LINEA_MAX bytes: 'texto' trae solo el comienzo
+} linea_t;
+
+typedef struct {
+    char buf[LINEA_MAX];
+    size_t largo;       // Bytes de la línea abierta guardados en buf
+    bool desbordada;
+    bool descartando;   // Tras una pérdida de datos: se ignora todo hasta el próximo fin de línea
+} lineas_t;
+
+static inline void lineas_iniciar(lineas_t *l) {
+    l->largo = 0;
+    l->desbordada = false;
+    l->descartando = false;
+}
+
+// -----------------------------------------------------------------------------
+// Se perdieron bytes (desborde del driver): la línea abierta ya no es confiable y
+// la próxima empieza en algún punto desconocido, así que ambas se descartan
+// -----------------------------------------------------------------------------
+static inline void lineas_descartar(lineas_t *l) {
+    lineas_iniciar(l);
+    l->descartando = true;
+}
+
+static inline bool lineas_es_fin(uint8_t c) {
+    return c == '\n' || c == '\r';
+}
+
+// -----------------------------------------------------------------------------
+// Consume bytes de 'datos' hasta completar una línea no vacía. Devuelve cuántos
+// bytes consumió; si completó una línea la deja en *linea (texto != NULL), si no,
+// guarda lo que quedó abierto y deja linea->texto en NULL. Se llama en un ciclo
+// hasta consumir el bloque entero.
+// -----------------------------------------------------------------------------
+static inline size_t lineas_agregar(lineas_t *l, const uint8_t *datos, size_t n, linea_t *linea) {
+    size_t i = 0;
+    linea->texto = NULL;
+    while (i < n) {
+        // Busca el fin de la línea actual dentro del bloque
+        size_t inicio = i;
+        while (i < n && !lineas_es_fin(datos[i])) i++;
+        size_t tramo = i - inicio;
+
+        if (i == n) {
+            // El bloque terminó a mitad de línea: se guarda el pedazo
+            if (!l->descartando) {
+                size_t cabe = LINEA_MAX - l->largo;
+                if (tramo > cabe) {
+                    l->desbordada = true;
+                    tramo = cabe;
+                }
+                memcpy(l->buf + l->largo, datos + inicio, tramo);
+                l->largo += tramo;
+            }
+            return n;
+        }
+
+        i++;    // El fin de línea
+        if (l->descartando) {
+            l->descartando = false;
+            continue;
+        }
+        if (l->largo == 0) {
+            if (tramo == 0) continue;   // Línea vacía o la segunda mitad de un "\r\n"
+            // Caso común: la línea entera está en el bloque y se entrega sin copiar
+            linea->texto = (const char *)datos + inicio;
+            linea->largo = tramo < LINEA_MAX ? tramo : LINEA_MAX;
+            linea->desbordada = tramo > LINEA_MAX;
+            return i;
+        }
+        // Se completa una línea que venía de la lectura anterior
+        size_t cabe = LINEA_MAX - l->largo;
+        if (tramo > cabe) {
+            l->desbordada = true;
+            tramo = cabe;
+        }
+        memcpy(l->buf + l->largo, datos + inicio, tramo);
+        linea->texto = l->buf;
+        linea->largo = l->largo + tramo;
+        linea->desbordada = l->desbordada;
+        l->largo = 0;
+        l->desbordada = false;
+        return i;
+    }
+    return n;
+}
+
+// -----------------------------------------------------------------------------
+// Lee un entero con signo en forma canónica (la que imprime "%d"). Devuelve false
+// si la cadena no es exactamente un número así o si no cabe en int32_t.
+// -----------------------------------------------------------------------------
+static inline bool numero_leer(const char *s, size_t n, int32_t *valor) {
+    size_t i = 0;
+    bool negativo = n > 0 && s[0] == '-';
+    i += negativo;
+    size_t digitos = n - i;
+    if (digitos == 0 || digitos > 10) return false;
+    if (s[i] == '0' && (digitos > 1 || negativo)) return false;  // "07", "-0"
+
+    uint32_t limite = negativo ? 2147483648u : 2147483647u;
+    uint32_t acumulado = 0;
+    for (; i < n; i++) {
+        uint32_t d = (uint32_t)(uint8_t)s[i] - '0';
+        if (d > 9) return false;
+        if (acumulado > (limite - d) / 10) return false;    // acumulado * 10 + d > limite
+        acumulado = acumulado * 10 + d;
+    }
+    *valor = negativo ? (int32_t)(0u - acumulado) : (int32_t)acumulado;
+    return true;
+}
+
+#endif // LINEAS_NUMEROS_H
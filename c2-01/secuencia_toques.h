@@ -0,0 +1,145 @@
+/*
+ * RECONOCEDOR DE SECUENCIAS DE TOQUES POR TABLA DE TRANSICIONES
+ *
+ * El patrón se escribe como una tabla constante de grupos ("3 largos, 3 cortos,
+ * 3 largos") y secuencia_compilar() lo convierte una sola vez en un autómata:
+ * una fila por estado (toques correctos acumulados) y una columna por tipo de
+ * toque. Cada evento se procesa en O(1) con una clasificación sin saltos y una
+ * consulta a la tabla; no hay código que dependa de qué estado es cuál, así que
+ * cambiar el patrón es cambiar la tabla.
+ *
+ * Semántica (la del ejercicio original):
+ * - Un toque del tipo esperado avanza un estado.
+ * - Un toque de otro tipo vuelve al inicio (y se marca como reinicio).
+ * - Un toque inválido (más corto que un toque corto) no cambia nada.
+ * - Completado el patrón, los toques siguientes se ignoran hasta reiniciar.
+ *
+ * C puro (compila como C99 y como C++), sin dependencias del ESP32: se puede
+ * reproducir con trazas de eventos grabadas y medir en Linux.
+ */
+
+#ifndef SECUENCIA_TOQUES_H
+#define SECUENCIA_TOQUES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SECUENCIA_MAX_ESTADOS 64    // Toques del patrón + 1 (estado final)
+#define SECUENCIA_REINICIO    0x80  // Bandera en la tabla: la transición descarta lo acumulado
+#define SECUENCIA_ESTADO      0x7F
+
+// Tipos de toque según su duración; el orden importa (ver secuencia_clasificar)
+typedef enum {
+    TOQUE_INVALIDO,
+    TOQUE_CORTO,
+    TOQUE_LARGO,
+    NUM_TIPOS_TOQUE
+} tipo_toque_t;
+
+typedef enum { TOQUE_PRESION, TOQUE_LIBERACION } evento_toque_tipo_t;
+
+// Evento con marca de tiempo, tal como llega del sensor o de una traza grabada
+typedef struct {
+    uint32_t t_ms;
+    uint8_t tipo;   // evento_toque_tipo_t
+} evento_toque_t;
+
+// Un tramo del patrón: 'cantidad' toques seguidos de 'tipo'
+typedef struct {
+    uint8_t cantidad;
+    uint8_t tipo;   // tipo_toque_t
+} grupo_toques_t;
+
+// Autómata compilado
+typedef struct {
+    uint8_t siguiente[SECUENCIA_MAX_ESTADOS][NUM_TIPOS_TOQUE];  // Estado destino | SECUENCIA_REINICIO
+    uint8_t final;                                              // Estado de patrón completo
+    uint32_t corto_ms;                                          // Duración mínima de un toque corto
+    uint32_t largo_ms;                                          // Duración mínima de un toque largo
+} tabla_secuencia_t;
+
+typedef struct {
+    const tabla_secuencia_t *tabla;
+    uint8_t estado;
+    uint8_t presionado;     // 1 entre una presión y su liberación
+    uint32_t inicio_ms;     // Marca de la última presión
+} reconocedor_toques_t;
+
+// Resultado de una liberación
+typedef struct {
+    uint8_t tipo;           // tipo_toque_t del toque que terminó
+    bool reinicio;          // El toque no era el esperado: la secuencia volvió al inicio
+} resultado_toque_t;
+
+// -----------------------------------------------------------------------------
+// Construye la tabla de transiciones del patrón. Devuelve false si el patrón no
+// cabe en SECUENCIA_MAX_ESTADOS o usa un tipo que no es corto ni largo.
+// -----------------------------------------------------------------------------
+static inline bool secuencia_compilar(tabla_secuencia_t *t, const grupo_toques_t *patron, size_t grupos,
+                                      uint32_t corto_ms, uint32_t largo_ms) {
+    size_t estado = 0;
+    for (size_t g = 0; g < grupos; g++) {
+        if (patron[g].tipo != TOQUE_CORTO && patron[g].tipo != TOQUE_LARGO) return false;
+        for (uint8_t k = 0; k < patron[g].cantidad; k++, estado++) {
+            if (estado + 1 >= SECUENCIA_MAX_ESTADOS) return false;
+            for (int tipo = 0; tipo < NUM_TIPOS_TOQUE; tipo++) {
+                t->siguiente[estado][tipo] = SECUENCIA_REINICIO;  // Al estado 0
+            }
+            t->siguiente[estado][TOQUE_INVALIDO] = (uint8_t)estado;
+            t->siguiente[estado][patron[g].tipo] = (uint8_t)(estado + 1);
+        }
+    }
+    for (int tipo = 0; tipo < NUM_TIPOS_TOQUE; tipo++) {
+        t->siguiente[estado][tipo] = (uint8_t)estado;  // Completo: se queda ahí
+    }
+    t->final = (uint8_t)estado;
+    t->corto_ms = corto_ms;
+    t->largo_ms = largo_ms;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Tipo de un toque según su duración, sin saltos: cada umbral superado suma uno
+// -----------------------------------------------------------------------------
+static inline uint8_t secuencia_clasificar(const tabla_secuencia_t *t, uint32_t duracion_ms) {
+    return (uint8_t)((duracion_ms >= t->corto_ms) + (duracion_ms >= t->largo_ms));
+}
+
+static inline void secuencia_iniciar(reconocedor_toques_t *r, const tabla_secuencia_t *t) {
+    r->tabla = t;
+    r->estado = 0;
+    r->presionado = 0;
+    r->inicio_ms = 0;
+}
+
+static inline void secuencia_reiniciar(reconocedor_toques_t *r) {
+    r->estado = 0;
+}
+
+static inline bool secuencia_completa(const reconocedor_toques_t *r) {
+    return r->estado == r->tabla->final;
+}
+
+// -----------------------------------------------------------------------------
+// Procesa un evento. Las presiones solo guardan su marca; cada liberación mide
+// el toque y avanza el autómata. Una liberación sin presión previa cuenta como
+// de 0 ms (toque inválido), así que no hace falta validar el orden de los eventos.
+// -----------------------------------------------------------------------------
+static inline resultado_toque_t secuencia_evento(reconocedor_toques_t *r, evento_toque_t ev) {
+    resultado_toque_t res = {TOQUE_INVALIDO, false};
+    if (ev.tipo == TOQUE_PRESION) {
+        r->inicio_ms = ev.t_ms;
+        r->presionado = 1;
+        return res;
+    }
+    uint32_t duracion = (ev.t_ms - r->inicio_ms) & (0u - r->presionado);  // Resta módulo 2^32; 0 sin presión
+    res.tipo = secuencia_clasificar(r->tabla, duracion);
+    r->presionado = 0;
+    uint8_t destino = r->tabla->siguiente[r->estado][res.tipo];
+    r->estado = destino & SECUENCIA_ESTADO;
+    res.reinicio = (destino & SECUENCIA_REINICIO) != 0;
+    return res;
+}
+
+#endif // SECUENCIA_TOQUES_H
@@ -0,0 +1,125 @@
+/*
+ * SERIE DE IMPARES EN FLUJO ("1+3+5+...") CON SALIDA POR BLOQUES
+ *
+ * La serie de N términos ocupa ~N * (dígitos + 1) bytes: con N grande no cabe en
+ * ningún buffer, así que no se arma en memoria. Se escribe directo en un buffer
+ * fijo de SALIDA_BLOQUE bytes que se vacía con una función de escritura (la UART
+ * en el ESP32) cada vez que se llena.
+ *
+ * El impar actual se lleva como texto y se le suma 2 dígito a dígito: casi siempre
+ * cambia solo el último dígito, así que cada término cuesta O(1) amortizado (sin
+ * snprintf ni strlen) y la serie completa O(N) con memoria constante. La suma va
+ * en 64 bits: con N < 2^32 el resultado N^2 siempre cabe, y se puede comparar con
+ * la forma cerrada serie_cuadrado().
+ *
+ * C puro (compila como C99 y como C++), sin dependencias del ESP32.
+ */
+
+#ifndef SERIE_IMPARES_H
+#define SERIE_IMPARES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SALIDA_BLOQUE 128   // Lo que entra en la FIFO de TX de la UART
+#define SERIE_DIGITOS 10    // Con N < 2^32 el mayor impar, 2N - 1, tiene 10 dígitos
+
+typedef void (*salida_escribir_t)(void *contexto, const char *datos, size_t n);
+
+typedef struct {
+    char buf[SALIDA_BLOQUE];
+    size_t largo;
+    uint64_t bytes;             // Total escrito desde salida_iniciar
+    salida_escribir_t escribir;
+    void *contexto;
+} salida_bloques_t;
+
+static inline void salida_iniciar(salida_bloques_t *s, salida_escribir_t escribir, void *contexto) {
+    s->largo = 0;
+    s->bytes = 0;
+    s->escribir = escribir;
+    s->contexto = contexto;
+}
+
+static inline void salida_vaciar(salida_bloques_t *s) {
+    if (s->largo == 0) return;
+    s->escribir(s->contexto, s->buf, s->largo);
+    s->bytes += s->largo;
+    s->largo = 0;
+}
+
+static inline void salida_agregar(salida_bloques_t *s, const char *datos, size_t n) {
+    while (n > 0) {
+        size_t cabe = SALIDA_BLOQUE - s->largo;
+        size_t k = n < cabe ? n : cabe;
+        memcpy(s->buf + s->largo, datos, k);
+        s->largo += k;
+        datos += k;
+        n -= k;
+        if (s->largo == SALIDA_BLOQUE) salida_vaciar(s);
+    }
+}
+
+static inline void salida_texto(salida_bloques_t *s, const char *texto) {
+    salida_agregar(s, texto, strlen(texto));
+}
+
+static inline void salida_entero(salida_bloques_t *s, uint64_t valor) {
+    char dig[20];
+    size_t i = sizeof(dig);
+    do {
+        dig[--i] = (char)('0' + valor % 10);
+        valor /= 10;
+    } while (valor > 0);
+    salida_agregar(s, dig + i, sizeof(dig) - i);
+}
+
+// Forma cerrada: la suma de los N primeros impares es N^2
+static inline uint64_t serie_cuadrado(uint32_t n) {
+    return (uint64_t)n * n;
+}
+
+// -----------------------------------------------------------------------------
+// Escribe "1+3+5+...+(2N-1)" (nada si N = 0) y devuelve la suma de los términos
+// -----------------------------------------------------------------------------
+static inline uint64_t serie_impares(salida_bloques_t *s, uint32_t n) {
+    // impar[inicio..] es el término actual en texto, precedido por su '+'
+    char impar[SERIE_DIGITOS + 1];
+    size_t inicio = SERIE_DIGITOS;
+    impar[SERIE_DIGITOS] = '1';
+    impar[SERIE_DIGITOS - 1] = '+';
+
+    uint64_t suma = 0;
+    uint64_t valor = 1;
+    for (uint32_t i = 0; i < n; i++) {
+        if (i == 0) {
+            salida_agregar(s, impar + inicio, sizeof(impar) - inicio);
+        } else {
+            salida_agregar(s, impar + inicio - 1, sizeof(impar) - inicio + 1);
+        }
+        suma += valor;
+        valor += 2;
+
+        // Suma 2 al texto: el acarreo recorre solo los '9' finales
+        size_t k = SERIE_DIGITOS;
+        char c = (char)(impar[k] + 2);
+        if (c <= '9') {
+            impar[k] = c;
+            continue;
+        }
+        impar[k] = (char)(c - 10);
+        while (k-- > inicio && impar[k] == '9') impar[k] = '0';
+        if (k + 1 == inicio) {
+            // Un dígito más: el '+' se corre un lugar a la izquierda
+            impar[inicio - 1] = '1';
+            inicio--;
+            impar[inicio - 1] = '+';
+        } else {
+            impar[k]++;
+        }
+    }
+    return suma;
+}
+
+#endif // SERIE_IMPARES_H
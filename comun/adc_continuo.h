@@ -0,0 +1,170 @@
+/*
+ * ADQUISICIÓN CONTINUA DEL ADC (DMA) CON FILTRADO EN SEGUNDO PLANO
+ *
+ * Reemplaza las lecturas bloqueantes (analogRead / adc1_get_raw) por el modo
+ * continuo del ADC del ESP32: el DMA llena el buffer circular del driver a la
+ * frecuencia configurada, una tarea despierta con cada trama completa y la pasa
+ * por la cadena de filtros (diezmado -> mediana -> EMA). Quien necesite el valor
+ * lo lee en O(1) con adc_continuo_valor(), sin esperar al conversor.
+ *
+ * Si el valor solo hace falta de vez en cuando, adc_continuo_pausar() detiene el
+ * DMA entre lecturas: la tarea deja de despertar y el driver suelta su candado de
+ * energía, con lo que el chip puede entrar en sueño ligero.
+ *
+ * Compila como C y como C++ (lo usan tanto los sketches de Arduino como los
+ * programas de ESP-IDF). Maneja un canal del ADC1 por instancia.
+ */
+
+#ifndef ADC_CONTINUO_H
+#define ADC_CONTINUO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_adc/adc_continuous.h"
+#include "filtros_adc.h"
+
+#define ADC_CONTINUO_FRECUENCIA_HZ 20000  // Mínimo admitido por el ADC del ESP32
+#define ADC_CONTINUO_TAM_TRAMA     256    // Bytes por trama DMA (128 muestras)
+#define ADC_CONTINUO_TAM_BUFFER    1024   // Buffer circular del driver (4 tramas)
+#define ADC_CONTINUO_DIEZMADO      64     // 20 kHz / 64 = ~312 valores filtrados por segundo
+#define ADC_CONTINUO_K_EMA         2      // EMA con alfa = 1/4 sobre la salida de la mediana
+#define ADC_CONTINUO_TRAMAS_ASENTAR 3     // Tramas tras reanudar hasta llenar la ventana de la mediana
+
+typedef struct {
+    adc_continuous_handle_t handle;
+    adc_channel_t canal;
+    cadena_filtro_t filtro;
+    TaskHandle_t tarea;
+    uint32_t tramas;                // Tramas DMA procesadas
+    uint32_t desbordes;             // Veces que el buffer del driver se llenó
+} adc_continuo_t;
+
+// -----------------------------------------------------------------------------
+// Callback del driver (contexto de ISR): solo despierta a la tarea de filtrado
+// -----------------------------------------------------------------------------
+static bool IRAM_ATTR adc_continuo_trama_lista(adc_continuous_handle_t handle,
+                                               const adc_continuous_evt_data_t *edata, void *user_data) {
+    (void)handle;
+    (void)edata;
+    adc_continuo_t *adc = (adc_continuo_t *)user_data;
+    BaseType_t despertar = pdFALSE;
+    vTaskNotifyGiveFromISR(adc->tarea, &despertar);
+    return despertar == pdTRUE;
+}
+
+static bool IRAM_ATTR adc_continuo_desborde(adc_continuous_handle_t handle,
+                                            const adc_continuous_evt_data_t *edata, void *user_data) {
+    (void)handle;
+    (void)edata;
+    ((adc_continuo_t *)user_data)->desbordes++;
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Tarea de filtrado: vacía el buffer del driver y alimenta la cadena de filtros
+// -----------------------------------------------------------------------------
+static void adc_continuo_tarea(void *arg) {
+    adc_continuo_t *adc = (adc_continuo_t *)arg;
+    uint8_t trama[ADC_CONTINUO_TAM_TRAMA];
+    uint16_t muestras[ADC_CONTINUO_TAM_TRAMA / SOC_ADC_DIGI_RESULT_BYTES];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // Duerme hasta la próxima trama
+
+        uint32_t leidos = 0;
+        while (adc_continuous_read(adc->handle, trama, sizeof(trama), &leidos, 0) == ESP_OK) {
+            // Extrae los 12 bits de dato de las muestras del canal configurado
+            size_t n = 0;
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= leidos; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                adc_digi_output_data_t *p = (adc_digi_output_data_t *)&trama[i];
+                if (p->type1.channel == adc->canal) muestras[n++] = p->type1.data;
+            }
+            cadena_filtro_procesar(&adc->filtro, muestras, n);
+            adc->tramas++;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Configura el canal en modo continuo y arranca la tarea de filtrado
+// -----------------------------------------------------------------------------
+static inline esp_err_t adc_continuo_iniciar(adc_continuo_t *adc, adc_channel_t canal) {
+    memset(adc, 0, sizeof(*adc));
+    adc->canal = canal;
+    cadena_filtro_iniciar(&adc->filtro, ADC_CONTINUO_DIEZMADO, ADC_CONTINUO_K_EMA);
+
+    adc_continuous_handle_cfg_t config_handle = {
+        .max_store_buf_size = ADC_CONTINUO_TAM_BUFFER,
+        .conv_frame_size = ADC_CONTINUO_TAM_TRAMA,
+        .flags = {.flush_pool = 0},             // Con el buffer lleno se pierden las tramas nuevas (desbordes)
+    };
+    esp_err_t err = adc_continuous_new_handle(&config_handle, &adc->handle);
+    if (err != ESP_OK) return err;
+
+    adc_digi_pattern_config_t patron = {
+        .atten = ADC_ATTEN_DB_12,               // Rango completo (~0-3.3 V)
+        .channel = (uint8_t)canal,
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH, // 12 bits
+    };
+    adc_continuous_config_t config = {
+        .pattern_num = 1,
+        .adc_pattern = &patron,
+        .sample_freq_hz = ADC_CONTINUO_FRECUENCIA_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    err = adc_continuous_config(adc->handle, &config);
+    if (err != ESP_OK) return err;
+
+    // La tarea debe existir antes del primer callback de trama
+    xTaskCreate(adc_continuo_tarea, "adc_continuo", 3072, adc, configMAX_PRIORITIES - 2, &adc->tarea);
+
+    adc_continuous_evt_cbs_t callbacks = {
+        .on_conv_done = adc_continuo_trama_lista,
+        .on_pool_ovf = adc_continuo_desborde,
+    };
+    err = adc_continuous_register_event_callbacks(adc->handle, &callbacks, adc);
+    if (err != ESP_OK) return err;
+
+    err = adc_continuous_start(adc->handle);
+    if (err != ESP_OK) return err;
+
+    // Espera la primera trama para que nadie lea un 0 antes de tiempo
+    while (adc->tramas == 0) {
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Detiene el muestreo (y las tramas) hasta adc_continuo_reanudar()
+// -----------------------------------------------------------------------------
+static inline esp_err_t adc_continuo_pausar(adc_continuo_t *adc) {
+    return adc_continuous_stop(adc->handle);
+}
+
+// -----------------------------------------------------------------------------
+// Reanuda el muestreo con la cadena de filtros vacía (lo anterior ya no vale) y
+// espera a que vuelva a dar un valor asentado
+// -----------------------------------------------------------------------------
+static inline esp_err_t adc_continuo_reanudar(adc_continuo_t *adc) {
+    cadena_filtro_iniciar(&adc->filtro, ADC_CONTINUO_DIEZMADO, ADC_CONTINUO_K_EMA);
+    uint32_t inicio = adc->tramas;
+    esp_err_t err = adc_continuous_start(adc->handle);
+    if (err != ESP_OK) return err;
+    while (adc->tramas - inicio < ADC_CONTINUO_TRAMAS_ASENTAR) {
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+// Último valor filtrado (0-4095), en O(1)
+static inline uint16_t adc_continuo_valor(const adc_continuo_t *adc) {
+    return cadena_filtro_valor(&adc->filtro);
+}
+
+#endif // ADC_CONTINUO_H
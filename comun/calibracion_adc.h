@@ -0,0 +1,142 @@
+/*
+ * CALIBRACIÓN DEL ADC CON TABLA Y CONVERSIÓN EN PUNTO FIJO
+ *
+ * A 11 dB el ADC del ESP32 no es lineal: por debajo de ~0,1 V lee 0, arriba de
+ * ~2,5 V se curva y satura cerca de 3,1 V. Convertir con (crudo / 4095.0) * 100
+ * o map(crudo, 0, 4095, ...) arrastra ese error: con la curva típica, hasta 7,6
+ * puntos de cada 100 cerca de los 3/4 de la escala.
+ *
+ * Cada sensor se describe con dos curvas de puntos (interpolación lineal entre ellos):
+ * - La del ADC: crudo -> mV (ADC_11DB_TIPICA, o puntos medidos en la placa).
+ * - La del sensor: mV -> unidades de ingeniería (%, °C, ...).
+ * calibracion_construir() compone ambas en una tabla de CAL_NODOS valores, uno cada
+ * 2^CAL_BITS_PASO cuentas, en punto fijo Q.CAL_BITS_FRAC. Convertir una muestra es
+ * entonces una interpolación entera: dos lecturas de la tabla, una multiplicación
+ * y algunas sumas y corrimientos, sin punto flotante.
+ *
+ * En C++ la tabla se genera en tiempo de compilación (calibracion::tabla); en C se
+ * construye una vez al arrancar con calibracion_construir().
+ *
+ * C puro (compila como C99 y como C++14), sin dependencias del ESP32.
+ */
+
+#ifndef CALIBRACION_ADC_H
+#define CALIBRACION_ADC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#define CALIBRACION_FN static constexpr
+#else
+#define CALIBRACION_FN static inline
+#endif
+
+#define CAL_BITS_ADC   12                           // Resolución del ADC
+#define CAL_BITS_PASO  6                            // Un nodo cada 64 cuentas
+#define CAL_NODOS      ((1 << (CAL_BITS_ADC - CAL_BITS_PASO)) + 1)  // 65: el último cierra el tramo final
+#define CAL_BITS_FRAC  8                            // Salida en Q.8 (1/256 de unidad)
+#define CAL_UNO        (1 << CAL_BITS_FRAC)
+
+typedef struct {
+    float x;
+    float y;
+} punto_calibracion_t;
+
+// Tabla compuesta crudo -> unidades en Q.CAL_BITS_FRAC
+typedef struct {
+    int32_t nodo[CAL_NODOS];
+} calibracion_adc_t;
+
+// Curva típica crudo -> mV de un ESP32 a 11 dB (ajuste polinomial publicado por la
+// comunidad, muestreado cada 256 cuentas). Para más precisión se reemplaza por
+// puntos medidos en la propia placa con un voltímetro.
+#define ADC_11DB_MIN_MV 34      // Lectura 0
+#define ADC_11DB_MAX_MV 3140    // Lectura 4095: saturación
+#define ADC_11DB_TIPICA { \
+    {0, 34},       {256, 300},    {512, 538},    {768, 756},    {1024, 963},  \
+    {1280, 1165},  {1536, 1366},  {1792, 1569},  {2048, 1776},  {2304, 1985}, \
+    {2560, 2195},  {2816, 2401},  {3072, 2599},  {3328, 2782},  {3584, 2940}, \
+    {3840, 3064},  {4095, 3140} }
+
+// -----------------------------------------------------------------------------
+// Interpolación lineal en una curva de puntos con x creciente; fuera del rango de
+// la curva se prolonga su primer o último tramo
+// -----------------------------------------------------------------------------
+CALIBRACION_FN float calibracion_interpolar(const punto_calibracion_t *p, size_t n, float x) {
+    size_t i = 1;
+    while (i + 1 < n && x > p[i].x) i++;
+    return p[i - 1].y + (p[i].y - p[i - 1].y) * (x - p[i - 1].x) / (p[i].x - p[i - 1].x);
+}
+
+// -----------------------------------------------------------------------------
+// Construye la tabla de un sensor a partir de la curva del ADC (crudo -> mV) y la
+// del sensor (mV -> unidades). Cada curva necesita al menos 2 puntos.
+// -----------------------------------------------------------------------------
+CALIBRACION_FN void calibracion_construir(calibracion_adc_t *t, const punto_calibracion_t *adc, size_t n_adc,
+                                          const punto_calibracion_t *sensor, size_t n_sensor) {
+    for (int k = 0; k < CAL_NODOS; k++) {
+        float mv = calibracion_interpolar(adc, n_adc, (float)(k << CAL_BITS_PASO));
+        float y = calibracion_interpolar(sensor, n_sensor, mv) * CAL_UNO;
+        t->nodo[k] = (int32_t)(y < 0 ? y - 0.5f : y + 0.5f);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Crudo (0-4095) -> unidades en Q.CAL_BITS_FRAC. La salida se limita a la tabla:
+// con valores fuera de rango se usa el extremo correspondiente.
+// -----------------------------------------------------------------------------
+CALIBRACION_FN int32_t calibracion_q(const calibracion_adc_t *t, uint32_t crudo) {
+    crudo = crudo < (1u << CAL_BITS_ADC) ? crudo : (1u << CAL_BITS_ADC) - 1;
+    uint32_t k = crudo >> CAL_BITS_PASO;
+    int32_t f = (int32_t)(crudo & ((1u << CAL_BITS_PASO) - 1));
+    int32_t y0 = t->nodo[k];
+    // >> de un negativo es un corrimiento aritmético en GCC (el compilador del ESP32)
+    return y0 + (((t->nodo[k + 1] - y0) * f) >> CAL_BITS_PASO);
+}
+
+// Unidades enteras, redondeadas
+CALIBRACION_FN int32_t calibracion_entero(const calibracion_adc_t *t, uint32_t crudo) {
+    return (calibracion_q(t, crudo) + CAL_UNO / 2) >> CAL_BITS_FRAC;
+}
+
+// Centésimas de unidad, redondeadas (para imprimir "%ld.%02ld" sin punto flotante)
+CALIBRACION_FN int32_t calibracion_centesimas(const calibracion_adc_t *t, uint32_t crudo) {
+    return (calibracion_q(t, crudo) * 100 + CAL_UNO / 2) >> CAL_BITS_FRAC;
+}
+
+// -----------------------------------------------------------------------------
+// Convierte un bloque de muestras (por ejemplo un marco de DMA) a Q.CAL_BITS_FRAC.
+// Sin saltos ni dependencias entre iteraciones: el compilador lo puede vectorizar.
+// -----------------------------------------------------------------------------
+static inline void calibracion_convertir(const calibracion_adc_t *t, const uint16_t *crudos, size_t n,
+                                         int32_t *salida) {
+    const uint32_t maximo = (1u << CAL_BITS_ADC) - 1;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t c = crudos[i] < maximo ? crudos[i] : maximo;
+        uint32_t k = c >> CAL_BITS_PASO;
+        int32_t f = (int32_t)(c & ((1u << CAL_BITS_PASO) - 1));
+        int32_t y0 = t->nodo[k];
+        salida[i] = y0 + (((t->nodo[k + 1] - y0) * f) >> CAL_BITS_PASO);
+    }
+}
+
+#ifdef __cplusplus
+namespace calibracion {
+
+constexpr punto_calibracion_t ADC_11DB[] = ADC_11DB_TIPICA;
+
+// Tabla generada en tiempo de compilación:
+//   constexpr calibracion_adc_t CAL_POT = calibracion::tabla(PUNTOS_POT);
+template <size_t N_SENSOR, size_t N_ADC = sizeof(ADC_11DB) / sizeof(ADC_11DB[0])>
+constexpr calibracion_adc_t tabla(const punto_calibracion_t (&sensor)[N_SENSOR],
+                                  const punto_calibracion_t (&adc)[N_ADC] = ADC_11DB) {
+    calibracion_adc_t t{};
+    calibracion_construir(&t, adc, N_ADC, sensor, N_SENSOR);
+    return t;
+}
+
+}  // namespace calibracion
+#endif
+
+#endif // CALIBRACION_ADC_H
@@ -0,0 +1,92 @@
+/*
+ * COLA CIRCULAR SIN BLOQUEOS DE UN PRODUCTOR Y UN CONSUMIDOR (SPSC)
+ *
+ * Pensada para sacar trabajo de los callbacks (WiFi, ISR): el productor solo
+ * copia el dato a una casilla y publica el índice; el consumidor lo retira desde
+ * su propia tarea. No usa mutex ni secciones críticas: cada índice lo escribe un
+ * solo lado y la sincronización se hace con atómicos adquirir/liberar.
+ *
+ * Lleva la cuenta de la ocupación máxima alcanzada y de los elementos
+ * descartados por cola llena. Solo encabezado; compila igual en el ESP32 y en Linux.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template <typename T, size_t N>
+class ColaSPSC {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "La capacidad debe ser potencia de 2");
+
+ public:
+  // --- Lado productor ---
+
+  // Casilla libre donde escribir el próximo elemento, o nullptr si la cola está llena
+  // (en ese caso cuenta un descarte). Después de escribirla hay que llamar a publicar().
+  T *reservar() {
+    uint32_t cabeza = cabeza_.load(std::memory_order_relaxed);
+    if (cabeza - cola_.load(std::memory_order_acquire) == N) {
+      descartes_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &datos_[cabeza & (N - 1)];
+  }
+
+  // Hace visible al consumidor la casilla entregada por reservar()
+  void publicar() {
+    uint32_t cabeza = cabeza_.load(std::memory_order_relaxed) + 1;
+    cabeza_.store(cabeza, std::memory_order_release);
+
+    uint32_t ocupacion = cabeza - cola_.load(std::memory_order_relaxed);
+    if (ocupacion > maximo_.load(std::memory_order_relaxed)) {
+      maximo_.store(ocupacion, std::memory_order_relaxed);  // Solo lo escribe el productor
+    }
+  }
+
+  bool encolar(const T &elemento) {
+    T *casilla = reservar();
+    if (!casilla) return false;
+    *casilla = elemento;
+    publicar();
+    return true;
+  }
+
+  // --- Lado consumidor ---
+
+  // Elemento más antiguo sin retirarlo, o nullptr si la cola está vacía
+  const T *frente() const {
+    uint32_t cola = cola_.load(std::memory_order_relaxed);
+    if (cola == cabeza_.load(std::memory_order_acquire)) return nullptr;
+    return &datos_[cola & (N - 1)];
+  }
+
+  // Libera la casilla devuelta por frente()
+  void retirar() { cola_.store(cola_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  bool desencolar(T &elemento) {
+    const T *casilla = frente();
+    if (!casilla) return false;
+    elemento = *casilla;
+    retirar();
+    return true;
+  }
+
+  // --- Estadísticas (se pueden consultar desde cualquier lado) ---
+
+  size_t tamano() const {
+    return cabeza_.load(std::memory_order_acquire) - cola_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacidad() { return N; }
+  uint32_t maximaOcupacion() const { return maximo_.load(std::memory_order_relaxed); }
+  uint32_t descartes() const { return descartes_.load(std::memory_order_relaxed); }
+
+ private:
+  // Índices en líneas de caché separadas para que productor y consumidor no se estorben
+  alignas(64) std::atomic<uint32_t> cabeza_{0};  // Próxima casilla a escribir (productor)
+  alignas(64) std::atomic<uint32_t> cola_{0};    // Próxima casilla a leer (consumidor)
+  alignas(64) std::atomic<uint32_t> maximo_{0};
+  std::atomic<uint32_t> descartes_{0};
+  T datos_[N];
+};
@@ -0,0 +1,201 @@
+/*
+ * LAZO DE CONTROL A PERÍODO FIJO (ON-OFF O PID) CON SALIDA PWM
+ *
+ * Un temporizador de hardware interrumpe cada 'periodo' y la ISR solo despierta a
+ * una tarea de alta prioridad que evalúa la ley de control y escribe el duty del
+ * LEDC (en el ESP32 la FPU no se puede usar dentro de una ISR). Así el período no
+ * depende de lo que haga loop(): leer el DHT22, atender el serial o dibujar las
+ * pantallas solo cambian cuándo llega la próxima medición, no cuándo se actúa.
+ *
+ * loop() publica la medición y la consigna con medicion() y consigna(); la tarea
+ * usa siempre la última. Cada ciclo registra su desvío respecto del instante ideal
+ * (jitter) y los ciclos perdidos (interrupciones que llegaron con la tarea ocupada).
+ *
+ * LeyControl no toca hardware y se puede probar sola:
+ * - ON-OFF con histéresis.
+ * - PID con derivada sobre la medición y anti-windup por integración condicional:
+ *   con la salida saturada, el integrador no acumula error que empuje más allá.
+ * Ambas son de acción inversa (la salida enfría): suben cuando la medición supera
+ * la consigna.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+enum class ModoControl : uint8_t { OnOff, PID };
+
+struct ParametrosControl {
+  float histeresis;   // ON-OFF: media banda en °C
+  float kp;           // PID: salida (0-1) por °C de error
+  float ki;           // PID: salida por °C·s
+  float kd;           // PID: salida por °C/s
+};
+
+// =============================================================================
+// Ley de control: de (consigna, medición) a una salida entre 0 y 1
+// =============================================================================
+class LeyControl {
+ public:
+  explicit LeyControl(const ParametrosControl &p) : p_(p) {}
+
+  // Cambia de modo sin salto en la salida: el PID arranca con el integrador en la
+  // salida actual menos su término proporcional
+  void modo(ModoControl m, float consigna, float medicion) {
+    if (m == ModoControl::PID && modo_ != ModoControl::PID) {
+      integral_ = isnan(medicion) ? salida_ : salida_ - p_.kp * (medicion - consigna);
+      previa_ = medicion;
+    }
+    modo_ = m;
+  }
+  ModoControl modo() const { return modo_; }
+  float salida() const { return salida_; }
+
+  // Un ciclo de control de 'dt_s' segundos. Sin medición válida (NaN) se mantiene la salida.
+  float calcular(float consigna, float medicion, float dt_s) {
+    if (isnan(medicion) || isnan(consigna)) return salida_;
+    float error = medicion - consigna;
+
+    if (modo_ == ModoControl::OnOff) {
+      if (error > p_.histeresis) salida_ = 1.0f;
+      else if (error < -p_.histeresis) salida_ = 0.0f;
+      return salida_;
+    }
+
+    float derivada = isnan(previa_) ? 0.0f : (medicion - previa_) / dt_s;
+    previa_ = medicion;
+    float proporcional = p_.kp * error;
+    float integral = integral_ + p_.ki * error * dt_s;
+    float u = proporcional + integral + p_.kd * derivada;
+
+    // Anti-windup: solo se integra si la salida no está saturada en el sentido del error
+    if (!((u > 1.0f && error > 0) || (u < 0.0f && error < 0))) integral_ = integral;
+    u = proporcional + integral_ + p_.kd * derivada;
+    salida_ = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+    return salida_;
+  }
+
+ private:
+  ParametrosControl p_;
+  ModoControl modo_ = ModoControl::OnOff;
+  float salida_ = 0.0f;
+  float integral_ = 0.0f;
+  float previa_ = NAN;
+};
+
+// =============================================================================
+// Tarea de control disparada por un temporizador de hardware
+// =============================================================================
+class ControlPWM {
+ public:
+  static constexpr uint32_t PWM_HZ = 1000;
+  static constexpr uint8_t PWM_BITS = 10;
+  static constexpr uint32_t PWM_MAX = (1u << PWM_BITS) - 1;
+
+  explicit ControlPWM(const ParametrosControl &p) : ley_(p) {}
+
+  // Configura el LEDC en 'pin' (canal 'canalPwm') y arranca un temporizador libre con
+  // el período dado. Solo puede haber un ControlPWM por programa (la ISR de Arduino
+  // no recibe argumento).
+  void iniciar(uint8_t pin, uint8_t canalPwm, uint32_t periodoMs, ModoControl modo,
+               UBaseType_t prioridad = 5) {
+    pin_ = pin;
+    periodoUs_ = periodoMs * 1000;
+    modoPedido_.store((uint8_t)modo, std::memory_order_relaxed);
+    ley_.modo(modo, consigna(), medicion());
+    ledcAttachChannel(pin_, PWM_HZ, PWM_BITS, canalPwm);
+    ledcWrite(pin_, 0);  // En el core 3.x el duty se escribe por pin, no por canal
+
+    instancia() = this;
+    xTaskCreatePinnedToCore(tarea, "control", 3072, this, prioridad, &tarea_, 1);
+    timer_ = timerBegin(1000000);  // Un tic por microsegundo
+    timerAttachInterrupt(timer_, isr);
+    timerAlarm(timer_, periodoUs_, true, 0);  // Con recarga y sin límite de repeticiones
+  }
+
+  // --- Entradas (desde loop()) ---
+  void consigna(float c) { consigna_.store(c, std::memory_order_relaxed); }
+  void medicion(float t) { medicion_.store(t, std::memory_order_relaxed); }
+  void modo(ModoControl m) { modoPedido_.store((uint8_t)m, std::memory_order_relaxed); }
+
+  float consigna() const { return consigna_.load(std::memory_order_relaxed); }
+  float medicion() const { return medicion_.load(std::memory_order_relaxed); }
+  ModoControl modo() const { return (ModoControl)modoPedido_.load(std::memory_order_relaxed); }
+  float salida() const { return salida_.load(std::memory_order_relaxed); }  // 0 a 1
+
+  // --- Estadísticas del período (desde el último reiniciarEstadisticas) ---
+  uint32_t periodoUs() const { return periodoUs_; }
+  uint32_t ciclos() const { return ciclos_.load(std::memory_order_relaxed); }
+  uint32_t perdidos() const { return perdidos_.load(std::memory_order_relaxed); }
+  uint32_t jitterMaxUs() const { return jitterMaxUs_.load(std::memory_order_relaxed); }
+  uint32_t jitterPromUs() const {
+    uint32_t n = ciclos();
+    return n ? (uint32_t)(jitterSumaUs_.load(std::memory_order_relaxed) / n) : 0;
+  }
+  void reiniciarEstadisticas() { reiniciar_.store(true, std::memory_order_relaxed); }
+
+ private:
+  static ControlPWM *&instancia() {
+    static ControlPWM *p = nullptr;
+    return p;
+  }
+
+  static void IRAM_ATTR isr() {
+    BaseType_t despertar = pdFALSE;
+    vTaskNotifyGiveFromISR(instancia()->tarea_, &despertar);
+    portYIELD_FROM_ISR(despertar);
+  }
+
+  static void tarea(void *arg) {
+    ControlPWM *c = (ControlPWM *)arg;
+    int64_t ideal = -1;  // Instante en que debía empezar este ciclo (el primero marca el origen)
+    while (true) {
+      // Cada notificación es una interrupción; si llegó más de una, se perdieron ciclos
+      uint32_t avisos = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      if (avisos == 0) continue;
+      int64_t ahora = esp_timer_get_time();
+      if (ideal < 0) {
+        ideal = ahora;
+      } else {
+        ideal += (int64_t)avisos * c->periodoUs_;
+        c->registrar(ahora - ideal, avisos - 1);
+      }
+
+      ModoControl pedido = (ModoControl)c->modoPedido_.load(std::memory_order_relaxed);
+      if (pedido != c->ley_.modo()) c->ley_.modo(pedido, c->consigna(), c->medicion());
+      float u = c->ley_.calcular(c->consigna(), c->medicion(), c->periodoUs_ * avisos / 1e6f);
+      ledcWrite(c->pin_, (uint32_t)(u * PWM_MAX + 0.5f));
+      c->salida_.store(u, std::memory_order_relaxed);
+    }
+  }
+
+  void registrar(int64_t desvioUs, uint32_t perdidos) {
+    if (reiniciar_.exchange(false, std::memory_order_relaxed)) {
+      ciclos_.store(0, std::memory_order_relaxed);
+      perdidos_.store(0, std::memory_order_relaxed);
+      jitterMaxUs_.store(0, std::memory_order_relaxed);
+      jitterSumaUs_.store(0, std::memory_order_relaxed);
+    }
+    uint32_t j = (uint32_t)(desvioUs < 0 ? -desvioUs : desvioUs);
+    ciclos_.fetch_add(1, std::memory_order_relaxed);
+    perdidos_.fetch_add(perdidos, std::memory_order_relaxed);
+    jitterSumaUs_.fetch_add(j, std::memory_order_relaxed);
+    if (j > jitterMaxUs_.load(std::memory_order_relaxed)) jitterMaxUs_.store(j, std::memory_order_relaxed);
+  }
+
+  LeyControl ley_;  // Solo la usa la tarea de control
+  uint8_t pin_ = 0;
+  uint32_t periodoUs_ = 0;
+  hw_timer_t *timer_ = nullptr;
+  TaskHandle_t tarea_ = nullptr;
+  std::atomic<float> consigna_{NAN}, medicion_{NAN}, salida_{0.0f};
+  std::atomic<uint8_t> modoPedido_{(uint8_t)ModoControl::OnOff};
+  std::atomic<bool> reiniciar_{false};
+  std::atomic<uint32_t> ciclos_{0}, perdidos_{0}, jitterMaxUs_{0};
+  std::atomic<uint64_t> jitterSumaUs_{0};
+};
@@ -0,0 +1,177 @@
+/*
+ * DECODIFICADOR DEL PROTOCOLO DEL DHT22 (DE DURACIONES DE PULSOS A LECTURA)
+ *
+ * Tras el pulso de arranque del ESP32, el DHT22 responde con ~80 µs en bajo y ~80
+ * µs en alto y luego manda 40 bits, del más significativo al menos: cada bit es
+ * ~50 µs en bajo seguidos de ~27 µs en alto (0) o ~70 µs en alto (1). Cierra con
+ * ~50 µs en bajo y suelta la línea.
+ *   bytes 0-1: humedad relativa en décimas de %
+ *   bytes 2-3: temperatura en décimas de °C (bit 15 = signo, el resto es el módulo)
+ *   byte 4:    suma de los bytes 0 a 3, módulo 256
+ *
+ * decodificar() recibe los niveles y duraciones tal como los capturó el RMT y los
+ * recorre desde el final: así no importa cuánto del pulso de arranque o del estado
+ * previo de la línea haya quedado al comienzo de la captura. Cada pulso se valida
+ * contra una tolerancia amplia y un bit se decide por el alto, con el umbral a mitad
+ * de camino entre 27 y 70 µs.
+ *
+ * UltimaLectura guarda el último valor bueno para que una lectura fallida no llegue
+ * al control como NaN: el valor sigue vigente hasta que pasa 'vigencia' sin
+ * lecturas válidas. Se escribe desde la tarea del sensor y se lee desde loop() sin
+ * candados (la lectura cabe en 32 bits atómicos).
+ *
+ * C++ puro, sin dependencias del ESP32: se prueba en el host con trazas grabadas o
+ * sintéticas.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dht22 {
+
+constexpr size_t BITS = 40;
+constexpr size_t PULSOS_TRAMA = 2 + 2 * BITS + 1;  // Respuesta, bits y bajo final
+
+// Tolerancias en µs (el datasheet da 75-85 para la respuesta, 48-55 para el bajo de
+// cada bit, 22-30 y 68-75 para los altos de 0 y 1)
+constexpr uint16_t RESPUESTA_MIN_US = 60, RESPUESTA_MAX_US = 110;
+constexpr uint16_t BAJO_MIN_US = 30, BAJO_MAX_US = 90;
+constexpr uint16_t ALTO_MIN_US = 10, ALTO_MAX_US = 100;
+constexpr uint16_t UMBRAL_UNO_US = 48;
+
+// Un nivel de la línea y cuánto duró
+struct Pulso {
+  bool alto;
+  uint16_t us;
+};
+
+enum class Error : uint8_t {
+  Ninguno,
+  SinRespuesta,   // Sin pulsos de respuesta: sensor desconectado o sin alimentación
+  Incompleta,     // Menos pulsos que una trama completa
+  Tiempos,        // Un pulso fuera de tolerancia o niveles desalineados
+  Checksum,       // Bits leídos, pero la suma no coincide
+  FueraDeRango,   // Suma correcta con valores imposibles (humedad > 100 %, temperatura fuera de -40..80 °C)
+};
+constexpr size_t ERRORES = (size_t)Error::FueraDeRango + 1;
+
+constexpr const char *nombre(Error e) {
+  return e == Error::Ninguno        ? "ok"
+         : e == Error::SinRespuesta ? "sin respuesta"
+         : e == Error::Incompleta   ? "incompleta"
+         : e == Error::Tiempos      ? "tiempos"
+         : e == Error::Checksum     ? "checksum"
+                                    : "fuera de rango";
+}
+
+struct Lectura {
+  int16_t temperaturaDecimas;  // Décimas de °C
+  uint16_t humedadDecimas;     // Décimas de %
+  float temperatura() const { return temperaturaDecimas / 10.0f; }
+  float humedad() const { return humedadDecimas / 10.0f; }
+};
+
+// -----------------------------------------------------------------------------
+// Los 5 bytes de la trama -> lectura, validando la suma y el rango
+// -----------------------------------------------------------------------------
+inline Error convertir(const uint8_t (&b)[5], Lectura &l) {
+  if ((uint8_t)(b[0] + b[1] + b[2] + b[3]) != b[4]) return Error::Checksum;
+  uint16_t humedad = (uint16_t)(b[0] << 8 | b[1]);
+  int16_t modulo = (int16_t)((b[2] & 0x7F) << 8 | b[3]);
+  int16_t temperatura = (b[2] & 0x80) ? (int16_t)-modulo : modulo;
+  if (humedad > 1000 || temperatura < -400 || temperatura > 800) return Error::FueraDeRango;
+  l.temperaturaDecimas = temperatura;
+  l.humedadDecimas = humedad;
+  return Error::Ninguno;
+}
+
+// -----------------------------------------------------------------------------
+// Pulsos capturados -> lectura. Si devuelve Checksum o FueraDeRango, 'bytes' (si no
+// es nulo) queda con lo leído, para diagnóstico.
+// -----------------------------------------------------------------------------
+inline Error decodificar(const Pulso *p, size_t n, Lectura &l, uint8_t (*bytes)[5] = nullptr) {
+  // El RMT cierra la captura con un pulso de duración 0 (la línea quedó quieta). Si
+  // el sensor no contesta, queda a lo sumo el final del arranque y la línea en alto.
+  while (n > 0 && p[n - 1].us == 0) n--;
+  if (n <= 2) return Error::SinRespuesta;
+  if (n < PULSOS_TRAMA) return Error::Incompleta;
+
+  auto dentro = [](const Pulso &x, bool alto, uint16_t min, uint16_t max) {
+    return x.alto == alto && x.us >= min && x.us <= max;
+  };
+  const Pulso *t = p + n - PULSOS_TRAMA;
+  if (!dentro(t[0], false, RESPUESTA_MIN_US, RESPUESTA_MAX_US) ||
+      !dentro(t[1], true, RESPUESTA_MIN_US, RESPUESTA_MAX_US) ||
+      !dentro(t[PULSOS_TRAMA - 1], false, BAJO_MIN_US, BAJO_MAX_US)) {
+    return Error::Tiempos;
+  }
+
+  uint8_t b[5] = {0, 0, 0, 0, 0};
+  for (size_t i = 0; i < BITS; i++) {
+    const Pulso &bajo = t[2 + 2 * i], &alto = t[3 + 2 * i];
+    if (!dentro(bajo, false, BAJO_MIN_US, BAJO_MAX_US) || !dentro(alto, true, ALTO_MIN_US, ALTO_MAX_US)) {
+      return Error::Tiempos;
+    }
+    b[i / 8] = (uint8_t)(b[i / 8] << 1 | (alto.us > UMBRAL_UNO_US));
+  }
+  if (bytes) {
+    for (int i = 0; i < 5; i++) (*bytes)[i] = b[i];
+  }
+  return convertir(b, l);
+}
+
+// =============================================================================
+// Último valor bueno y contadores por resultado
+// =============================================================================
+class UltimaLectura {
+ public:
+  explicit UltimaLectura(uint32_t vigenciaMs) : vigenciaMs_(vigenciaMs) {}
+
+  // Registra el resultado de un intento; solo las lecturas buenas reemplazan el valor
+  void registrar(Error e, const Lectura &l, uint32_t ahoraMs) {
+    resultados_[(size_t)e].fetch_add(1, std::memory_order_relaxed);
+    if (e != Error::Ninguno) return;
+    instanteMs_.store(ahoraMs, std::memory_order_relaxed);
+    valor_.store((uint32_t)(uint16_t)l.temperaturaDecimas << 16 | l.humedadDecimas, std::memory_order_release);
+  }
+
+  // false si nunca hubo una lectura buena o si la última ya venció
+  bool obtener(Lectura &l, uint32_t ahoraMs) const {
+    uint32_t v = valor_.load(std::memory_order_acquire);
+    if (v == SIN_VALOR) return false;
+    if (ahoraMs - instanteMs_.load(std::memory_order_relaxed) > vigenciaMs_) return false;
+    l.temperaturaDecimas = (int16_t)(v >> 16);
+    l.humedadDecimas = (uint16_t)v;
+    return true;
+  }
+
+  float temperatura(uint32_t ahoraMs) const {
+    Lectura l;
+    return obtener(l, ahoraMs) ? l.temperatura() : NAN;
+  }
+  float humedad(uint32_t ahoraMs) const {
+    Lectura l;
+    return obtener(l, ahoraMs) ? l.humedad() : NAN;
+  }
+
+  uint32_t resultados(Error e) const { return resultados_[(size_t)e].load(std::memory_order_relaxed); }
+  uint32_t intentos() const {
+    uint32_t n = 0;
+    for (const auto &r : resultados_) n += r.load(std::memory_order_relaxed);
+    return n;
+  }
+
+ private:
+  static constexpr uint32_t SIN_VALOR = 0xFFFFFFFF;  // Humedad 6553,5 %: imposible tras convertir()
+
+  uint32_t vigenciaMs_;
+  std::atomic<uint32_t> valor_{SIN_VALOR};
+  std::atomic<uint32_t> instanteMs_{0};
+  std::atomic<uint32_t> resultados_[ERRORES] = {};
+};
+
+}  // namespace dht22
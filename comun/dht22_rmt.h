@@ -0,0 +1,129 @@
+/*
+ * LECTURA DEL DHT22 EN SEGUNDO PLANO CON EL PERIFÉRICO RMT
+ *
+ * La librería DHT lee el sensor por bit-bang: mide cada pulso con las
+ * interrupciones deshabilitadas y bloquea loop() unos 5 ms por lectura; si una
+ * interrupción o un cambio de contexto corre un flanco, devuelve NaN.
+ *
+ * Aquí una tarea de baja prioridad en el núcleo 0 hace el pulso de arranque, y el
+ * RMT (driver de recepción de ESP-IDF 5, 1 tic = 1 µs) registra por hardware el
+ * nivel y la duración de cada pulso de la respuesta. El callback de fin de
+ * recepción pasa la cantidad de símbolos por una cola; la tarea la espera sin usar
+ * CPU, decodifica con dht22::decodificar() y guarda el resultado en un
+ * dht22::UltimaLectura. loop() solo lee el último valor bueno: nunca espera al sensor.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "driver/gpio.h"
+#include "driver/rmt_rx.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "dht22.h"
+
+class Dht22Rmt {
+ public:
+  static constexpr uint32_t ARRANQUE_US = 1100;  // Pulso bajo de arranque (mínimo 1 ms)
+  static constexpr uint16_t FIN_US = 200;        // Línea quieta más que esto: terminó la trama
+
+  // 'periodoMs' no debe bajar de 2000: el DHT22 no mide más seguido. Una lectura
+  // buena sigue valiendo hasta tres períodos sin otra.
+  explicit Dht22Rmt(uint32_t periodoMs = 2000) : periodoMs_(periodoMs), ultima_(3 * periodoMs) {}
+
+  // El driver elige el canal del RMT
+  void iniciar(uint8_t pin, UBaseType_t prioridad = 2) {
+    pin_ = (gpio_num_t)pin;
+
+    rmt_rx_channel_config_t cfg = {};
+    cfg.gpio_num = pin_;
+    cfg.clk_src = RMT_CLK_SRC_DEFAULT;
+    cfg.resolution_hz = 1000000;                  // Un tic por microsegundo
+    cfg.mem_block_symbols = SIMBOLOS;
+    rmt_new_rx_channel(&cfg, &canal_);
+
+    fin_ = xQueueCreate(1, sizeof(size_t));
+    rmt_rx_event_callbacks_t cbs = {};
+    cbs.on_recv_done = recepcionCompleta;
+    rmt_rx_register_event_callbacks(canal_, &cbs, fin_);
+    rmt_enable(canal_);
+
+    // Colector abierto con entrada: el ESP32 solo tira la línea a bajo y el RMT lee
+    // el mismo pin (el pull-up del módulo la sube). Va después de crear el canal,
+    // que deja el pin solo como entrada.
+    gpio_set_level(pin_, 1);
+    gpio_set_direction(pin_, GPIO_MODE_INPUT_OUTPUT_OD);
+
+    xTaskCreatePinnedToCore(tarea, "dht22", 3072, this, prioridad, nullptr, 0);
+  }
+
+  // --- Último valor bueno (NaN si no hay uno vigente) ---
+  float temperatura() const { return ultima_.temperatura(millis()); }
+  float humedad() const { return ultima_.humedad(millis()); }
+  bool lectura(dht22::Lectura &l) const { return ultima_.obtener(l, millis()); }
+
+  // --- Contadores desde el arranque ---
+  uint32_t intentos() const { return ultima_.intentos(); }
+  uint32_t resultados(dht22::Error e) const { return ultima_.resultados(e); }
+
+ private:
+  // Contexto de ISR: solo avisa a la tarea cuántos símbolos quedaron en el buffer
+  static bool IRAM_ATTR recepcionCompleta(rmt_channel_handle_t, const rmt_rx_done_event_data_t *ev, void *ctx) {
+    BaseType_t despertar = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)ctx, &ev->num_symbols, &despertar);
+    return despertar == pdTRUE;
+  }
+
+  static void tarea(void *arg) {
+    Dht22Rmt *s = (Dht22Rmt *)arg;
+    TickType_t ultimo = xTaskGetTickCount();
+    while (true) {
+      dht22::Lectura l{};
+      dht22::Error e = s->medir(l);
+      s->ultima_.registrar(e, l, millis());
+      vTaskDelayUntil(&ultimo, pdMS_TO_TICKS(s->periodoMs_));
+    }
+  }
+
+  dht22::Error medir(dht22::Lectura &l) {
+    // Arranque: 1,1 ms en bajo. Es espera activa, pero en esta tarea y con las
+    // interrupciones habilitadas; la captura empieza antes de soltar la línea para
+    // no perder la respuesta, que llega 20-40 µs después.
+    rmt_receive_config_t recepcion = {};
+    recepcion.signal_range_min_ns = 1250;         // Descarta glitches de menos de 1,25 µs
+    recepcion.signal_range_max_ns = FIN_US * 1000;
+    gpio_set_level(pin_, 0);
+    delayMicroseconds(ARRANQUE_US);
+    rmt_receive(canal_, simbolos_, sizeof(simbolos_), &recepcion);
+    gpio_set_level(pin_, 1);
+
+    // La trama completa dura ~5 ms; si en 20 ms no llegó nada, el sensor no respondió.
+    // El driver no tiene cómo cancelar una recepción: se deshabilita el canal.
+    size_t k = 0;
+    if (xQueueReceive(fin_, &k, pdMS_TO_TICKS(20)) != pdTRUE) {
+      rmt_disable(canal_);
+      rmt_enable(canal_);
+      return dht22::Error::SinRespuesta;
+    }
+
+    // Cada símbolo del RMT trae dos pulsos
+    size_t n = 0;
+    for (size_t i = 0; i < k; i++) {
+      pulsos_[n++] = {simbolos_[i].level0 != 0, (uint16_t)simbolos_[i].duration0};
+      pulsos_[n++] = {simbolos_[i].level1 != 0, (uint16_t)simbolos_[i].duration1};
+    }
+    return dht22::decodificar(pulsos_, n, l);
+  }
+
+  // Un bloque de memoria del RMT (64 símbolos, 128 pulsos): la trama ocupa 42
+  static constexpr size_t SIMBOLOS = 64;
+
+  uint32_t periodoMs_;
+  gpio_num_t pin_ = GPIO_NUM_0;
+  rmt_channel_handle_t canal_ = nullptr;
+  QueueHandle_t fin_ = nullptr;
+  rmt_symbol_word_t simbolos_[SIMBOLOS];   // Lo llena el RMT; solo lo lee la tarea del sensor
+  dht22::Pulso pulsos_[2 * SIMBOLOS];
+  dht22::UltimaLectura ultima_;
+};
@@ -0,0 +1,161 @@
+/*
+ * FILTROS PARA MUESTRAS DEL ADC
+ *
+ * Núcleos de filtrado en C puro (compilan como C99 y como C++), sin dependencias
+ * del ESP32, para poder probarlos y medirlos en Linux con trazas grabadas:
+ * - Sobremuestreo + diezmado: promedia bloques de N muestras.
+ * - Mediana de N: elimina picos aislados.
+ * - EMA (media móvil exponencial) en punto fijo: alfa = 1 / 2^k.
+ * - Cadena completa diezmado -> mediana -> EMA con salida legible en O(1).
+ *
+ * Los lazos internos trabajan sobre arreglos contiguos sin dependencias entre
+ * iteraciones para que el compilador los pueda vectorizar.
+ */
+
+#ifndef FILTROS_ADC_H
+#define FILTROS_ADC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FILTRO_VENTANA_MEDIANA 5   // Salidas diezmadas que entran a la mediana
+#define FILTRO_MEDIANA_MAX     15  // Tamaño máximo aceptado por filtro_mediana()
+
+// -----------------------------------------------------------------------------
+// Suma 'n' muestras (lazo vectorizable)
+// -----------------------------------------------------------------------------
+static inline uint32_t filtro_sumar(const uint16_t *muestras, size_t n) {
+    uint32_t suma = 0;
+    for (size_t i = 0; i < n; i++) {
+        suma += muestras[i];
+    }
+    return suma;
+}
+
+// -----------------------------------------------------------------------------
+// Sobremuestreo + diezmado: promedia cada bloque de 'factor' muestras.
+// Devuelve cuántas salidas escribió (las muestras sobrantes se ignoran).
+// -----------------------------------------------------------------------------
+static inline size_t filtro_diezmar(const uint16_t *entrada, size_t n, uint16_t factor, uint16_t *salida) {
+    size_t bloques = n / factor;
+    for (size_t b = 0; b < bloques; b++) {
+        salida[b] = (uint16_t)(filtro_sumar(entrada + b * factor, factor) / factor);
+    }
+    return bloques;
+}
+
+// -----------------------------------------------------------------------------
+// Mediana de 'n' valores (n <= FILTRO_MEDIANA_MAX); no modifica la entrada
+// -----------------------------------------------------------------------------
+static inline uint16_t filtro_mediana(const uint16_t *valores, size_t n) {
+    uint16_t v[FILTRO_MEDIANA_MAX];
+    if (n == 0) return 0;
+    if (n > FILTRO_MEDIANA_MAX) n = FILTRO_MEDIANA_MAX;
+
+    // Ordenamiento por inserción: para ventanas tan pequeñas es lo más rápido
+    for (size_t i = 0; i < n; i++) {
+        uint16_t x = valores[i];
+        size_t j = i;
+        while (j > 0 && v[j - 1] > x) {
+            v[j] = v[j - 1];
+            j--;
+        }
+        v[j] = x;
+    }
+    return v[n / 2];
+}
+
+// -----------------------------------------------------------------------------
+// EMA en punto fijo: y += (x - y) / 2^k. El acumulador guarda y * 2^k para no
+// perder la resolución de los bits bajos.
+// -----------------------------------------------------------------------------
+typedef struct {
+    uint32_t acumulado;  // Valor filtrado escalado por 2^k
+    uint8_t k;           // Constante de tiempo: alfa = 1 / 2^k
+    uint8_t iniciado;    // 0 hasta recibir la primera muestra
+} filtro_ema_t;
+
+static inline void filtro_ema_iniciar(filtro_ema_t *ema, uint8_t k) {
+    ema->acumulado = 0;
+    ema->k = k;
+    ema->iniciado = 0;
+}
+
+static inline uint16_t filtro_ema_valor(const filtro_ema_t *ema) {
+    return (uint16_t)((ema->acumulado + (1u << ema->k >> 1)) >> ema->k);
+}
+
+static inline uint16_t filtro_ema_actualizar(filtro_ema_t *ema, uint16_t x) {
+    if (!ema->iniciado) {
+        ema->acumulado = (uint32_t)x << ema->k;  // La primera muestra fija el valor inicial
+        ema->iniciado = 1;
+    } else {
+        ema->acumulado = ema->acumulado - (ema->acumulado >> ema->k) + x;
+    }
+    return filtro_ema_valor(ema);
+}
+
+// -----------------------------------------------------------------------------
+// Cadena completa: diezmado -> mediana de FILTRO_VENTANA_MEDIANA -> EMA.
+// Acepta bloques de cualquier tamaño (un bloque de diezmado puede quedar partido
+// entre dos llamadas). El último valor filtrado se lee en O(1).
+// -----------------------------------------------------------------------------
+typedef struct {
+    uint16_t factor;                           // Muestras por salida diezmada
+    uint32_t suma;                             // Bloque de diezmado en curso
+    uint16_t cuenta;
+    uint16_t ventana[FILTRO_VENTANA_MEDIANA];  // Anillo de salidas diezmadas
+    uint8_t pos;
+    uint8_t llenos;
+    filtro_ema_t ema;
+    volatile uint16_t valor;                   // Salida filtrada más reciente
+} cadena_filtro_t;
+
+static inline void cadena_filtro_iniciar(cadena_filtro_t *c, uint16_t factor, uint8_t k_ema) {
+    c->factor = factor ? factor : 1;
+    c->suma = 0;
+    c->cuenta = 0;
+    c->pos = 0;
+    c->llenos = 0;
+    filtro_ema_iniciar(&c->ema, k_ema);
+    c->valor = 0;
+}
+
+// Una salida diezmada recorre la mediana y la EMA
+static inline void cadena_filtro_empujar(cadena_filtro_t *c, uint16_t diezmado) {
+    c->ventana[c->pos] = diezmado;
+    c->pos = (uint8_t)((c->pos + 1) % FILTRO_VENTANA_MEDIANA);
+    if (c->llenos < FILTRO_VENTANA_MEDIANA) c->llenos++;
+    c->valor = filtro_ema_actualizar(&c->ema, filtro_mediana(c->ventana, c->llenos));
+}
+
+static inline void cadena_filtro_procesar(cadena_filtro_t *c, const uint16_t *muestras, size_t n) {
+    size_t i = 0;
+
+    // Completa el bloque que quedó partido en la llamada anterior
+    while (c->cuenta != 0 && i < n) {
+        c->suma += muestras[i++];
+        if (++c->cuenta == c->factor) {
+            cadena_filtro_empujar(c, (uint16_t)(c->suma / c->factor));
+            c->suma = 0;
+            c->cuenta = 0;
+        }
+    }
+
+    // Bloques completos: suma vectorizable
+    for (; i + c->factor <= n; i += c->factor) {
+        cadena_filtro_empujar(c, (uint16_t)(filtro_sumar(muestras + i, c->factor) / c->factor));
+    }
+
+    // El resto queda para la próxima llamada
+    for (; i < n; i++) {
+        c->suma += muestras[i];
+        c->cuenta++;
+    }
+}
+
+static inline uint16_t cadena_filtro_valor(const cadena_filtro_t *c) {
+    return c->valor;
+}
+
+#endif // FILTROS_ADC_H
@@ -0,0 +1,94 @@
+/*
+ * OLED SSD1306 CON BUFFER SOMBRA (ver pantalla_sombra.h)
+ *
+ * Se sigue dibujando con Adafruit_SSD1306 (clearDisplay, print, ...) pero en vez
+ * de display() se envían, página por página (8 filas de píxeles), solo los tramos
+ * de columnas que cambiaron desde el último envío, a 400 kHz.
+ */
+
+#pragma once
+
+#include <Adafruit_SSD1306.h>
+#include "pantalla_sombra.h"
+
+class OledSombra : public PantallaSombra {
+ public:
+  static constexpr uint8_t ANCHO = 128;
+  static constexpr uint8_t PAGINAS = 8;           // 64 filas de píxeles
+  static constexpr uint32_t RELOJ_HZ = 400000;    // Modo rápido del SSD1306
+
+  OledSombra(Adafruit_SSD1306 &oled, TwoWire &bus, uint8_t direccion)
+      : oled_(oled), bus_(bus), dir_(direccion) {
+    invalidar();
+  }
+
+  // Fuerza un redibujado completo (por ejemplo después de un display() directo)
+  void invalidar() override { todoSucio_ = true; }
+
+  size_t enviar() override {
+    const uint8_t *marco = oled_.getBuffer();
+    size_t bytes = 0;
+    uint32_t relojPrevio = bus_.getClock();
+    bus_.setClock(RELOJ_HZ);
+
+    for (uint8_t p = 0; p < PAGINAS; p++) {
+      const uint8_t *fila = marco + p * ANCHO;
+      uint8_t *sombra = sombra_ + p * ANCHO;
+      uint8_t c = 0;
+      while (c < ANCHO) {
+        if (!todoSucio_ && fila[c] == sombra[c]) {
+          c++;
+          continue;
+        }
+        // Tramo de columnas distintas; los huecos más cortos que el costo de una
+        // nueva ventana (8 bytes) se reenvían para no partir el tramo
+        uint8_t fin = c + 1;
+        uint8_t iguales = 0;
+        for (uint8_t x = fin; x < ANCHO && iguales <= COSTO_VENTANA; x++) {
+          if (todoSucio_ || fila[x] != sombra[x]) {
+            fin = x + 1;
+            iguales = 0;
+          } else {
+            iguales++;
+          }
+        }
+        bytes += enviarTramo(p, c, fin, fila);
+        memcpy(sombra + c, fila + c, fin - c);
+        c = fin;
+      }
+    }
+
+    todoSucio_ = false;
+    bus_.setClock(relojPrevio);
+    return bytes;
+  }
+
+ private:
+  static constexpr uint8_t COSTO_VENTANA = 8;      // Dirección + control + 6 bytes de comando
+  static constexpr size_t DATOS_POR_TRANSACCION = 31;  // Como Adafruit_SSD1306 con el búfer de Wire de 32
+
+  // Fija la ventana [desde, hasta) de la página y envía sus columnas
+  size_t enviarTramo(uint8_t pagina, uint8_t desde, uint8_t hasta, const uint8_t *fila) {
+    const uint8_t ventana[] = {0x00, 0x21, desde, (uint8_t)(hasta - 1), 0x22, pagina, pagina};
+    bus_.beginTransmission(dir_);
+    bus_.write(ventana, sizeof(ventana));
+    bus_.endTransmission();
+    size_t bytes = 1 + sizeof(ventana);
+
+    for (uint8_t c = desde; c < hasta; c += DATOS_POR_TRANSACCION) {
+      size_t n = (size_t)(hasta - c) < DATOS_POR_TRANSACCION ? (size_t)(hasta - c) : DATOS_POR_TRANSACCION;
+      bus_.beginTransmission(dir_);
+      bus_.write((uint8_t)0x40);  // Lo que sigue son datos de la GDDRAM
+      bus_.write(fila + c, n);
+      bus_.endTransmission();
+      bytes += 2 + n;
+    }
+    return bytes;
+  }
+
+  Adafruit_SSD1306 &oled_;
+  TwoWire &bus_;
+  uint8_t dir_;
+  bool todoSucio_ = true;
+  uint8_t sombra_[PAGINAS * ANCHO] = {};
+};
@@ -0,0 +1,203 @@
+/*
+ * PANTALLAS I2C CON BUFFER SOMBRA Y REFRESCO EN SEGUNDO PLANO
+ *
+ * El programa dibuja en un buffer en RAM (sin tocar el bus) y la capa compara ese
+ * buffer con una copia de lo que la pantalla ya muestra: solo viajan por I2C las
+ * celdas o columnas que cambiaron. Nunca hace falta lcd.clear() (2 ms bloqueado)
+ * ni reenviar el framebuffer completo del OLED (~1 KB).
+ *
+ * El envío lo hace una tarea de FreeRTOS propia (RefrescoI2C): el lazo de control
+ * dibuja, llama a publicar() y sigue; la tarea ocupa el bus mientras el driver I2C
+ * espera sus interrupciones. Mientras un marco se está enviando el lazo no debe
+ * dibujar: publicar() devuelve false y libre() indica cuándo puede volver a hacerlo.
+ *
+ * Este archivo trae la interfaz común, la tarea y la LCD HD44780 con adaptador
+ * PCF8574; el OLED SSD1306 está en oled_sombra.h.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Una pantalla que sabe enviar solo lo que cambió desde el último envío
+class PantallaSombra {
+ public:
+  virtual ~PantallaSombra() = default;
+  // Envía las diferencias y actualiza la sombra; devuelve los bytes puestos en el bus
+  virtual size_t enviar() = 0;
+  // Olvida lo que muestra la pantalla: el próximo envío la redibuja completa
+  virtual void invalidar() = 0;
+};
+
+// =============================================================================
+// LCD HD44780 (16x2, 20x4) detrás de un expansor PCF8574
+// =============================================================================
+// Cada byte al HD44780 son dos nibbles y cada nibble tres escrituras al PCF8574
+// (dato, EN alto, EN bajo). LiquidCrystal_I2C hace una transacción I2C por escritura;
+// aquí una racha de caracteres contiguos viaja en una sola transacción.
+class LcdSombra : public Print, public PantallaSombra {
+ public:
+  static constexpr uint8_t MAX_COLUMNAS = 20;
+  static constexpr uint8_t MAX_FILAS = 4;
+  static constexpr uint32_t RELOJ_HZ = 100000;  // Máximo del PCF8574 según su hoja de datos
+
+  LcdSombra(TwoWire &bus, uint8_t direccion, uint8_t columnas, uint8_t filas)
+      : bus_(bus), dir_(direccion),
+        columnas_(columnas < MAX_COLUMNAS ? columnas : MAX_COLUMNAS),
+        filas_(filas < MAX_FILAS ? filas : MAX_FILAS) {
+    memset(marco_, ' ', sizeof(marco_));
+    memset(sombra_, ' ', sizeof(sombra_));  // Tras lcd.init() la pantalla queda en blanco
+  }
+
+  // --- Dibujo (solo RAM) ---
+  void limpiar() {
+    memset(marco_, ' ', sizeof(marco_));
+    col_ = fila_ = 0;
+  }
+  void setCursor(uint8_t col, uint8_t fila) {
+    col_ = col;
+    fila_ = fila < filas_ ? fila : filas_ - 1;
+  }
+  using Print::write;
+  size_t write(uint8_t c) override {
+    if (col_ < columnas_) marco_[fila_][col_] = (char)c;
+    col_++;
+    return 1;
+  }
+
+  // --- Envío ---
+  void invalidar() override { memset(sombra_, 0, sizeof(sombra_)); }
+
+  size_t enviar() override {
+    size_t bytes = 0;
+    for (uint8_t f = 0; f < filas_; f++) {
+      uint8_t c = 0;
+      while (c < columnas_) {
+        if (marco_[f][c] == sombra_[f][c]) {
+          c++;
+          continue;
+        }
+        // Racha de celdas distintas; un hueco de una sola celda igual se reenvía
+        // porque cuesta lo mismo que un nuevo comando de posición
+        uint8_t fin = c + 1;
+        while (fin < columnas_ && (marco_[f][fin] != sombra_[f][fin] ||
+                                   (fin + 1 < columnas_ && marco_[f][fin + 1] != sombra_[f][fin + 1]))) {
+          fin++;
+        }
+        bytes += enviarRacha(f, c, fin);
+        c = fin;
+      }
+    }
+    return bytes;
+  }
+
+ private:
+  static constexpr uint8_t RS = 0x01, EN = 0x04, LUZ = 0x08;
+  static constexpr size_t BYTES_POR_TRANSACCION = (I2C_BUFFER_LENGTH - 2) / 6;  // Bytes del HD44780
+
+  // Escribe las celdas [desde, hasta) de la fila con un comando de posición y sus datos
+  size_t enviarRacha(uint8_t fila, uint8_t desde, uint8_t hasta) {
+    static const uint8_t INICIO_FILA[MAX_FILAS] = {0x00, 0x40, 0x14, 0x54};
+    size_t bytes = 0;
+    uint32_t relojPrevio = bus_.getClock();
+    bus_.setClock(RELOJ_HZ);
+
+    bus_.beginTransmission(dir_);
+    size_t enTransaccion = 1;
+    codificar((uint8_t)(0x80 | (INICIO_FILA[fila] + desde)), 0);
+    for (uint8_t c = desde; c < hasta; c++) {
+      if (enTransaccion == BYTES_POR_TRANSACCION) {
+        bus_.endTransmission();
+        bytes += 1 + enTransaccion * 6;
+        bus_.beginTransmission(dir_);
+        enTransaccion = 0;
+      }
+      codificar((uint8_t)marco_[fila][c], RS);
+      sombra_[fila][c] = marco_[fila][c];
+      enTransaccion++;
+    }
+    bus_.endTransmission();
+    bytes += 1 + enTransaccion * 6;
+
+    bus_.setClock(relojPrevio);
+    return bytes;
+  }
+
+  void codificar(uint8_t valor, uint8_t rs) {
+    nibble((uint8_t)(valor & 0xF0), rs);
+    nibble((uint8_t)(valor << 4), rs);
+  }
+  void nibble(uint8_t n, uint8_t rs) {
+    uint8_t v = n | rs | LUZ;
+    bus_.write(v);
+    bus_.write((uint8_t)(v | EN));
+    bus_.write(v);
+  }
+
+  TwoWire &bus_;
+  uint8_t dir_, columnas_, filas_;
+  uint8_t col_ = 0, fila_ = 0;
+  char marco_[MAX_FILAS][MAX_COLUMNAS];   // Lo que el programa quiere mostrar
+  char sombra_[MAX_FILAS][MAX_COLUMNAS];  // Lo que la pantalla muestra
+};
+
+// =============================================================================
+// Tarea de refresco: envía las pantallas registradas cada vez que se publica un marco
+// =============================================================================
+class RefrescoI2C {
+ public:
+  static constexpr size_t MAX_PANTALLAS = 4;
+
+  void agregar(PantallaSombra &p) {
+    if (n_ < MAX_PANTALLAS) pantallas_[n_++] = &p;
+  }
+
+  void iniciar(UBaseType_t prioridad = 1, BaseType_t nucleo = 1) {
+    xTaskCreatePinnedToCore(tarea, "refresco_i2c", 3072, this, prioridad, &tarea_, nucleo);
+  }
+
+  // true si el lazo puede dibujar (no hay un marco en camino)
+  bool libre() const { return !pendiente_.load(std::memory_order_acquire); }
+
+  // Entrega el marco dibujado a la tarea. Si el anterior sigue en camino se descarta.
+  bool publicar() {
+    if (!libre()) {
+      saltados_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    pendiente_.store(true, std::memory_order_release);
+    xTaskNotifyGive(tarea_);
+    return true;
+  }
+
+  // Estadísticas
+  uint32_t marcos() const { return marcos_.load(std::memory_order_relaxed); }
+  uint32_t saltados() const { return saltados_.load(std::memory_order_relaxed); }
+  uint32_t bytesUltimoMarco() const { return bytesUltimo_.load(std::memory_order_relaxed); }
+  uint32_t bytesTotales() const { return bytesTotales_.load(std::memory_order_relaxed); }
+
+ private:
+  static void tarea(void *arg) {
+    RefrescoI2C *r = (RefrescoI2C *)arg;
+    while (true) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      uint32_t bytes = 0;
+      for (size_t i = 0; i < r->n_; i++) bytes += (uint32_t)r->pantallas_[i]->enviar();
+      r->bytesUltimo_.store(bytes, std::memory_order_relaxed);
+      r->bytesTotales_.fetch_add(bytes, std::memory_order_relaxed);
+      r->marcos_.fetch_add(1, std::memory_order_relaxed);
+      r->pendiente_.store(false, std::memory_order_release);
+    }
+  }
+
+  PantallaSombra *pantallas_[MAX_PANTALLAS] = {};
+  size_t n_ = 0;
+  TaskHandle_t tarea_ = nullptr;
+  std::atomic<bool> pendiente_{false};
+  std::atomic<uint32_t> marcos_{0}, saltados_{0}, bytesUltimo_{0}, bytesTotales_{0};
+};
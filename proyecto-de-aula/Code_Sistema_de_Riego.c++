@@ -5,6 +5,8 @@
  * - Lectura de humedad del suelo.
  * - Control remoto via Blynk.
  * - Protección contra riegos demasiado frecuentes.
+ * - Historial de humedad y del relé en flash: lo que no llegó a la nube mientras no
+ *   había conexión se sube con su hora original cuando vuelve.
  */
 
 // Datos del proyecto Blynk (puedes obtenerlos desde la plataforma Blynk)
@@ -17,15 +19,28 @@
 #include <Wire.h>                    // Librería para comunicación I2C
 #include <WiFiClient.h>              // Permite la conexión a internet mediante WiFi
 #include <BlynkSimpleEsp32.h>        // Librería Blynk específica para ESP32
+#include "PoliticaPublicacion.h"     // Banda muerta, latido y coalescencia de la publicación
+#include "../comun/adc_continuo.h"   // ADC en modo continuo (DMA) con filtrado en segundo plano
+#include "../comun/calibracion_adc.h" // Crudo -> humedad con tabla de calibración en punto fijo
+#include "../comun/pantalla_sombra.h" // LCD por diferencias, enviada desde su propia tarea
+#include "HistorialFlash.h"          // Registro en flash de muestras y eventos, con subida diferida
 
 // Definiciones de pines
-#define sensor 33    // Pin analógico para leer el sensor de humedad del suelo
+#define sensor ADC_CHANNEL_5  // Sensor de humedad del suelo en GPIO33 (canal 5 del ADC1)
 #define relay 4      // Pin digital para controlar el relé que activa la bomba
 
+// Calibración del sensor de humedad (mV -> %): a menor voltaje, suelo más húmedo.
+// Los extremos son los de la ventana útil del ADC; con el sensor al aire y en agua
+// se reemplazan por los voltajes medidos. La tabla se genera al compilar.
+constexpr punto_calibracion_t PUNTOS_SUELO[] = {{ADC_11DB_MIN_MV, 100}, {ADC_11DB_MAX_MV, 0}};
+constexpr calibracion_adc_t CAL_SUELO = calibracion::tabla(PUNTOS_SUELO);
+
 // Inicialización del objeto LCD con dirección I2C 0x27 y tamaño 16x2 caracteres
 LiquidCrystal_I2C lcd(0x27, 16, 2);
+LcdSombra pantalla(Wire, 0x27, 16, 2);  // Se dibuja aquí (RAM); solo viajan las celdas que cambian
+RefrescoI2C refresco;                   // Tarea que envía las diferencias por I2C
 
-// Objeto para manejar temporizadores de Blynk
+// Objeto para manejar temporizadores de Blynk (planificador cooperativo del sistema)
 BlynkTimer timer;
 
 // Credenciales de Blynk y WiFi
@@ -33,6 +48,62 @@ char auth[] = "Gy1OXXvQLzybzXPk9qT2nhygEZmKrFqv";   // Token de autenticación d
 char ssid[] = "Galaxy A35";                         // Nombre de la red WiFi
 char pass[] = "JosVal2005";                         // Contraseña de la red WiFi
 
+// Periodos de cada tarea del planificador (en milisegundos)
+#define PERIODO_SENSADO_MS  200     // Lectura del sensor de humedad
+#define PERIODO_LCD_MS      500     // Refresco de la pantalla LCD
+#define PERIODO_CARGA_MS    200     // Paso de la animación "System Loading"
+#define PERIODO_DIAG_MS     10000   // Reporte de la latencia máxima del lazo
+#define PASOS_CARGA         16      // Puntos de la animación (uno por columna)
+#define PERIODO_HISTORIAL_MS 60000  // Una muestra de humedad por minuto al historial
+#define PERIODO_VACIADO_MS  600000  // Grabación en flash de lo juntado en RAM (se pierde en un corte de luz)
+#define PERIODO_SUBIDA_MS   1000    // Una tanda de la subida del historial atrasado
+#define LOTE_SUBIDA         20      // Registros por tanda: acota lo que la subida ocupa el lazo
+#define HORA_VALIDA         1700000000UL // time() menor: SNTP todavía no dio la hora
+
+// Política de publicación de la humedad: solo se envían cambios de al menos 2 %,
+// como máximo uno por segundo y un latido por minuto aunque no haya cambios.
+// Si entre dos envíos la humedad se movió más que la banda, viaja también el resumen
+// del lote en V2 (mínimo), V3 (máximo) y V4 (promedio).
+ConfigPublicacion configNube;
+PoliticaPublicacion politicaNube(configNube);
+
+// Adquisición continua del sensor: el valor filtrado se lee sin esperar al ADC
+adc_continuo_t adcSuelo;
+
+// Historial en flash: anillo sobre la partición de datos, con índice por tiempo
+HistorialFlash historial;
+bool historialListo = false;    // false si no se encontró la partición
+unsigned long sinHora = 0;      // Registros descartados porque aún no había hora
+
+// Estado compartido entre las tareas
+int humedad = 0;                // Última humedad medida (0 = seco, 100 = húmedo)
+bool motorEncendido = false;    // Estado actual de la bomba
+bool cargando = true;           // true mientras corre la animación de arranque
+int pasoCarga = 0;              // Columna del siguiente punto de la animación
+
+// Medición de la latencia de atención: tiempo máximo entre dos llamadas a Blynk.run().
+// Un comando V1 nunca espera más que esto para llegar al relé.
+unsigned long ultimoRunUs = 0;
+unsigned long esperaMaxUs = 0;
+
+// Prototipos de las tareas del planificador
+void soilMoisture();
+void publicarHumedad();
+void refrescarLCD();
+void reportarLatencia();
+void registrarHistorial();
+void vaciarHistorial();
+void subirHistorial();
+
+// Tarea de arranque: agrega un punto por llamada sin bloquear el lazo de control
+void animacionCarga() {
+  pasoCarga++;                      // Un punto más, de izquierda a derecha
+  if (pasoCarga >= PASOS_CARGA) {
+    cargando = false;               // Al terminar se pasa a la pantalla de humedad
+  }
+  refrescarLCD();
+}
+
 // Función que se ejecuta al iniciar el ESP32
 void setup() {
   Serial.begin(115200);  // Inicializa el monitor serial a 115200 baudios
@@ -41,53 +112,205 @@ void setup() {
   lcd.init();         // Inicializa la pantalla LCD
   lcd.backlight();    // Enciende la luz de fondo del LCD
 
+  adc_continuo_iniciar(&adcSuelo, sensor); // Arranca el muestreo continuo del sensor
+
+  // Hora UTC por SNTP: el historial guarda instantes absolutos
+  configTime(0, 0, "pool.ntp.org");
+
+  // El historial ocupa la partición "spiffs" de la tabla por defecto (el sketch no usa SPIFFS)
+  historialListo = historial.montar(
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "spiffs"));
+
   pinMode(relay, OUTPUT);     // Establece el pin del relé como salida
   digitalWrite(relay, HIGH);  // Apaga el relé (asumiendo lógica inversa: HIGH = OFF)
 
-  // Animación de carga en el LCD
-  lcd.setCursor(1, 0);
-  lcd.print("System Loading");      // Muestra el texto inicial
-  for (int a = 0; a <= 15; a++) {
-    lcd.setCursor(a, 1);            // Mueve el cursor de izquierda a derecha
-    lcd.print(".");                 // Imprime puntos uno por uno (animación)
-    delay(200);                     // Espera 200 ms entre puntos
-  }
-  lcd.clear();                      // Limpia la pantalla al finalizar la animación
+  // La LCD se actualiza por diferencias desde su propia tarea
+  refresco.agregar(pantalla);
+  refresco.iniciar();
+
+  // Animación de carga en el LCD: la corre el temporizador, el lazo de control arranca ya
+  refrescarLCD();                   // Muestra el texto inicial
+  timer.setTimer(PERIODO_CARGA_MS, animacionCarga, PASOS_CARGA);
+
+  // Cada tarea corre a su propio ritmo
+  timer.setInterval(PERIODO_SENSADO_MS, soilMoisture);
+  timer.setInterval(PERIODO_LCD_MS, refrescarLCD);
+  timer.setInterval(PERIODO_DIAG_MS, reportarLatencia);
+  timer.setInterval(PERIODO_HISTORIAL_MS, registrarHistorial);
+  timer.setInterval(PERIODO_VACIADO_MS, vaciarHistorial);
+  timer.setInterval(PERIODO_SUBIDA_MS, subirHistorial);
 }
 
-// Función que mide la humedad del suelo y actualiza el LCD y Blynk
+// Tarea de sensado: mide la humedad del suelo
 void soilMoisture() {
-  int value = analogRead(sensor);              // Lee el valor analógico del sensor (0-4095)
-  value = map(value, 0, 4095, 0, 100);          // Convierte a porcentaje del 0% (seco) al 100% (mojado)
-  value = (value - 100) * -1;                   // Invierte para que 0 sea seco y 100 húmedo
+  int value = adc_continuo_valor(&adcSuelo);    // Valor filtrado del sensor (0-4095), sin bloquear
+  humedad = calibracion_entero(&CAL_SUELO, value); // Porcentaje: 0 seco, 100 húmedo
 
-  Blynk.virtualWrite(V0, value);               // Envía el valor a Blynk (al pin virtual V0)
-  Serial.println(value);                       // Imprime el valor en el monitor serial
+  politicaNube.agregar(humedad);               // La política decide si esta muestra viaja
+  if (politicaNube.debePublicar(millis(), Blynk.connected())) {
+    publicarHumedad();
+  }
+}
+
+// Publica en Blynk el lote pendiente (su último valor y, si hizo falta, su resumen)
+// y lo muestra en el monitor serial
+void publicarHumedad() {
+  const LoteMuestras &lote = politicaNube.lote();
+  bool resumen = politicaNube.publicaResumen();
+  if (resumen) Blynk.beginGroup();             // Valor y resumen del lote en un mismo envío
+  if (politicaNube.publicaValor()) {
+    Blynk.virtualWrite(V0, lote.ultimo);       // Envía el valor a Blynk (al pin virtual V0)
+  }
+  if (resumen) {
+    Blynk.virtualWrite(V2, lote.minimo);
+    Blynk.virtualWrite(V3, lote.maximo);
+    Blynk.virtualWrite(V4, lote.promedio());
+    Blynk.endGroup();
+  }
+  politicaNube.confirmar(millis());
+  Serial.println(humedad);                     // Imprime el valor en el monitor serial
+}
 
-  lcd.setCursor(0, 0);                         // Mueve el cursor a la primera línea
-  lcd.print("Moisture : ");                    // Imprime el texto
-  lcd.print(value);                            // Imprime el valor
-  lcd.print("%   ");                           // Imprime el símbolo de porcentaje (con espacio extra para limpiar residuos)
+// Hora UTC en segundos, o 0 si SNTP todavía no sincronizó
+uint32_t horaActual() {
+  time_t t = time(nullptr);
+  return t > (time_t)HORA_VALIDA ? (uint32_t)t : 0;
+}
+
+// Si no había nada atrasado y la nube está conectada, el registro que se acaba de
+// agregar ya llegó en vivo: la subida diferida no lo vuelve a mandar
+void anotarEnHistorial(uint32_t t, bool alDia) {
+  if (alDia && Blynk.connected()) historial.marcarSubido(t);
+}
+
+// Tarea de historial: una muestra de humedad por minuto (en RAM hasta el próximo vaciado)
+void registrarHistorial() {
+  uint32_t t = horaActual();
+  if (!historialListo) return;
+  if (t == 0) {
+    sinHora++;
+    return;
+  }
+  bool alDia = !historial.hayPendientes();
+  historial.agregarMuestra(t, humedad);
+  anotarEnHistorial(t, alDia);
+}
+
+// Tarea de vaciado: graba en flash lo juntado, agrupado en un solo tramo
+void vaciarHistorial() {
+  if (historialListo) historial.vaciar();
+}
+
+// Tarea de subida: con la nube de vuelta, manda el historial atrasado en tandas, cada
+// valor con la hora en que se midió. Una tanda termina en un cambio de segundo para
+// que la marca de subida no deje a medias los registros de un mismo instante.
+void subirHistorial() {
+  if (!historialListo || !Blynk.connected() || !historial.hayPendientes()) return;
+  uint32_t ultimo = 0, enviados = 0;
+  bool grupoAbierto = false;
+  historial.consultar(historial.subidoHasta() + 1, UINT32_MAX, [&](const RegistroHistorial &r) {
+    if (grupoAbierto && r.t != ultimo) {
+      Blynk.endGroup();                        // Cierra el instante anterior
+      grupoAbierto = false;
+      if (enviados >= LOTE_SUBIDA) return false;
+    }
+    if (!grupoAbierto) {
+      Blynk.beginGroup((uint64_t)r.t * 1000);  // Marca de tiempo en ms desde 1970
+      grupoAbierto = true;
+    }
+    Blynk.virtualWrite(r.tipo == TipoRegistro::Muestra ? V0 : V1, r.valor);
+    ultimo = r.t;
+    enviados++;
+    return true;
+  });
+  if (grupoAbierto) Blynk.endGroup();
+  if (enviados > 0) historial.marcarSubido(ultimo);
+}
+
+// Tarea de pantalla: dibuja el contenido completo del LCD en RAM; la tarea de
+// refresco envía solo lo que cambió (normalmente uno o dos dígitos de la humedad)
+void refrescarLCD() {
+  if (!refresco.libre()) return;               // El marco anterior sigue en camino: el próximo lo alcanza
+
+  pantalla.limpiar();                          // Solo RAM: no bloquea como lcd.clear()
+  if (cargando) {
+    pantalla.setCursor(1, 0);
+    pantalla.print("System Loading");          // Texto de la animación de arranque
+    for (int i = 0; i < pasoCarga; i++) {
+      pantalla.setCursor(i, 1);
+      pantalla.print(".");                     // Un punto por paso de la animación
+    }
+  } else {
+    pantalla.setCursor(0, 0);                  // Mueve el cursor a la primera línea
+    pantalla.print("Moisture : ");             // Imprime el texto
+    pantalla.print(humedad);                   // Imprime el valor
+    pantalla.print("%");                       // Imprime el símbolo de porcentaje
+    pantalla.setCursor(0, 1);
+    pantalla.print(motorEncendido ? "Motor is ON" : "Motor is OFF"); // Muestra el estado de la bomba
+  }
+  refresco.publicar();
+}
+
+// Tarea de diagnóstico: reporta la peor latencia de atención del último periodo
+// y cuántas muestras se enviaron o se suprimieron por la política de publicación
+void reportarLatencia() {
+  Serial.print("Latencia max lazo (us): ");
+  Serial.println(esperaMaxUs);
+  esperaMaxUs = 0;
+
+  Serial.print("Nube - enviados: ");
+  Serial.print(politicaNube.enviados());
+  Serial.print(" suprimidos: ");
+  Serial.print(politicaNube.suprimidos());
+  Serial.print(" coalescidos: ");
+  Serial.print(politicaNube.coalescidos());
+  Serial.print(" resumenes: ");
+  Serial.print(politicaNube.resumidos());
+  Serial.print(" caidas: ");
+  Serial.println(politicaNube.caidas());
+
+  if (!historialListo) return;
+  Serial.print("Historial - registros: ");
+  Serial.print(historial.registros());
+  Serial.print(" B/muestra: ");
+  Serial.print(historial.muestras() ? (double)historial.bytesProgramados() / historial.muestras() : 0.0);
+  Serial.print(" amplificacion: ");
+  Serial.print(historial.bytesCodificados() ? (double)historial.bytesProgramados() / historial.bytesCodificados() : 0.0);
+  Serial.print(" atrasado: ");
+  Serial.print(historial.hayPendientes() ? "si" : "no");
+  Serial.print(" sin hora: ");
+  Serial.println(sinHora);
 }
 
 // Función que se ejecuta cuando se presiona el botón en la app de Blynk (V1)
+// El relé se acciona de inmediato; el LCD se actualiza luego en su propia tarea
 BLYNK_WRITE(V1) {
   bool Relay = param.asInt();        // Obtiene el valor del botón (1 = ON, 0 = OFF)
   if (Relay == 1) {
     digitalWrite(relay, LOW);        // Enciende la bomba (LOW = ON en muchos relés)
-    lcd.setCursor(0, 1);
-    lcd.print("Motor is ON ");       // Muestra mensaje en el LCD
   } else {
     digitalWrite(relay, HIGH);       // Apaga la bomba (HIGH = OFF)
-    lcd.setCursor(0, 1);
-    lcd.print("Motor is OFF");       // Muestra mensaje en el LCD
+  }
+  motorEncendido = Relay;
+
+  uint32_t t = horaActual();
+  if (historialListo && t != 0) {
+    bool alDia = !historial.hayPendientes();
+    historial.agregarRele(t, Relay);
+    anotarEnHistorial(t, alDia);
   }
 }
 
-// Función que se ejecuta constantemente
+// Función que se ejecuta constantemente: solo despacha, ninguna tarea bloquea
 void loop() {
-  soilMoisture();  // Llama a la función para leer humedad y actualizar Blynk y LCD
-  Blynk.run();     // Necesario para que Blynk siga funcionando
+  unsigned long ahora = micros();
+  if (ultimoRunUs != 0 && ahora - ultimoRunUs > esperaMaxUs) {
+    esperaMaxUs = ahora - ultimoRunUs;         // Peor espera entre dos atenciones a Blynk
+  }
+  ultimoRunUs = ahora;
+
+  Blynk.run();     // Necesario para que Blynk siga funcionando (atiende los comandos V1)
+  timer.run();     // Ejecuta las tareas cuyo periodo se cumplió
 
-  delay(200);      // Espera 200 ms antes de repetir (puedes mejorar esto usando timer)
+  delay(1);        // Cede la CPU 1 ms: acota la latencia del relé sin girar al 100%
 }
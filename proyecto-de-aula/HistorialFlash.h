@@ -0,0 +1,429 @@
+/*
+ * HISTORIAL DE HUMEDAD Y EVENTOS DEL RELÉ EN FLASH
+ *
+ * Registro solo de agregado (append-only) en un anillo sobre una partición de datos
+ * de la flash, sin sistema de archivos:
+ * - Registros codificados por diferencias con varint. La clave lleva el tipo y el
+ *   cambio del intervalo respecto del registro anterior (diferencia de diferencias):
+ *   con muestras a ritmo fijo vale 0. Una muestra agrega la diferencia de humedad en
+ *   zigzag. Con una muestra por minuto y cambios chicos, 2 bytes por muestra.
+ * - Páginas de 256 bytes con una cabecera (secuencia y estado del codificador al
+ *   empezar) que las hace legibles por separado. Los registros se juntan en RAM y se
+ *   graban en tramos [largo][crc8][datos] que se agregan a la página abierta; un
+ *   tramo cortado por un corte de luz no pasa el CRC y se ignora.
+ * - Desgaste parejo: las páginas se usan en orden circular y cada sector (4 KB) se
+ *   borra solo cuando la escritura vuelve a él, con lo que todos se borran la misma
+ *   cantidad de veces. Lo más viejo se pisa primero.
+ * - Índice en RAM con la secuencia y el tiempo inicial de cada sector: una consulta
+ *   por rango de tiempo busca el sector por bisección y lee solo desde ahí.
+ * - Marca de subida: hasta qué instante el historial ya está en la nube. Viaja en el
+ *   mismo registro (como un registro más) y se recupera al montar.
+ *
+ * Usa la API de particiones de ESP-IDF; en Linux la emula la simulación de host
+ * (simulacion-host), que cuenta bytes programados y borrados por sector.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_partition.h"
+
+enum class TipoRegistro : uint8_t { Muestra = 0, ReleApagado = 1, ReleEncendido = 2, MarcaSubida = 3 };
+
+struct RegistroHistorial {
+  uint32_t t;          // Segundos desde 1970 (UTC)
+  TipoRegistro tipo;
+  int32_t valor;       // Humedad en %; 0/1 en el relé; en una marca, el instante subido
+};
+
+class HistorialFlash {
+ public:
+  static constexpr uint32_t PAGINA = 256;
+  static constexpr uint32_t SECTOR = 4096;
+  static constexpr uint32_t PAGINAS_SECTOR = SECTOR / PAGINA;
+  static constexpr uint32_t MAX_SECTORES = 512;  // Hasta 2 MB de partición
+  static constexpr uint32_t CABECERA = 16;
+  static constexpr uint32_t MAX_TRAMO = PAGINA - CABECERA - 2;
+
+  // Lee los índices y retoma el registro donde quedó. false si la partición no sirve.
+  bool montar(const esp_partition_t *particion) {
+    if (!particion || particion->size < 2 * SECTOR) return false;
+    part_ = particion;
+    sectores_ = particion->size / SECTOR;
+    if (sectores_ > MAX_SECTORES) sectores_ = MAX_SECTORES;
+
+    int32_t cabeza = -1;
+    for (uint32_t s = 0; s < sectores_; s++) {
+      Cabecera c;
+      indice_[s] = {VACIA, 0};
+      if (!leerCabecera(s * PAGINAS_SECTOR, c)) continue;
+      indice_[s] = {c.secuencia, c.inicio.t};
+      if (cabeza < 0 || c.secuencia > indice_[cabeza].secuencia) cabeza = (int32_t)s;
+    }
+    cabeza_ = cabeza < 0 ? 0 : (uint32_t)cabeza;
+    pagina_ = -1;
+    pendienteLargo_ = 0;
+    ultimo_ = {0, 0, 0};
+    subido_ = 0;
+    if (cabeza < 0) {
+      siguiente_ = 0;
+      secuencia_ = 0;
+      tramo_ = ultimo_;
+      subidoEscrito_ = subido_;
+      return true;
+    }
+
+    // Última página escrita del sector más nuevo; las escrituras siguen en una nueva
+    // (la última pudo quedar con un tramo a medias)
+    uint32_t ultima = cabeza_ * PAGINAS_SECTOR;
+    uint32_t secuencia = indice_[cabeza_].secuencia;
+    Cabecera c;
+    while ((ultima + 1) % PAGINAS_SECTOR != 0 && leerCabecera(ultima + 1, c) && c.secuencia == secuencia + 1) {
+      ultima++;
+      secuencia++;
+    }
+    secuencia_ = secuencia + 1;
+    siguiente_ = (ultima + 1) % paginas();
+    recorrerPagina(ultima, ultimo_, [](const RegistroHistorial &) { return true; });
+    tramo_ = ultimo_;
+
+    // Marca de subida: la última del registro, buscando desde lo más nuevo
+    for (uint32_t p = ultima, n = 0; n < paginas(); n++, secuencia--) {
+      if (!leerCabecera(p, c) || c.secuencia != secuencia) break;
+      Estado e;
+      bool hallada = false;
+      recorrerPagina(p, e, [&](const RegistroHistorial &r) {
+        if (r.tipo == TipoRegistro::MarcaSubida) {
+          subido_ = (uint32_t)r.valor;
+          hallada = true;
+        }
+        return true;
+      });
+      if (hallada || secuencia == 0) break;
+      p = (p + paginas() - 1) % paginas();
+    }
+    subidoEscrito_ = subido_;
+    return true;
+  }
+
+  void agregarMuestra(uint32_t t, int32_t humedad) {
+    uint8_t b[10];
+    Estado e = ultimo_;
+    size_t n = clave(b, e, t, TipoRegistro::Muestra);
+    n += varint(b + n, zigzag(humedad - e.v));
+    e.v = humedad;
+    agregar(b, n, e);
+    muestras_++;
+  }
+
+  void agregarRele(uint32_t t, bool encendido) {
+    uint8_t b[5];
+    Estado e = ultimo_;
+    size_t n = clave(b, e, t, encendido ? TipoRegistro::ReleEncendido : TipoRegistro::ReleApagado);
+    agregar(b, n, e);
+  }
+
+  // Graba lo juntado en RAM (y la marca de subida si avanzó)
+  void vaciar() {
+    if (pendienteLargo_ == 0 && subido_ == subidoEscrito_) return;
+    escribirTramo();
+  }
+
+  // -----------------------------------------------------------------------------
+  // Entrega a fn(const RegistroHistorial &) los registros con t en [desde, hasta],
+  // en orden, incluidos los que todavía están en RAM; fn devuelve false para cortar.
+  // Las marcas de subida no se entregan. Devuelve cuántos registros entregó.
+  // -----------------------------------------------------------------------------
+  template <typename F>
+  uint32_t consultar(uint32_t desde, uint32_t hasta, F fn) const {
+    uint32_t entregados = 0;
+    auto filtro = [&](const RegistroHistorial &r) {
+      if (r.t > hasta) return false;
+      if (r.t < desde || r.tipo == TipoRegistro::MarcaSubida) return true;
+      entregados++;
+      return fn(r);
+    };
+
+    // Sectores con datos, del más viejo al más nuevo: son contiguos en el anillo
+    uint32_t viejo = 0, validos = 0;
+    for (uint32_t i = 1; i <= sectores_; i++) {
+      uint32_t s = (cabeza_ + i) % sectores_;
+      if (indice_[s].secuencia == VACIA) continue;
+      if (validos++ == 0) viejo = s;
+    }
+    bool seguir = true;
+    if (validos > 0) {
+      // Último sector que empieza antes de 'desde': los anteriores terminan antes
+      uint32_t lo = 0, hi = validos;
+      while (hi - lo > 1) {
+        uint32_t medio = (lo + hi) / 2;
+        if (indice_[(viejo + medio) % sectores_].t0 < desde) lo = medio;
+        else hi = medio;
+      }
+      uint32_t p = (viejo + lo) % sectores_ * PAGINAS_SECTOR;
+      uint32_t secuencia = indice_[p / PAGINAS_SECTOR].secuencia;
+      Cabecera c;
+      while (seguir && leerCabecera(p, c) && c.secuencia == secuencia) {
+        Estado e;
+        seguir = recorrerPagina(p, e, filtro);
+        if ((int32_t)p == pagina_) break;
+        p = (p + 1) % paginas();
+        secuencia++;
+      }
+    }
+    if (seguir) {
+      Estado e = tramo_;
+      decodificarTramo(pendiente_, pendienteLargo_, e, filtro);
+    }
+    return entregados;
+  }
+
+  // --- Subida a la nube ---
+  uint32_t subidoHasta() const { return subido_; }
+  void marcarSubido(uint32_t t) { subido_ = t; }
+  bool hayPendientes() const { return ultimo_.t > subido_; }
+
+  // --- Estadísticas desde el arranque ---
+  uint32_t muestras() const { return muestras_; }
+  uint32_t registros() const { return registros_; }
+  uint32_t bytesCodificados() const { return bytesCodificados_; }  // Solo los registros
+  uint32_t bytesProgramados() const { return bytesProgramados_; }  // Con cabeceras y tramos
+  uint32_t borrados() const { return borrados_; }
+  uint32_t pendientesRam() const { return pendienteLargo_; }
+
+ private:
+  static constexpr uint32_t VACIA = 0xFFFFFFFF;
+  static constexpr uint16_t MAGIA = 0x4853;  // "SH"
+  static constexpr uint8_t VERSION = 1;
+  static constexpr uint32_t MAX_INTERVALO = 0xFFFF;
+
+  // Estado del codificador: lo necesario para decodificar lo que sigue
+  struct Estado {
+    uint32_t t;    // Instante del último registro
+    int32_t v;     // Última humedad
+    uint32_t dt;   // Último intervalo entre registros (hasta MAX_INTERVALO)
+  };
+
+  // [magia u16][crc8][versión][secuencia u32][t u32][dt u16][v i16]
+  struct Cabecera {
+    uint32_t secuencia;
+    Estado inicio;  // Estado antes del primer registro de la página
+  };
+
+  struct EntradaIndice {
+    uint32_t secuencia;
+    uint32_t t0;
+  };
+
+  uint32_t paginas() const { return sectores_ * PAGINAS_SECTOR; }
+
+  static uint8_t crc8(const uint8_t *d, size_t n, uint8_t crc = 0) {
+    while (n--) {
+      crc ^= *d++;
+      for (int i = 0; i < 8; i++) crc = (uint8_t)(crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc;
+  }
+
+  static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+  static int32_t deszigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+  static size_t varint(uint8_t *b, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+      b[n++] = (uint8_t)(v | 0x80);
+      v >>= 7;
+    }
+    b[n++] = (uint8_t)v;
+    return n;
+  }
+
+  static bool leerVarint(const uint8_t *b, size_t n, size_t &i, uint64_t &v) {
+    v = 0;
+    for (int corrimiento = 0; i < n && corrimiento < 64; corrimiento += 7) {
+      uint8_t x = b[i++];
+      v |= (uint64_t)(x & 0x7F) << corrimiento;
+      if (!(x & 0x80)) return true;
+    }
+    return false;
+  }
+
+  static void avanzar(Estado &e, uint32_t dt) {
+    e.t += dt;
+    e.dt = dt < MAX_INTERVALO ? dt : MAX_INTERVALO;
+  }
+
+  // Clave de un registro con tiempo: cambio del intervalo y tipo. El reloj puede
+  // retroceder (resincronización SNTP): el registro queda con el instante anterior.
+  static size_t clave(uint8_t *b, Estado &e, uint32_t t, TipoRegistro tipo) {
+    uint32_t dt = t > e.t ? t - e.t : 0;
+    uint64_t k = (uint64_t)zigzag((int32_t)(dt - e.dt)) << 2 | (uint32_t)tipo;
+    avanzar(e, dt);
+    return varint(b, k);
+  }
+
+  // El estado avanza recién después de cerrar el tramo anterior: la cabecera de una
+  // página nueva tiene que quedar con el estado previo al registro
+  void agregar(const uint8_t *b, size_t n, const Estado &despues) {
+    if (pendienteLargo_ + n > capacidad()) {
+      escribirTramo();
+      abrirPagina();
+    }
+    memcpy(pendiente_ + pendienteLargo_, b, n);
+    pendienteLargo_ += n;
+    ultimo_ = despues;
+    bytesCodificados_ += n;
+    registros_++;
+  }
+
+  // Lugar para el tramo pendiente en la página abierta (o en una nueva)
+  uint32_t capacidad() const {
+    if (pagina_ < 0) return MAX_TRAMO;
+    return libre_ + 2 < PAGINA ? PAGINA - libre_ - 2 : 0;
+  }
+
+  // La cabecera lleva el estado al comienzo del tramo pendiente, que será el primero
+  // de la página
+  void abrirPagina() {
+    uint32_t p = siguiente_;
+    uint32_t s = p / PAGINAS_SECTOR;
+    if (p % PAGINAS_SECTOR == 0) {
+      esp_partition_erase_range(part_, s * SECTOR, SECTOR);  // Se pisa el sector más viejo
+      borrados_++;
+      indice_[s] = {secuencia_, tramo_.t};
+      cabeza_ = s;
+    }
+    uint8_t c[CABECERA];
+    uint16_t dt = (uint16_t)tramo_.dt;
+    int16_t v = (int16_t)tramo_.v;
+    c[0] = (uint8_t)MAGIA;
+    c[1] = (uint8_t)(MAGIA >> 8);
+    c[2] = 0;
+    c[3] = VERSION;
+    memcpy(c + 4, &secuencia_, 4);
+    memcpy(c + 8, &tramo_.t, 4);
+    memcpy(c + 12, &dt, 2);
+    memcpy(c + 14, &v, 2);
+    c[2] = crc8(c, CABECERA);
+    esp_partition_write(part_, p * PAGINA, c, CABECERA);
+    bytesProgramados_ += CABECERA;
+
+    pagina_ = (int32_t)p;
+    libre_ = CABECERA;
+    secuencia_++;
+    siguiente_ = (p + 1) % paginas();
+  }
+
+  void escribirTramo() {
+    // La marca de subida va al final del tramo si entra; si no, en el próximo. No
+    // tiene tiempo propio (es el del registro anterior) ni cambia el estado.
+    if (subido_ != subidoEscrito_) {
+      uint8_t b[6];
+      size_t n = varint(b, (uint32_t)TipoRegistro::MarcaSubida);
+      n += varint(b + n, ultimo_.t > subido_ ? ultimo_.t - subido_ : 0);
+      if (pendienteLargo_ + n <= capacidad()) {
+        memcpy(pendiente_ + pendienteLargo_, b, n);
+        pendienteLargo_ += n;
+        subidoEscrito_ = subido_;
+      }
+    }
+    if (pendienteLargo_ == 0) return;
+    if (pagina_ < 0) abrirPagina();
+
+    uint8_t tramo[PAGINA];
+    tramo[0] = (uint8_t)pendienteLargo_;
+    tramo[1] = crc8(pendiente_, pendienteLargo_);
+    memcpy(tramo + 2, pendiente_, pendienteLargo_);
+    esp_partition_write(part_, pagina_ * PAGINA + libre_, tramo, pendienteLargo_ + 2);
+    bytesProgramados_ += pendienteLargo_ + 2;
+    libre_ += pendienteLargo_ + 2;
+    pendienteLargo_ = 0;
+    tramo_ = ultimo_;
+  }
+
+  static bool cabeceraValida(const uint8_t *b, Cabecera &c) {
+    uint8_t copia[CABECERA];
+    memcpy(copia, b, CABECERA);
+    copia[2] = 0;
+    if ((b[0] | b[1] << 8) != MAGIA || b[3] != VERSION || crc8(copia, CABECERA) != b[2]) return false;
+    uint16_t dt;
+    int16_t v;
+    memcpy(&c.secuencia, b + 4, 4);
+    memcpy(&c.inicio.t, b + 8, 4);
+    memcpy(&dt, b + 12, 2);
+    memcpy(&v, b + 14, 2);
+    c.inicio.dt = dt;
+    c.inicio.v = v;
+    return true;
+  }
+
+  bool leerCabecera(uint32_t pagina, Cabecera &c) const {
+    uint8_t b[CABECERA];
+    if (esp_partition_read(part_, pagina * PAGINA, b, CABECERA) != ESP_OK) return false;
+    return cabeceraValida(b, c);
+  }
+
+  // Recorre los registros de una página; deja en e el estado al final. false si fn cortó.
+  template <typename F>
+  bool recorrerPagina(uint32_t pagina, Estado &e, F fn) const {
+    uint8_t b[PAGINA];
+    Cabecera c;
+    if (esp_partition_read(part_, pagina * PAGINA, b, PAGINA) != ESP_OK || !cabeceraValida(b, c)) return true;
+    e = c.inicio;
+    for (uint32_t i = CABECERA; i + 2 <= PAGINA && b[i] != 0xFF;) {
+      uint32_t largo = b[i];
+      // Tramo cortado: es el último de la página, lo que sigue no se escribió
+      if (largo == 0 || i + 2 + largo > PAGINA || crc8(b + i + 2, largo) != b[i + 1]) break;
+      if (!decodificarTramo(b + i + 2, largo, e, fn)) return false;
+      i += 2 + largo;
+    }
+    return true;
+  }
+
+  template <typename F>
+  static bool decodificarTramo(const uint8_t *b, size_t n, Estado &e, F fn) {
+    size_t i = 0;
+    while (i < n) {
+      uint64_t k, x = 0;
+      if (!leerVarint(b, n, i, k)) return true;
+      TipoRegistro tipo = (TipoRegistro)(k & 3);
+      if ((tipo == TipoRegistro::Muestra || tipo == TipoRegistro::MarcaSubida) && !leerVarint(b, n, i, x)) return true;
+      RegistroHistorial r{e.t, tipo, 0};
+      if (tipo == TipoRegistro::MarcaSubida) {
+        r.valor = (int32_t)(e.t - (uint32_t)x);
+      } else {
+        avanzar(e, e.dt + (uint32_t)deszigzag((uint32_t)(k >> 2)));
+        r.t = e.t;
+        if (tipo == TipoRegistro::Muestra) r.valor = e.v += deszigzag((uint32_t)x);
+        else r.valor = tipo == TipoRegistro::ReleEncendido;
+      }
+      if (!fn(r)) return false;
+    }
+    return true;
+  }
+
+  const esp_partition_t *part_ = nullptr;
+  uint32_t sectores_ = 0;
+  uint32_t cabeza_ = 0;        // Sector más nuevo
+  EntradaIndice indice_[MAX_SECTORES];
+
+  int32_t pagina_ = -1;        // Página abierta (-1: ninguna desde el montaje)
+  uint32_t libre_ = 0;         // Primer byte libre de la página abierta
+  uint32_t siguiente_ = 0;     // Próxima página a abrir
+  uint32_t secuencia_ = 0;
+
+  Estado ultimo_ = {0, 0, 0};  // Tras el último registro (incluido lo pendiente)
+  Estado tramo_ = {0, 0, 0};   // Al comienzo del tramo pendiente
+  uint8_t pendiente_[MAX_TRAMO];
+  uint32_t pendienteLargo_ = 0;
+
+  uint32_t subido_ = 0;
+  uint32_t subidoEscrito_ = 0;
+
+  uint32_t muestras_ = 0;
+  uint32_t registros_ = 0;
+  uint32_t bytesCodificados_ = 0;
+  uint32_t bytesProgramados_ = 0;
+  uint32_t borrados_ = 0;
+};
@@ -0,0 +1,145 @@
+/*
+ * POLÍTICA DE PUBLICACIÓN DE LA HUMEDAD HACIA BLYNK
+ *
+ * Decide cuándo vale la pena enviar una muestra a la nube:
+ * - Banda muerta: solo se publica si el valor cambió al menos 'bandaMuerta' puntos.
+ * - Intervalo mínimo: nunca se publica más seguido que 'intervaloMinMs'.
+ * - Latido (heartbeat): se publica aunque no haya cambios cada 'intervaloMaxMs'.
+ * - Lote: las muestras entre dos publicaciones se resumen (mínimo, máximo y
+ *   promedio). Si el lote tuvo una excursión mayor a la banda, el resumen viaja
+ *   aunque el último valor haya regresado al publicado.
+ * - Enlace inestable o caído: las muestras se acumulan (coalescen) en un solo lote
+ *   y cada caída de la conexión duplica el intervalo mínimo; cada publicación sin
+ *   caídas de por medio lo recupera a la mitad.
+ *
+ * No depende de Arduino: se puede compilar y medir en Linux.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+struct ConfigPublicacion {
+  int bandaMuerta = 2;                // Cambio mínimo (en %) para publicar
+  unsigned long intervaloMinMs = 1000;  // Separación mínima entre publicaciones
+  unsigned long intervaloMaxMs = 60000; // Latido: publicación forzada sin cambios
+  uint8_t factorMaxLento = 8;           // Máximo alargamiento del intervalo mínimo por caídas
+};
+
+// Resumen de las muestras coalescidas desde la última publicación
+struct LoteMuestras {
+  int ultimo = 0;
+  int minimo = 0;
+  int maximo = 0;
+  long suma = 0;
+  uint32_t cantidad = 0;
+
+  int promedio() const { return cantidad ? (int)(suma / (long)cantidad) : ultimo; }
+};
+
+class PoliticaPublicacion {
+ public:
+  explicit PoliticaPublicacion(const ConfigPublicacion &config = ConfigPublicacion()) : config_(config) {}
+
+  // Registra una muestra nueva en el lote pendiente
+  void agregar(int valor) {
+    if (lote_.cantidad == 0) {
+      lote_.minimo = lote_.maximo = valor;
+    } else {
+      if (valor < lote_.minimo) lote_.minimo = valor;
+      if (valor > lote_.maximo) lote_.maximo = valor;
+    }
+    lote_.ultimo = valor;
+    lote_.suma += valor;
+    lote_.cantidad++;
+    muestras_++;
+  }
+
+  // true si el lote pendiente debe publicarse ahora; qué parte viaja lo dicen
+  // publicaValor() y publicaResumen(). 'enlaceListo' es el estado de la conexión.
+  bool debePublicar(unsigned long ahoraMs, bool enlaceListo) {
+    if (!enlaceListo) {
+      // Una caída (conectado -> desconectado) alarga el intervalo mínimo
+      if (enlaceAnterior_) {
+        caidas_++;
+        caidaDesdeEnvio_ = true;
+        if (factorLento_ < config_.factorMaxLento) factorLento_ *= 2;
+      }
+      enlaceAnterior_ = false;
+      huboCaida_ = lote_.cantidad > 0;  // Sin enlace: las muestras se siguen coalesciendo
+      return false;
+    }
+    enlaceAnterior_ = true;
+    valor_ = resumen_ = false;
+    if (lote_.cantidad == 0) return false;
+    if (!publicadoAlgunaVez_) return valor_ = true;
+
+    unsigned long transcurrido = ahoraMs - ultimoEnvioMs_;
+    if (transcurrido < config_.intervaloMinMs * factorLento_) return false;
+
+    int cambio = lote_.ultimo - ultimoPublicado_;
+    if (cambio < 0) cambio = -cambio;
+    valor_ = cambio >= config_.bandaMuerta || transcurrido >= config_.intervaloMaxMs;  // Cambio o latido
+
+    // El lote tuvo una excursión mayor a la banda: su resumen viaja aunque el último
+    // valor haya regresado al publicado
+    resumen_ = lote_.cantidad > 1 && lote_.maximo - lote_.minimo >= config_.bandaMuerta;
+    return valor_ || resumen_;
+  }
+
+  // Qué publicar, según el último debePublicar() que devolvió true
+  bool publicaValor() const { return valor_; }      // lote().ultimo
+  bool publicaResumen() const { return resumen_; }  // lote().minimo, maximo y promedio()
+
+  // Lote que se va a publicar
+  const LoteMuestras &lote() const { return lote_; }
+
+  // Confirma la publicación del lote
+  void confirmar(unsigned long ahoraMs) {
+    enviados_++;
+    if (resumen_) resumidos_++;
+    if (!valor_) suprimidos_ += lote_.cantidad;  // Solo viajó el resumen
+    else suprimidos_ += lote_.cantidad - 1;      // Las demás muestras del lote no viajaron
+    if (huboCaida_) coalescidos_++;
+    huboCaida_ = false;
+
+    if (valor_) ultimoPublicado_ = lote_.ultimo;
+    ultimoEnvioMs_ = ahoraMs;
+    publicadoAlgunaVez_ = true;
+    lote_ = LoteMuestras();
+    valor_ = resumen_ = false;
+
+    // Sin caídas desde la publicación anterior: el intervalo se recupera gradualmente
+    if (!caidaDesdeEnvio_ && factorLento_ > 1) factorLento_ /= 2;
+    caidaDesdeEnvio_ = false;
+  }
+
+  // Contadores para comprobar la reducción de tráfico
+  uint32_t muestras() const { return muestras_; }
+  uint32_t enviados() const { return enviados_; }
+  uint32_t suprimidos() const { return suprimidos_; }
+  uint32_t coalescidos() const { return coalescidos_; }
+  uint32_t resumidos() const { return resumidos_; }
+  uint32_t caidas() const { return caidas_; }
+  uint8_t factorLento() const { return factorLento_; }
+
+ private:
+  ConfigPublicacion config_;
+  LoteMuestras lote_;
+  int ultimoPublicado_ = 0;
+  unsigned long ultimoEnvioMs_ = 0;
+  bool publicadoAlgunaVez_ = false;
+  bool huboCaida_ = false;
+  bool enlaceAnterior_ = false;
+  bool caidaDesdeEnvio_ = false;
+  bool valor_ = false;
+  bool resumen_ = false;
+  uint8_t factorLento_ = 1;
+
+  uint32_t muestras_ = 0;
+  uint32_t enviados_ = 0;
+  uint32_t suprimidos_ = 0;
+  uint32_t coalescidos_ = 0;  // Publicaciones que resumieron una caída del enlace
+  uint32_t resumidos_ = 0;    // Publicaciones que llevaron el resumen del lote
+  uint32_t caidas_ = 0;       // Caídas de la conexión observadas
+};
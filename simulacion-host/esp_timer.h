@@ -0,0 +1,3 @@
+// Encabezado de simulación en host: ver hal_host.h
+#pragma once
+#include "hal_host.h"
@@ -0,0 +1,2240 @@
+/*
+ * CAPA DE ABSTRACCIÓN DE HARDWARE (HAL) PARA SIMULACIÓN EN LINUX
+ *
+ * Reemplaza las APIs de Arduino-ESP32 3.1 (ESP-IDF 5.3), Blynk y las librerías de
+ * pantallas (LCD I2C, OLED SSD1306) y del DHT22 por implementaciones de host. Solo
+ * modela las APIs de esa versión del core, la que fija ConfigPlatformINI.txt: un
+ * sketch que use las de 2.x (ledcSetup, timerAlarmWrite, driver/rmt.h...) no compila.
+ * - Tiempo simulado: cada operación de hardware consume un costo modelado.
+ * - Entradas guionadas: ADC, GPIO, touch, UART, Blynk, ESP-NOW y DHT; los cambios
+ *   de GPIO y touch disparan las interrupciones que el programa haya registrado.
+ * - Reposo: despertares de la CPU y tiempo en sueño ligero (esp_pm_configure).
+ * - Contadores de bytes emitidos por I2C, UART, radio (ESP-NOW) y nube (Blynk).
+ *
+ * Los sketches se compilan sin cambios contra estos encabezados (ver main_host.cpp).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <ctype.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ==================== NÚCLEO DE LA SIMULACIÓN ====================
+namespace hal {
+
+// Se lanza cuando el tiempo simulado alcanza el límite: termina setup()/loop()/app_main()
+struct FinSimulacion {};
+
+// Costos modelados de cada operación (microsegundos de CPU del ESP32)
+constexpr uint64_t COSTO_ADC_US = 10;         // Una conversión SAR de 12 bits
+constexpr uint64_t COSTO_GPIO_US = 1;         // Lectura/escritura de un pin
+constexpr uint64_t COSTO_TOUCH_US = 500;      // Medición de un pad táctil (modo SW)
+constexpr uint64_t COSTO_LEDC_US = 2;         // Actualización del duty de LEDC
+constexpr uint64_t COSTO_BYTE_UART_US = 1;    // Copiar un byte a la FIFO o al buffer TX del driver
+constexpr uint64_t COSTO_ESPNOW_US = 100;     // Encolar una trama en la pila WiFi
+constexpr uint64_t COSTO_BLYNK_US = 300;      // Armar y enviar un mensaje por TCP
+constexpr uint64_t COSTO_DHT_US = 5000;       // Lectura bit-bang del DHT22
+constexpr uint64_t COSTO_BORRADO_US = 45000;  // Borrado de un sector de flash (4 KB, típico)
+constexpr uint64_t COSTO_PAGINA_US = 700;     // Programación de una página de flash (256 B)
+constexpr uint64_t LATENCIA_RADIO_US = 1000;  // Del envío al callback OnDataSent
+constexpr uint64_t MIN_SUENO_LIGERO_US = 30000;  // CONFIG_FREERTOS_IDLE_TIME_BEFORE_SLEEP (3 ticks)
+
+// Tiempo simulado y su reparto entre trabajo (ocupado) y espera (dormido)
+inline uint64_t reloj_us = 0;
+inline uint64_t limite_us = UINT64_MAX;
+inline uint64_t us_ocupado = 0;
+inline uint64_t us_dormido = 0;
+inline uint64_t us_sueno_ligero = 0;  // Parte de us_dormido con el chip en sueño ligero
+
+// Gestión de energía: sueño ligero automático (esp_pm_configure) y candados que lo
+// impiden mientras un periférico necesita el reloj (por ejemplo el ADC continuo)
+inline bool sueno_ligero = false;
+inline int candados_pm = 0;
+
+// Bytes y mensajes emitidos por cada bus
+struct Contadores {
+  uint64_t bytes_i2c = 0;
+  uint64_t transacciones_i2c = 0;
+  uint64_t bytes_uart = 0;
+  uint64_t bytes_uart_rx = 0;          // Bytes llegados a un driver UART instalado
+  uint64_t bytes_uart_perdidos = 0;    // Descartados por buffer de recepción lleno
+  uint64_t bytes_radio = 0;
+  uint64_t tramas_radio = 0;
+  uint64_t tramas_radio_fallidas = 0;  // Envíos sin confirmación (OnDataSent con FAIL)
+  uint64_t bytes_nube = 0;
+  uint64_t mensajes_nube = 0;
+  uint64_t valores_historicos = 0;     // Valores enviados a la nube con marca de tiempo (beginGroup)
+  uint64_t despertares = 0;     // Veces que la CPU ociosa volvió a trabajar (evento o timeout)
+  uint64_t interrupciones = 0;  // ISR de GPIO, touch, UART, RMT y temporizadores atendidas
+};
+inline Contadores contadores;
+
+// true = la salida de los sketches se copia a stdout
+inline bool eco = true;
+
+// Estado de las entradas guionadas
+inline int adc_gpio[40] = {};                 // Valor crudo del ADC por GPIO
+inline int ruido_adc[40] = {};                // Amplitud del ruido uniforme sumado a cada lectura
+inline int nivel_gpio[40] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+                             1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+inline uint16_t touch_pad[10] = {1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000};
+inline std::string rx_uart[3];                // Bytes pendientes de leer por UART
+
+// Lado de transmisión de cada UART (ver salidaUART)
+constexpr size_t UART_FIFO_TX = 128;
+struct LineaUart {
+  int baudios = 115200;
+  bool driver = false;
+  size_t buffer_tx = 0;  // 0: uart_write_bytes no vuelve hasta que todo pasó a la FIFO
+  uint64_t fin_us = 0;   // Cuándo termina de salir por la línea lo ya escrito
+};
+inline LineaUart lineas_uart[3];
+inline float dht_temperatura = 25.0f;
+inline float dht_humedad = 50.0f;
+inline int dht_corruptas = 0;                 // Porcentaje de tramas del DHT22 (por RMT) con un bit invertido
+inline bool radio_falla = false;              // true = los envíos ESP-NOW fallan
+inline int radio_perdida = 0;                 // Porcentaje de envíos que se pierden al azar
+inline uint64_t latencia_radio_us = LATENCIA_RADIO_US;
+inline bool nube_conectada = true;
+
+// Salidas registradas
+inline int duty_ledc[40] = {};               // Duty del LEDC por GPIO
+inline uint8_t bits_ledc[40] = {};            // Resolución por GPIO (0 = sin canal asignado)
+inline uint32_t i2c_hz = 100000;
+
+// Eventos ordenados por tiempo (guion y eventos internos como OnDataSent o tramas DMA)
+inline std::multimap<uint64_t, std::function<void()>> eventos;
+inline bool aplicando = false;  // true mientras corre un evento (contexto de ISR)
+
+// Se invoca en cada punto de cesión de la tarea principal (fin de loop() o vTaskDelay)
+inline std::function<void()> alCeder;
+
+inline void programar(uint64_t t_us, std::function<void()> accion) {
+  eventos.emplace(t_us, std::move(accion));
+}
+
+// Ejecuta los eventos vencidos (sin anidar: un callback no dispara otro callback)
+inline void aplicarEventos() {
+  if (aplicando) return;
+  aplicando = true;
+  while (!eventos.empty() && eventos.begin()->first <= reloj_us) {
+    auto accion = std::move(eventos.begin()->second);
+    eventos.erase(eventos.begin());
+    accion();
+  }
+  aplicando = false;
+}
+
+// ==================== TAREAS (FREERTOS COOPERATIVO) ====================
+// Cada tarea de FreeRTOS corre en un hilo del host, pero solo una a la vez: la que
+// tiene el testigo. Las tareas se alternan en las llamadas bloqueantes (vTaskDelay,
+// esperas de notificaciones, colas o UART) y cuando un evento (ISR) despierta a una
+// tarea de mayor prioridad. Así el reparto de CPU sigue siendo determinista.
+struct Tarea {
+  std::string nombre = "main";     // crearTarea() pone el suyo a las demás
+  int prioridad = 1;
+  uint64_t despertar = 0;          // Instante en que vence su espera (0 = lista)
+  std::function<bool()> condicion; // Condición que la desbloquea antes (cola, notificación)
+  uint32_t notificacion = 0;       // Valor de notificación de la tarea
+  bool notificada = false;         // Hay una notificación pendiente (xTaskNotifyWait)
+  bool terminada = false;
+  std::condition_variable cv;
+};
+
+inline std::mutex mtx_testigo;
+inline Tarea principal;
+inline std::vector<Tarea *> tareas{&principal};
+inline Tarea *actual = &principal;
+inline bool fin = false;
+
+inline bool estaLista(Tarea *t) {
+  return !t->terminada && (t->despertar <= reloj_us || (t->condicion && t->condicion()));
+}
+
+// Tarea lista de mayor prioridad; a igual prioridad, la siguiente después de 'yo'
+inline Tarea *elegirLista(Tarea *yo) {
+  Tarea *elegida = nullptr;
+  size_t inicio = 0;
+  for (size_t i = 0; i < tareas.size(); i++) {
+    if (tareas[i] == yo) inicio = i + 1;
+  }
+  for (size_t k = 0; k < tareas.size(); k++) {
+    Tarea *t = tareas[(inicio + k) % tareas.size()];
+    if (estaLista(t) && (!elegida || t->prioridad > elegida->prioridad)) elegida = t;
+  }
+  return elegida;
+}
+
+// Entrega el testigo a 'otra' y espera a recuperarlo (si 'yo' sigue viva)
+inline void cambiarA(Tarea *yo, Tarea *otra) {
+  std::unique_lock<std::mutex> lk(mtx_testigo);
+  actual = otra;
+  otra->cv.notify_one();
+  if (yo->terminada) return;
+  yo->cv.wait(lk, [yo] { return actual == yo; });
+  if (fin && yo == &principal) throw FinSimulacion{};
+}
+
+// Avanza el reloj hasta 'hasta_us' aplicando los eventos que venzan en el camino
+inline void avanzarReloj(uint64_t hasta_us, bool dormido) {
+  if (hasta_us > limite_us) hasta_us = limite_us;
+  while (!aplicando && !eventos.empty() && eventos.begin()->first <= hasta_us) {
+    uint64_t t = eventos.begin()->first;
+    if (t > reloj_us) {
+      (dormido ? us_dormido : us_ocupado) += t - reloj_us;
+      reloj_us = t;
+    }
+    aplicarEventos();
+    if (dormido) return;  // El planificador reevalúa qué tarea quedó lista
+  }
+  if (hasta_us > reloj_us) {
+    (dormido ? us_dormido : us_ocupado) += hasta_us - reloj_us;
+    reloj_us = hasta_us;
+  }
+  if (reloj_us >= limite_us) throw FinSimulacion{};
+}
+
+// Bloquea la tarea actual hasta 'hasta_us' o hasta que se cumpla 'condicion';
+// mientras tanto corren las demás tareas o, si ninguna está lista, la CPU queda ociosa
+inline void bloquear(uint64_t hasta_us, std::function<bool()> condicion = nullptr) {
+  Tarea *yo = actual;
+  yo->despertar = hasta_us;
+  yo->condicion = std::move(condicion);
+  Tarea *elegida;
+  while (!(elegida = elegirLista(yo))) {
+    uint64_t t = limite_us;
+    for (Tarea *o : tareas) {
+      if (!o->terminada && o->despertar < t) t = o->despertar;
+    }
+    if (!eventos.empty() && eventos.begin()->first < t) t = eventos.begin()->first;
+    // Con el sueño ligero automático habilitado el chip duerme si la espera es larga,
+    // después de que las UART terminen de transmitir (ESP-IDF las vacía antes de dormir)
+    uint64_t desde = reloj_us;
+    for (const LineaUart &l : lineas_uart) desde = std::max(desde, l.fin_us);
+    if (sueno_ligero && candados_pm == 0 && t >= desde + MIN_SUENO_LIGERO_US) us_sueno_ligero += t - desde;
+    avanzarReloj(t, true);
+    contadores.despertares++;
+  }
+  if (elegida != yo) cambiarA(yo, elegida);
+  yo->despertar = 0;
+  yo->condicion = nullptr;
+}
+
+// Si un evento dejó lista a una tarea de mayor prioridad, esta la desaloja
+inline void desalojar() {
+  if (aplicando) return;
+  Tarea *yo = actual;
+  for (Tarea *t : tareas) {
+    if (t != yo && t->prioridad > yo->prioridad && estaLista(t)) {
+      yo->despertar = 0;  // Sigue lista: retoma cuando la otra se bloquee
+      cambiarA(yo, t);
+      return;
+    }
+  }
+}
+
+// Consume 'us' microsegundos de CPU de la tarea actual (trabajo, no espera)
+inline void avanzar(uint64_t us) {
+  uint64_t restante = us;
+  while (true) {
+    uint64_t destino = reloj_us + restante;
+    if (destino > limite_us) destino = limite_us;
+    if (aplicando || eventos.empty() || eventos.begin()->first > destino) {
+      avanzarReloj(destino, false);
+      return;
+    }
+    uint64_t t = eventos.begin()->first > reloj_us ? eventos.begin()->first : reloj_us;
+    restante -= t - reloj_us;
+    avanzarReloj(t, false);
+    desalojar();
+  }
+}
+
+// Duerme la tarea actual hasta el próximo evento o hasta 'hasta_us', lo que ocurra primero
+inline void dormirHastaEvento(uint64_t hasta_us) {
+  uint64_t t = hasta_us;
+  if (!eventos.empty() && eventos.begin()->first < t) t = eventos.begin()->first;
+  bloquear(t > reloj_us ? t : reloj_us);
+}
+
+inline void ceder() {
+  if (alCeder && actual == &principal) alCeder();
+}
+
+// Crea una tarea: su hilo espera el testigo antes de ejecutar 'funcion'
+inline Tarea *crearTarea(void (*funcion)(void *), const char *nombre, void *arg, int prioridad) {
+  Tarea *t = new Tarea();
+  t->nombre = nombre;
+  t->prioridad = prioridad;
+  tareas.push_back(t);
+  std::thread([t, funcion, arg]() {
+    {
+      std::unique_lock<std::mutex> lk(mtx_testigo);
+      t->cv.wait(lk, [t] { return actual == t; });
+    }
+    try {
+      funcion(arg);
+    } catch (const FinSimulacion &) {
+      fin = true;  // El tiempo se agotó en esta tarea: la principal termina la simulación
+      t->terminada = true;
+      cambiarA(t, &principal);
+      return;
+    }
+    t->terminada = true;  // La tarea retornó (equivale a vTaskDelete(NULL))
+    bloquear(limite_us);
+  }).detach();
+  desalojar();
+  return t;
+}
+
+// Tiempo de transferencia de n bytes por I2C (9 bits por byte contando el ACK).
+// Desde el lazo principal se cuenta como CPU ocupada; desde una tarea propia el
+// driver espera la interrupción de fin de transferencia y la CPU queda libre.
+inline void transferirI2C(uint64_t bytes, uint64_t transacciones = 1) {
+  contadores.bytes_i2c += bytes;
+  contadores.transacciones_i2c += transacciones;
+  uint64_t us = bytes * 9 * 1000000ULL / i2c_hz;
+  if (actual == &principal || aplicando) {
+    avanzar(us);
+  } else {
+    bloquear(reloj_us + us);
+  }
+}
+
+// ---- Dispositivos I2C simulados: guardan lo que mostraría cada pantalla ----
+
+// HD44780 detrás de un PCF8574 (bits: P0=RS, P2=EN, P4-P7=D4-D7)
+struct MockLCD {
+  uint8_t ddram[128];
+  uint8_t ac = 0;            // Contador de direcciones
+  uint8_t previo = 0;        // Último byte del PCF8574 (para detectar el flanco de EN)
+  int nibbleAlto = -1;       // Nibble alto pendiente de su pareja
+  MockLCD() { memset(ddram, ' ', sizeof(ddram)); }
+
+  void comando(uint8_t c) {
+    if (c == 0x01) {
+      memset(ddram, ' ', sizeof(ddram));
+      ac = 0;
+    } else if (c & 0x80) {
+      ac = c & 0x7F;
+    }
+  }
+  void dato(uint8_t d) {
+    ddram[ac] = d;
+    ac = (ac + 1) & 0x7F;
+  }
+  void pcf8574(uint8_t v) {
+    if ((previo & 0x04) && !(v & 0x04)) {  // Flanco de bajada de EN: el HD44780 toma el nibble
+      if (nibbleAlto < 0) {
+        nibbleAlto = previo & 0xF0;
+      } else {
+        uint8_t b = (uint8_t)(nibbleAlto | (previo >> 4));
+        if (previo & 0x01) dato(b); else comando(b);
+        nibbleAlto = -1;
+      }
+    }
+    previo = v;
+  }
+  std::string fila(int f, int columnas) const {
+    return std::string((const char *)ddram + (f & 1 ? 0x40 : 0) + (f & 2 ? 0x14 : 0), columnas);
+  }
+};
+
+// SSD1306 en modo de direccionamiento horizontal (solo los comandos de ventana 0x21/0x22)
+struct MockOLED {
+  uint8_t gddram[8 * 128] = {};
+  uint8_t c0 = 0, c1 = 127, p0 = 0, p1 = 7, col = 0, pag = 0;
+
+  void transaccion(const uint8_t *b, size_t n) {
+    if (n == 0) return;
+    if (b[0] == 0x40) {
+      for (size_t i = 1; i < n; i++) {
+        gddram[pag * 128 + col] = b[i];
+        if (++col > c1) {
+          col = c0;
+          if (++pag > p1) pag = p0;
+        }
+      }
+      return;
+    }
+    for (size_t i = 1; i < n; i++) {
+      if (b[i] == 0x21 && i + 2 < n) {
+        c0 = col = b[i + 1] & 0x7F;
+        c1 = b[i + 2] & 0x7F;
+        i += 2;
+      } else if (b[i] == 0x22 && i + 2 < n) {
+        p0 = pag = b[i + 1] & 7;
+        p1 = b[i + 2] & 7;
+        i += 2;
+      }
+    }
+  }
+};
+
+inline std::map<uint8_t, MockLCD> lcds;
+inline std::map<uint8_t, MockOLED> oleds;
+
+// Transmisión de cada UART: los bytes salen a 'baudios' (10 bits por byte) detrás de
+// los que ya estaban en cola, y la escritura vuelve cuando lo pendiente cabe en la FIFO
+// de hardware más el buffer TX del driver. Con driver la tarea espera bloqueada; sin
+// él (printf de la consola de ESP-IDF) la CPU sondea la FIFO y la espera es trabajo.
+inline uint64_t tiempoLineaUs(size_t n, int baudios) { return (uint64_t)n * 10 * 1000000 / (uint64_t)baudios; }
+
+inline void salidaUART(const char *s, size_t n, int puerto = 0) {
+  contadores.bytes_uart += n;
+  avanzar(n * COSTO_BYTE_UART_US);
+  if (eco) fwrite(s, 1, n, stdout);
+  LineaUart &l = lineas_uart[puerto];
+  l.fin_us = std::max(l.fin_us, reloj_us) + tiempoLineaUs(n, l.baudios);
+  uint64_t cabe = tiempoLineaUs(UART_FIFO_TX + l.buffer_tx, l.baudios);
+  if (l.fin_us <= reloj_us + cabe) return;
+  if (l.driver) {
+    bloquear(l.fin_us - cabe);
+  } else {
+    avanzar(l.fin_us - cabe - reloj_us);
+  }
+}
+
+// scanf de los programas ESP-IDF: solo se admite "%c" (un carácter de UART0)
+inline int uart_scanf(const char *fmt, char *c) {
+  (void)fmt;
+  avanzar(COSTO_GPIO_US);
+  if (rx_uart[0].empty()) return EOF;
+  *c = rx_uart[0][0];
+  rx_uart[0].erase(0, 1);
+  return 1;
+}
+
+}  // namespace hal
+
+// printf/scanf de los sketches (y Serial.printf) se redirigen a la UART simulada
+#define printf hal_printf
+#define scanf hal_scanf
+
+inline int hal_printf(const char *fmt, ...) {
+  char buf[512];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n > 0) hal::salidaUART(buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+  return n;
+}
+
+inline int hal_scanf(const char *fmt, char *c) { return hal::uart_scanf(fmt, c); }
+
+// ==================== FREERTOS ====================
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef struct hal_cola *QueueHandle_t;
+
+#define portTICK_PERIOD_MS 10  // CONFIG_FREERTOS_HZ = 100
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define configMAX_PRIORITIES 25
+
+typedef hal::Tarea *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define IRAM_ATTR
+#define portYIELD_FROM_ISR(...) ((void)0)
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+inline void vTaskDelay(TickType_t ticks) {
+  hal::ceder();
+  hal::bloquear(hal::reloj_us + (uint64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+// Período fijo: el próximo despertar se cuenta desde el anterior, no desde ahora
+inline void vTaskDelayUntil(TickType_t *previo, TickType_t incremento) {
+  *previo += incremento;
+  hal::ceder();
+  uint64_t hasta = (uint64_t)*previo * portTICK_PERIOD_MS * 1000;
+  if (hasta > hal::reloj_us) hal::bloquear(hasta);
+}
+
+inline TickType_t xTaskGetTickCount() {
+  return (TickType_t)(hal::reloj_us / 1000 / portTICK_PERIOD_MS);
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t f, const char *nombre, uint32_t, void *arg,
+                                          UBaseType_t prioridad, TaskHandle_t *tarea, BaseType_t) {
+  TaskHandle_t t = hal::crearTarea(f, nombre, arg, (int)prioridad);
+  if (tarea) *tarea = t;
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t f, const char *nombre, uint32_t pila, void *arg,
+                              UBaseType_t prioridad, TaskHandle_t *tarea) {
+  return xTaskCreatePinnedToCore(f, nombre, pila, arg, prioridad, tarea, tskNO_AFFINITY);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return hal::actual; }
+
+// Notificaciones de tarea (semáforo contador liviano o palabra de bits de eventos)
+typedef enum { eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite, eSetValueWithoutOverwrite } eNotifyAction;
+
+namespace hal {
+inline uint64_t limiteTicks(TickType_t ticks) {
+  return ticks == portMAX_DELAY ? UINT64_MAX : reloj_us + (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+inline BaseType_t notificar(TaskHandle_t t, uint32_t valor, eNotifyAction accion) {
+  if (accion == eSetValueWithoutOverwrite && t->notificada) return pdFALSE;
+  if (accion == eSetBits) t->notificacion |= valor;
+  if (accion == eIncrement) t->notificacion++;
+  if (accion == eSetValueWithOverwrite || accion == eSetValueWithoutOverwrite) t->notificacion = valor;
+  t->notificada = true;
+  return pdPASS;
+}
+}  // namespace hal
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *despertar) {
+  hal::notificar(t, 0, eIncrement);
+  if (despertar) *despertar = t->prioridad > hal::actual->prioridad ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t t) {
+  hal::notificar(t, 0, eIncrement);
+  hal::desalojar();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t valor, eNotifyAction accion, BaseType_t *despertar) {
+  BaseType_t r = hal::notificar(t, valor, accion);
+  if (despertar) *despertar = t->prioridad > hal::actual->prioridad ? pdTRUE : pdFALSE;
+  return r;
+}
+
+inline BaseType_t xTaskNotify(TaskHandle_t t, uint32_t valor, eNotifyAction accion) {
+  BaseType_t r = hal::notificar(t, valor, accion);
+  hal::desalojar();
+  return r;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t limpiar, TickType_t ticks) {
+  TaskHandle_t yo = hal::actual;
+  if (yo->notificacion == 0 && ticks > 0) {
+    hal::bloquear(hal::limiteTicks(ticks), [yo] { return yo->notificacion > 0; });
+  }
+  uint32_t valor = yo->notificacion;
+  if (valor) yo->notificacion = limpiar ? 0 : valor - 1;
+  yo->notificada = false;
+  return valor;
+}
+
+inline BaseType_t xTaskNotifyWait(uint32_t limpiarAlEntrar, uint32_t limpiarAlSalir, uint32_t *valor, TickType_t ticks) {
+  TaskHandle_t yo = hal::actual;
+  if (!yo->notificada) {
+    yo->notificacion &= ~limpiarAlEntrar;
+    if (ticks > 0) hal::bloquear(hal::limiteTicks(ticks), [yo] { return yo->notificada; });
+  }
+  if (valor) *valor = yo->notificacion;
+  if (!yo->notificada) return pdFALSE;
+  yo->notificacion &= ~limpiarAlSalir;
+  yo->notificada = false;
+  return pdTRUE;
+}
+
+// ==================== FREERTOS: COLAS ====================
+// Cola de elementos de tamaño fijo copiados por valor
+struct hal_cola {
+  size_t tam_elemento;
+  size_t capacidad;
+  std::deque<std::vector<uint8_t>> elementos;
+};
+
+inline QueueHandle_t xQueueCreate(UBaseType_t capacidad, UBaseType_t tam_elemento) {
+  return new hal_cola{tam_elemento, capacidad, {}};
+}
+
+namespace hal {
+inline BaseType_t encolar(QueueHandle_t q, const void *elemento) {
+  if (q->elementos.size() >= q->capacidad) return pdFALSE;
+  const uint8_t *p = (const uint8_t *)elemento;
+  q->elementos.emplace_back(p, p + q->tam_elemento);
+  return pdPASS;
+}
+}  // namespace hal
+
+// Desde una tarea no se espera lugar: la simulación no llena colas desde tareas
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *elemento, TickType_t) {
+  BaseType_t r = hal::encolar(q, elemento);
+  hal::desalojar();
+  return r;
+}
+
+inline BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *elemento, BaseType_t *despertar) {
+  if (despertar) *despertar = pdFALSE;
+  return hal::encolar(q, elemento);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *elemento, TickType_t ticks) {
+  if (q->elementos.empty() && ticks > 0) {
+    hal::bloquear(hal::limiteTicks(ticks), [q] { return !q->elementos.empty(); });
+  }
+  if (q->elementos.empty()) return pdFALSE;
+  memcpy(elemento, q->elementos.front().data(), q->tam_elemento);
+  q->elementos.pop_front();
+  return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return (UBaseType_t)q->elementos.size(); }
+
+inline BaseType_t xQueueReset(QueueHandle_t q) {
+  q->elementos.clear();
+  return pdPASS;
+}
+
+// ==================== FREERTOS: TEMPORIZADORES DE SOFTWARE ====================
+// El callback corre al vencer, como un evento (en el ESP32 lo ejecuta la tarea del
+// servicio de temporizadores). Reiniciar un temporizador descarta el vencimiento anterior.
+namespace hal {
+struct Temporizador {
+  const char *nombre;
+  uint64_t periodo_us;
+  bool recarga;
+  void *id;
+  void (*callback)(Temporizador *);
+  bool activo = false;
+  uint32_t generacion = 0;
+};
+
+inline void armarTemporizador(Temporizador *t) {
+  t->activo = true;
+  uint32_t g = ++t->generacion;
+  programar(reloj_us + t->periodo_us, [t, g] {
+    if (!t->activo || t->generacion != g) return;
+    if (t->recarga) {
+      armarTemporizador(t);
+    } else {
+      t->activo = false;
+    }
+    t->callback(t);
+  });
+}
+}  // namespace hal
+
+typedef hal::Temporizador *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t);
+
+inline TimerHandle_t xTimerCreate(const char *nombre, TickType_t periodo, UBaseType_t recarga, void *id,
+                                  TimerCallbackFunction_t callback) {
+  return new hal::Temporizador{nombre, (uint64_t)periodo * portTICK_PERIOD_MS * 1000, recarga != 0, id, callback};
+}
+
+inline BaseType_t xTimerStart(TimerHandle_t t, TickType_t) {
+  hal::armarTemporizador(t);
+  return pdPASS;
+}
+inline BaseType_t xTimerReset(TimerHandle_t t, TickType_t espera) { return xTimerStart(t, espera); }
+inline BaseType_t xTimerStop(TimerHandle_t t, TickType_t) {
+  t->activo = false;
+  return pdPASS;
+}
+inline BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t periodo, TickType_t espera) {
+  t->periodo_us = (uint64_t)periodo * portTICK_PERIOD_MS * 1000;
+  return xTimerStart(t, espera);
+}
+inline BaseType_t xTimerStartFromISR(TimerHandle_t t, BaseType_t *despertar) {
+  if (despertar) *despertar = pdFALSE;
+  return xTimerStart(t, 0);
+}
+inline BaseType_t xTimerResetFromISR(TimerHandle_t t, BaseType_t *despertar) { return xTimerStartFromISR(t, despertar); }
+inline BaseType_t xTimerStopFromISR(TimerHandle_t t, BaseType_t *despertar) {
+  if (despertar) *despertar = pdFALSE;
+  return xTimerStop(t, 0);
+}
+inline BaseType_t xTimerIsTimerActive(TimerHandle_t t) { return t->activo ? pdTRUE : pdFALSE; }
+inline void *pvTimerGetTimerID(TimerHandle_t t) { return t->id; }
+
+// ==================== ESP-IDF: SISTEMA, LOG Y TIMER ====================
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+inline int64_t esp_timer_get_time() { return (int64_t)hal::reloj_us; }
+
+// Hora de pared: la simulación arranca con el reloj ya sincronizado por SNTP
+namespace hal {
+inline time_t epoca_inicio = 1767225600;  // 2026-01-01 00:00:00 UTC
+}
+inline time_t hal_time(time_t *t) {
+  time_t v = hal::epoca_inicio + (time_t)(hal::reloj_us / 1000000);
+  if (t) *t = v;
+  return v;
+}
+#define time(t) hal_time(t)
+
+#define ESP_LOGI(tag, fmt, ...) \
+  printf("I (%lu) %s: " fmt "\n", (unsigned long)(hal::reloj_us / 1000), tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) \
+  printf("W (%lu) %s: " fmt "\n", (unsigned long)(hal::reloj_us / 1000), tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) \
+  printf("E (%lu) %s: " fmt "\n", (unsigned long)(hal::reloj_us / 1000), tag, ##__VA_ARGS__)
+
+// ==================== ESP-IDF: GPIO ====================
+typedef enum {
+  GPIO_NUM_0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_6,
+  GPIO_NUM_7, GPIO_NUM_8, GPIO_NUM_9, GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12, GPIO_NUM_13,
+  GPIO_NUM_14, GPIO_NUM_15, GPIO_NUM_16, GPIO_NUM_17, GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_20,
+  GPIO_NUM_21, GPIO_NUM_22, GPIO_NUM_23, GPIO_NUM_24, GPIO_NUM_25, GPIO_NUM_26, GPIO_NUM_27,
+  GPIO_NUM_28, GPIO_NUM_29, GPIO_NUM_30, GPIO_NUM_31, GPIO_NUM_32, GPIO_NUM_33, GPIO_NUM_34,
+  GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_39
+} gpio_num_t;
+
+typedef enum {
+  GPIO_MODE_DISABLE, GPIO_MODE_INPUT, GPIO_MODE_OUTPUT, GPIO_MODE_OUTPUT_OD, GPIO_MODE_INPUT_OUTPUT_OD,
+  GPIO_MODE_INPUT_OUTPUT
+} gpio_mode_t;
+typedef enum { GPIO_PULLUP_DISABLE, GPIO_PULLUP_ENABLE } gpio_pullup_t;
+typedef enum { GPIO_PULLDOWN_DISABLE, GPIO_PULLDOWN_ENABLE } gpio_pulldown_t;
+typedef enum {
+  GPIO_INTR_DISABLE, GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, GPIO_INTR_ANYEDGE,
+  GPIO_INTR_LOW_LEVEL, GPIO_INTR_HIGH_LEVEL
+} gpio_int_type_t;
+typedef void (*gpio_isr_t)(void *);
+
+typedef struct {
+  uint64_t pin_bit_mask;
+  gpio_mode_t mode;
+  gpio_pullup_t pull_up_en;
+  gpio_pulldown_t pull_down_en;
+  gpio_int_type_t intr_type;
+} gpio_config_t;
+
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+namespace hal {
+// Interrupción configurada en cada pin
+struct InterrupcionGpio {
+  gpio_int_type_t tipo = GPIO_INTR_DISABLE;
+  bool habilitada = false;
+  gpio_isr_t isr = nullptr;
+  void *arg = nullptr;
+};
+inline InterrupcionGpio isr_gpio[40];
+
+// Atiende la interrupción del pin si el cambio de 'anterior' al nivel actual la dispara.
+// Las de nivel se disparan mientras el nivel coincida: la ISR debe deshabilitarlas.
+inline void revisarGpio(int pin, int anterior) {
+  InterrupcionGpio &i = isr_gpio[pin];
+  if (!i.habilitada || !i.isr) return;
+  int n = nivel_gpio[pin];
+  bool dispara = (i.tipo == GPIO_INTR_POSEDGE && anterior == 0 && n == 1) ||
+                 (i.tipo == GPIO_INTR_NEGEDGE && anterior == 1 && n == 0) ||
+                 (i.tipo == GPIO_INTR_ANYEDGE && anterior != n) ||
+                 (i.tipo == GPIO_INTR_LOW_LEVEL && n == 0) || (i.tipo == GPIO_INTR_HIGH_LEVEL && n == 1);
+  if (!dispara) return;
+  contadores.interrupciones++;
+  i.isr(i.arg);
+}
+
+// Una interrupción de nivel recién habilitada se atiende en seguida si el nivel ya coincide
+inline void revisarGpioLuego(int pin) {
+  programar(reloj_us, [pin] { revisarGpio(pin, nivel_gpio[pin]); });
+}
+
+// Cambio de nivel de un pin de entrada (desde el guion)
+inline void cambiarNivel(int pin, int nivel) {
+  int anterior = nivel_gpio[pin];
+  nivel_gpio[pin] = nivel ? 1 : 0;
+  revisarGpio(pin, anterior);
+}
+}  // namespace hal
+
+inline esp_err_t gpio_set_direction(gpio_num_t, gpio_mode_t) { return ESP_OK; }
+inline esp_err_t gpio_pullup_en(gpio_num_t) { return ESP_OK; }
+
+inline esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t tipo) {
+  hal::isr_gpio[pin].tipo = tipo;
+  hal::revisarGpioLuego(pin);
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_intr_enable(gpio_num_t pin) {
+  hal::isr_gpio[pin].habilitada = true;
+  hal::revisarGpioLuego(pin);
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_intr_disable(gpio_num_t pin) {
+  hal::isr_gpio[pin].habilitada = false;
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_config(const gpio_config_t *cfg) {
+  for (int pin = 0; pin < 40; pin++) {
+    if (!(cfg->pin_bit_mask & (1ULL << pin))) continue;
+    hal::isr_gpio[pin].tipo = cfg->intr_type;
+    hal::isr_gpio[pin].habilitada = cfg->intr_type != GPIO_INTR_DISABLE;
+  }
+  return ESP_OK;
+}
+
+inline esp_err_t gpio_install_isr_service(int) { return ESP_OK; }
+
+inline esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t isr, void *arg) {
+  hal::isr_gpio[pin].isr = isr;
+  hal::isr_gpio[pin].arg = arg;
+  hal::revisarGpioLuego(pin);
+  return ESP_OK;
+}
+
+// Fuente de despertar del sueño ligero: en el chip también fija el tipo de interrupción
+inline esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t tipo) { return gpio_set_intr_type(pin, tipo); }
+
+inline int gpio_get_level(gpio_num_t pin) {
+  hal::avanzar(hal::COSTO_GPIO_US);
+  return hal::nivel_gpio[pin];
+}
+
+inline esp_err_t gpio_set_level(gpio_num_t pin, uint32_t nivel) {
+  hal::avanzar(hal::COSTO_GPIO_US);
+  hal::nivel_gpio[pin] = nivel ? 1 : 0;
+  return ESP_OK;
+}
+
+// ==================== ESP-IDF: ADC ====================
+// ESP-IDF 5: ADC_ATTEN_DB_11 quedó como alias obsoleto de ADC_ATTEN_DB_12
+typedef enum { ADC_ATTEN_DB_0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_12 } adc_atten_t;
+
+namespace hal {
+// GPIO asociado a cada canal del ADC1
+constexpr int gpio_adc1[8] = {36, 37, 38, 39, 32, 33, 34, 35};
+
+// Una conversión: valor guionado + ruido uniforme (generador congruencial determinista)
+inline uint32_t semilla_ruido = 12345;
+inline int muestraADC(int gpio) {
+  int v = adc_gpio[gpio];
+  if (ruido_adc[gpio]) {
+    semilla_ruido = semilla_ruido * 1103515245u + 12345u;
+    v += (int)((semilla_ruido >> 16) % (2 * ruido_adc[gpio] + 1)) - ruido_adc[gpio];
+  }
+  return v < 0 ? 0 : (v > 4095 ? 4095 : v);
+}
+}  // namespace hal
+
+// ==================== ESP-IDF: ADC CONTINUO (DMA) ====================
+typedef enum {
+  ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3, ADC_CHANNEL_4,
+  ADC_CHANNEL_5, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_8, ADC_CHANNEL_9
+} adc_channel_t;
+typedef enum { ADC_UNIT_1, ADC_UNIT_2 } adc_unit_t;
+typedef enum { ADC_CONV_SINGLE_UNIT_1 = 1, ADC_CONV_SINGLE_UNIT_2, ADC_CONV_BOTH_UNIT } adc_digi_convert_mode_t;
+typedef enum { ADC_DIGI_OUTPUT_FORMAT_TYPE1, ADC_DIGI_OUTPUT_FORMAT_TYPE2 } adc_digi_output_format_t;
+
+#define SOC_ADC_DIGI_MAX_BITWIDTH 12
+#define SOC_ADC_DIGI_RESULT_BYTES 2
+
+typedef struct {
+  uint8_t atten;
+  uint8_t channel;
+  uint8_t unit;
+  uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+  uint32_t max_store_buf_size;
+  uint32_t conv_frame_size;
+  struct {
+    uint32_t flush_pool : 1;
+  } flags;
+} adc_continuous_handle_cfg_t;
+
+typedef struct {
+  uint32_t pattern_num;
+  adc_digi_pattern_config_t *adc_pattern;
+  uint32_t sample_freq_hz;
+  adc_digi_convert_mode_t conv_mode;
+  adc_digi_output_format_t format;
+} adc_continuous_config_t;
+
+typedef struct {
+  union {
+    struct {
+      uint16_t data : 12;
+      uint16_t channel : 4;
+    } type1;
+    uint16_t val;
+  };
+} adc_digi_output_data_t;
+
+typedef struct {
+  uint8_t *conv_frame_buffer;
+  uint32_t size;
+} adc_continuous_evt_data_t;
+
+typedef struct adc_continuous_ctx_t *adc_continuous_handle_t;
+typedef bool (*adc_continuous_callback_t)(adc_continuous_handle_t, const adc_continuous_evt_data_t *, void *);
+
+typedef struct {
+  adc_continuous_callback_t on_conv_done;
+  adc_continuous_callback_t on_pool_ovf;
+} adc_continuous_evt_cbs_t;
+
+// Driver simulado: cada trama DMA se genera como un evento a la frecuencia de muestreo
+struct adc_continuous_ctx_t {
+  adc_continuous_handle_cfg_t cfg;
+  adc_continuous_config_t conv;
+  adc_digi_pattern_config_t patron;
+  adc_continuous_evt_cbs_t cbs;
+  void *user_data;
+  std::string buffer;  // Buffer circular del driver (bytes de tramas completas)
+  bool activo;
+  uint32_t arranques;  // Descarta las tramas programadas antes de un stop/start
+};
+
+inline esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *cfg, adc_continuous_handle_t *h) {
+  *h = new adc_continuous_ctx_t{*cfg, {}, {}, {}, nullptr, {}, false, 0};
+  return ESP_OK;
+}
+
+inline esp_err_t adc_continuous_config(adc_continuous_handle_t h, const adc_continuous_config_t *conv) {
+  h->conv = *conv;
+  h->patron = conv->adc_pattern[0];
+  h->conv.adc_pattern = &h->patron;
+  return ESP_OK;
+}
+
+inline esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t h,
+                                                         const adc_continuous_evt_cbs_t *cbs, void *user_data) {
+  h->cbs = *cbs;
+  h->user_data = user_data;
+  return ESP_OK;
+}
+
+namespace hal {
+inline void tramaADC(adc_continuous_handle_t h, uint32_t arranque) {
+  if (!h->activo || h->arranques != arranque) return;
+  uint32_t n = h->cfg.conv_frame_size / SOC_ADC_DIGI_RESULT_BYTES;
+  std::string trama(h->cfg.conv_frame_size, '\0');
+  for (uint32_t i = 0; i < n; i++) {
+    adc_digi_output_data_t d;
+    d.type1.data = (uint16_t)muestraADC(gpio_adc1[h->patron.channel]);
+    d.type1.channel = h->patron.channel;
+    memcpy(&trama[i * 2], &d, 2);
+  }
+  adc_continuous_evt_data_t ev{(uint8_t *)trama.data(), (uint32_t)trama.size()};
+  if (h->buffer.size() + trama.size() > h->cfg.max_store_buf_size) {
+    if (h->cbs.on_pool_ovf) h->cbs.on_pool_ovf(h, &ev, h->user_data);  // Trama perdida
+  } else {
+    h->buffer += trama;
+    if (h->cbs.on_conv_done) h->cbs.on_conv_done(h, &ev, h->user_data);
+  }
+  programar(reloj_us + (uint64_t)n * 1000000 / h->conv.sample_freq_hz, [h, arranque] { tramaADC(h, arranque); });
+}
+}  // namespace hal
+
+// Mientras convierte, el driver toma un candado de energía que impide el sueño ligero
+inline esp_err_t adc_continuous_start(adc_continuous_handle_t h) {
+  if (h->activo) return ESP_ERR_INVALID_STATE;
+  h->activo = true;
+  hal::candados_pm++;
+  uint32_t n = h->cfg.conv_frame_size / SOC_ADC_DIGI_RESULT_BYTES;
+  uint32_t arranque = ++h->arranques;
+  hal::programar(hal::reloj_us + (uint64_t)n * 1000000 / h->conv.sample_freq_hz,
+                 [h, arranque] { hal::tramaADC(h, arranque); });
+  return ESP_OK;
+}
+
+inline esp_err_t adc_continuous_stop(adc_continuous_handle_t h) {
+  if (!h->activo) return ESP_ERR_INVALID_STATE;
+  h->activo = false;
+  hal::candados_pm--;
+  return ESP_OK;
+}
+
+inline esp_err_t adc_continuous_read(adc_continuous_handle_t h, uint8_t *buf, uint32_t len, uint32_t *leidos,
+                                     uint32_t timeout_ms) {
+  if (h->buffer.empty() && timeout_ms > 0) {
+    hal::bloquear(hal::reloj_us + (uint64_t)timeout_ms * 1000, [h] { return !h->buffer.empty(); });
+  }
+  if (h->buffer.empty()) {
+    *leidos = 0;
+    return ESP_ERR_TIMEOUT;
+  }
+  uint32_t n = h->buffer.size() < len ? (uint32_t)h->buffer.size() : len;
+  memcpy(buf, h->buffer.data(), n);
+  h->buffer.erase(0, n);
+  *leidos = n;
+  hal::avanzar(1 + n / 64);  // Copia desde el buffer circular del driver
+  return ESP_OK;
+}
+
+// ==================== ESP-IDF: TOUCH ====================
+typedef enum {
+  TOUCH_PAD_NUM0, TOUCH_PAD_NUM1, TOUCH_PAD_NUM2, TOUCH_PAD_NUM3, TOUCH_PAD_NUM4,
+  TOUCH_PAD_NUM5, TOUCH_PAD_NUM6, TOUCH_PAD_NUM7, TOUCH_PAD_NUM8, TOUCH_PAD_NUM9
+} touch_pad_t;
+
+typedef enum { TOUCH_FSM_MODE_TIMER, TOUCH_FSM_MODE_SW } touch_fsm_mode_t;
+typedef enum { TOUCH_TRIGGER_BELOW, TOUCH_TRIGGER_ABOVE } touch_trigger_mode_t;
+typedef void (*intr_handler_t)(void *);
+
+namespace hal {
+// Con la FSM en modo temporizador el hardware mide los pads solo (sin CPU) y, con la
+// interrupción habilitada, avisa cuando la lectura cruza el umbral de algún pad
+inline touch_fsm_mode_t touch_fsm = TOUCH_FSM_MODE_SW;
+inline touch_trigger_mode_t touch_disparo = TOUCH_TRIGGER_BELOW;
+inline uint16_t umbral_touch[10] = {};  // 0 = el pad no interrumpe
+inline bool touch_intr = false;
+inline uint32_t touch_estado = 0;       // Pads que dispararon (touch_pad_get_status)
+inline intr_handler_t touch_isr = nullptr;
+inline void *touch_arg = nullptr;
+
+inline void revisarTouch() {
+  if (!touch_intr || !touch_isr || touch_fsm != TOUCH_FSM_MODE_TIMER) return;
+  uint32_t disparados = 0;
+  for (int p = 0; p < 10; p++) {
+    if (!umbral_touch[p]) continue;
+    bool debajo = touch_pad[p] < umbral_touch[p];
+    if (debajo == (touch_disparo == TOUCH_TRIGGER_BELOW)) disparados |= 1u << p;
+  }
+  if (!disparados) return;
+  touch_estado |= disparados;
+  contadores.interrupciones++;
+  touch_isr(touch_arg);
+}
+
+// Nueva lectura de un pad (desde el guion)
+inline void cambiarTouch(int pad, uint16_t valor) {
+  touch_pad[pad] = valor;
+  revisarTouch();
+}
+}  // namespace hal
+
+inline esp_err_t touch_pad_init() { return ESP_OK; }
+inline esp_err_t touch_pad_config(touch_pad_t pad, uint16_t umbral) {
+  hal::umbral_touch[pad] = umbral;
+  return ESP_OK;
+}
+inline esp_err_t touch_pad_set_thresh(touch_pad_t pad, uint16_t umbral) { return touch_pad_config(pad, umbral); }
+inline esp_err_t touch_pad_set_fsm_mode(touch_fsm_mode_t modo) {
+  hal::touch_fsm = modo;
+  return ESP_OK;
+}
+inline esp_err_t touch_pad_set_trigger_mode(touch_trigger_mode_t modo) {
+  hal::touch_disparo = modo;
+  return ESP_OK;
+}
+
+inline esp_err_t touch_pad_isr_register(intr_handler_t isr, void *arg) {
+  hal::touch_isr = isr;
+  hal::touch_arg = arg;
+  return ESP_OK;
+}
+inline esp_err_t touch_pad_intr_enable() {
+  hal::touch_intr = true;
+  hal::programar(hal::reloj_us, [] { hal::revisarTouch(); });
+  return ESP_OK;
+}
+inline esp_err_t touch_pad_intr_disable() {
+  hal::touch_intr = false;
+  return ESP_OK;
+}
+inline uint32_t touch_pad_get_status() { return hal::touch_estado; }
+inline esp_err_t touch_pad_clear_status() {
+  hal::touch_estado = 0;
+  return ESP_OK;
+}
+
+// Medición por software (FSM en modo SW): la CPU espera al sensor
+inline esp_err_t touch_pad_read(touch_pad_t pad, uint16_t *valor) {
+  hal::avanzar(hal::COSTO_TOUCH_US);
+  *valor = hal::touch_pad[pad];
+  return ESP_OK;
+}
+
+// Última medición hecha por la FSM en modo temporizador: solo lee un registro
+inline esp_err_t touch_pad_read_raw_data(touch_pad_t pad, uint16_t *valor) {
+  hal::avanzar(hal::COSTO_GPIO_US);
+  *valor = hal::touch_pad[pad];
+  return ESP_OK;
+}
+
+// ==================== ESP-IDF: ENERGÍA Y SUEÑO ====================
+typedef struct {
+  int max_freq_mhz;
+  int min_freq_mhz;
+  bool light_sleep_enable;
+} esp_pm_config_t;
+
+inline esp_err_t esp_pm_configure(const void *config) {
+  hal::sueno_ligero = ((const esp_pm_config_t *)config)->light_sleep_enable;
+  return ESP_OK;
+}
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+inline esp_err_t esp_sleep_enable_touchpad_wakeup() { return ESP_OK; }
+
+// ==================== ESP-IDF: UART ====================
+typedef int uart_port_t;
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_PIN_NO_CHANGE -1
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE, UART_PARITY_EVEN = 2, UART_PARITY_ODD } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE, UART_HW_FLOWCTRL_RTS, UART_HW_FLOWCTRL_CTS } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_APB = 4, UART_SCLK_REF_TICK = 9, UART_SCLK_DEFAULT = UART_SCLK_APB } uart_sclk_t;
+
+typedef struct {
+  int baud_rate;
+  uart_word_length_t data_bits;
+  uart_parity_t parity;
+  uart_stop_bits_t stop_bits;
+  uart_hw_flowcontrol_t flow_ctrl;
+  uint8_t rx_flow_ctrl_thresh;
+  union {
+    uart_sclk_t source_clk;  // ESP-IDF 5: reloj de la UART (APB por defecto)
+  };
+} uart_config_t;
+
+typedef enum {
+  UART_DATA, UART_BREAK, UART_BUFFER_FULL, UART_FIFO_OVF, UART_FRAME_ERR,
+  UART_PARITY_ERR, UART_DATA_BREAK, UART_PATTERN_DET, UART_EVENT_MAX
+} uart_event_type_t;
+
+typedef struct {
+  uart_event_type_t type;
+  size_t size;
+  bool timeout_flag;
+} uart_event_t;
+
+namespace hal {
+constexpr size_t UART_UMBRAL_FIFO = 120;  // UART_FULL_THRESH_DEFAULT: bytes por interrupción de RX
+
+// Driver instalado: buffer de recepción acotado y cola de eventos opcional
+struct DriverUart {
+  bool instalado = false;
+  size_t capacidad_rx = 0;
+  QueueHandle_t eventos = nullptr;
+};
+inline DriverUart drivers_uart[3];
+
+inline void eventoUart(uart_port_t puerto, uart_event_type_t tipo, size_t n) {
+  if (!drivers_uart[puerto].eventos) return;
+  uart_event_t ev = {tipo, n, false};
+  encolar(drivers_uart[puerto].eventos, &ev);  // Con la cola llena el evento se pierde, como en el driver
+}
+
+// Bytes que entregó la FIFO de recepción (contexto de ISR). Sin driver instalado
+// (Serial de Arduino, scanf) el buffer no tiene límite.
+inline void recibirUart(uart_port_t puerto, const std::string &datos) {
+  DriverUart &d = drivers_uart[puerto];
+  if (!d.instalado) {
+    rx_uart[puerto] += datos;
+    return;
+  }
+  contadores.interrupciones++;
+  contadores.bytes_uart_rx += datos.size();
+  size_t libre = d.capacidad_rx - std::min(d.capacidad_rx, rx_uart[puerto].size());
+  size_t n = std::min(libre, datos.size());
+  rx_uart[puerto].append(datos, 0, n);
+  if (n) eventoUart(puerto, UART_DATA, n);
+  if (n < datos.size()) {
+    contadores.bytes_uart_perdidos += datos.size() - n;
+    eventoUart(puerto, UART_BUFFER_FULL, 0);
+  }
+}
+
+// Llegada de 'datos' a 'baudios' (10 bits por byte) desde t0, en bloques del umbral de la FIFO
+inline void programarRafagaUart(uart_port_t puerto, uint64_t t0, int baudios, std::string datos) {
+  auto compartidos = std::make_shared<std::string>(std::move(datos));
+  for (size_t i = 0; i < compartidos->size(); i += UART_UMBRAL_FIFO) {
+    size_t n = std::min(UART_UMBRAL_FIFO, compartidos->size() - i);
+    uint64_t t = t0 + (uint64_t)(i + n) * 10 * 1000000 / (uint64_t)baudios;
+    programar(t, [puerto, compartidos, i, n] { recibirUart(puerto, compartidos->substr(i, n)); });
+  }
+}
+}  // namespace hal
+
+inline esp_err_t uart_driver_install(uart_port_t puerto, int rx, int tx, int cola, QueueHandle_t *eventos, int) {
+  hal::DriverUart &d = hal::drivers_uart[puerto];
+  d.instalado = true;
+  d.capacidad_rx = (size_t)rx;
+  hal::lineas_uart[puerto].driver = true;
+  hal::lineas_uart[puerto].buffer_tx = (size_t)tx;
+  if (cola > 0 && eventos) {
+    d.eventos = xQueueCreate(cola, sizeof(uart_event_t));
+    *eventos = d.eventos;
+  }
+  return ESP_OK;
+}
+inline esp_err_t uart_param_config(uart_port_t puerto, const uart_config_t *cfg) {
+  hal::lineas_uart[puerto].baudios = cfg->baud_rate;
+  return ESP_OK;
+}
+inline esp_err_t uart_get_buffered_data_len(uart_port_t puerto, size_t *n) {
+  *n = hal::rx_uart[puerto].size();
+  return ESP_OK;
+}
+inline esp_err_t uart_flush_input(uart_port_t puerto) {
+  hal::rx_uart[puerto].clear();
+  return ESP_OK;
+}
+inline esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return ESP_OK; }
+
+// Igual que el driver real: bloquea hasta recibir 'len' bytes o hasta que venza el timeout
+inline int uart_read_bytes(uart_port_t puerto, void *buf, uint32_t len, TickType_t ticks) {
+  uint64_t limite = hal::reloj_us + (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+  if (hal::rx_uart[puerto].size() < len) {
+    hal::bloquear(limite, [puerto, len] { return hal::rx_uart[puerto].size() >= len; });
+  }
+  size_t n = hal::rx_uart[puerto].size() < len ? hal::rx_uart[puerto].size() : len;
+  memcpy(buf, hal::rx_uart[puerto].data(), n);
+  hal::rx_uart[puerto].erase(0, n);
+  hal::avanzar(n * hal::COSTO_BYTE_UART_US);
+  return (int)n;
+}
+
+inline int uart_write_bytes(uart_port_t puerto, const void *src, size_t n) {
+  hal::salidaUART((const char *)src, n, puerto);
+  return (int)n;
+}
+
+// ==================== ESP-IDF: RMT (RECEPCIÓN, DRIVER DE IDF 5) ====================
+typedef enum { RMT_CLK_SRC_APB = 4, RMT_CLK_SRC_DEFAULT = RMT_CLK_SRC_APB } rmt_clock_source_t;
+
+typedef struct {
+  gpio_num_t gpio_num;
+  rmt_clock_source_t clk_src;
+  uint32_t resolution_hz;
+  size_t mem_block_symbols;
+  struct {
+    uint32_t invert_in : 1;
+    uint32_t with_dma : 1;
+    uint32_t io_loop_back : 1;
+  } flags;
+  int intr_priority;
+} rmt_rx_channel_config_t;
+
+typedef union {
+  struct {
+    uint16_t duration0 : 15;
+    uint16_t level0 : 1;
+    uint16_t duration1 : 15;
+    uint16_t level1 : 1;
+  };
+  uint32_t val;
+} rmt_symbol_word_t;
+
+typedef struct {
+  uint32_t signal_range_min_ns;  // Pulsos más cortos se toman como ruido
+  uint32_t signal_range_max_ns;  // Un nivel más largo que esto termina la recepción
+} rmt_receive_config_t;
+
+typedef struct {
+  rmt_symbol_word_t *received_symbols;
+  size_t num_symbols;
+} rmt_rx_done_event_data_t;
+
+typedef struct hal_rmt_canal *rmt_channel_handle_t;
+typedef bool (*rmt_rx_done_callback_t)(rmt_channel_handle_t rx_chan, const rmt_rx_done_event_data_t *edata,
+                                       void *user_ctx);
+typedef struct {
+  rmt_rx_done_callback_t on_recv_done;
+} rmt_rx_event_callbacks_t;
+
+// Un DHT22 en el pin de cada canal de recepción: al empezar la recepción (tras el
+// pulso de arranque) responde con una trama armada con dht_temperatura y dht_humedad,
+// con ±3 µs de variación por pulso. Con lecturas NaN no responde.
+struct hal_rmt_canal {
+  rmt_rx_channel_config_t cfg{};
+  rmt_rx_done_callback_t fin = nullptr;
+  void *ctx = nullptr;
+  bool habilitado = false;
+  bool recibiendo = false;
+  uint32_t generacion = 0;  // Descarta las recepciones programadas antes de un rmt_disable
+};
+
+namespace hal {
+inline uint32_t semilla_dht = 4242;
+
+inline uint16_t variar(uint16_t us) {
+  semilla_dht = semilla_dht * 1103515245u + 12345u;
+  return (uint16_t)(us + (int)((semilla_dht >> 16) % 7) - 3);
+}
+
+// Pulsos de la respuesta (nivel, µs), desde que se suelta la línea hasta que queda en alto
+inline std::vector<std::pair<int, uint16_t>> pulsosDht() {
+  std::vector<std::pair<int, uint16_t>> p;
+  p.push_back({0, (uint16_t)COSTO_GPIO_US});  // Lo que falta del arranque al empezar la captura
+  if (std::isnan(dht_temperatura) || std::isnan(dht_humedad)) return p;
+
+  int temperatura = (int)std::lround(dht_temperatura * 10);
+  uint16_t humedad = (uint16_t)std::lround(dht_humedad * 10);
+  uint16_t modulo = (uint16_t)(temperatura < 0 ? -temperatura : temperatura);
+  uint8_t b[5] = {(uint8_t)(humedad >> 8), (uint8_t)humedad,
+                  (uint8_t)((modulo >> 8) | (temperatura < 0 ? 0x80 : 0)), (uint8_t)modulo, 0};
+  b[4] = (uint8_t)(b[0] + b[1] + b[2] + b[3]);
+  semilla_dht = semilla_dht * 1103515245u + 12345u;
+  int invertido = (int)((semilla_dht >> 16) % 100) < dht_corruptas ? (int)((semilla_dht >> 8) % 40) : -1;
+
+  p.push_back({1, variar(30)});
+  p.push_back({0, variar(80)});
+  p.push_back({1, variar(80)});
+  for (int i = 0; i < 40; i++) {
+    bool uno = ((b[i / 8] >> (7 - i % 8)) & 1) ^ (i == invertido);
+    p.push_back({0, variar(50)});
+    p.push_back({1, variar(uno ? 70 : 26)});
+  }
+  p.push_back({0, variar(50)});
+  return p;
+}
+}  // namespace hal
+
+inline esp_err_t rmt_new_rx_channel(const rmt_rx_channel_config_t *cfg, rmt_channel_handle_t *canal) {
+  if (cfg->resolution_hz == 0 || cfg->mem_block_symbols < 64) return ESP_ERR_INVALID_ARG;
+  *canal = new hal_rmt_canal;
+  (*canal)->cfg = *cfg;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_del_channel(rmt_channel_handle_t canal) {
+  if (canal->habilitado) return ESP_ERR_INVALID_STATE;
+  delete canal;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_rx_register_event_callbacks(rmt_channel_handle_t canal, const rmt_rx_event_callbacks_t *cbs,
+                                                 void *ctx) {
+  canal->fin = cbs->on_recv_done;
+  canal->ctx = ctx;
+  return ESP_OK;
+}
+
+inline esp_err_t rmt_enable(rmt_channel_handle_t canal) {
+  canal->habilitado = true;
+  return ESP_OK;
+}
+
+// Deshabilitar cancela la recepción en curso (es la única forma de abortarla)
+inline esp_err_t rmt_disable(rmt_channel_handle_t canal) {
+  canal->habilitado = false;
+  canal->recibiendo = false;
+  canal->generacion++;
+  return ESP_OK;
+}
+
+// La recepción termina cuando la línea lleva 'signal_range_max_ns' quieta; el último
+// símbolo cierra con duración 0, como en el chip. Los símbolos que no entran en el
+// buffer se pierden.
+inline esp_err_t rmt_receive(rmt_channel_handle_t canal, void *buffer, size_t tam,
+                             const rmt_receive_config_t *cfg) {
+  if (!canal->habilitado || canal->recibiendo) return ESP_ERR_INVALID_STATE;
+  canal->recibiendo = true;
+  uint32_t generacion = canal->generacion;
+
+  auto pulsos = hal::pulsosDht();
+  pulsos.push_back({1, 0});
+  rmt_symbol_word_t *simbolos = (rmt_symbol_word_t *)buffer;
+  size_t n = 0;
+  uint64_t duracion = 0;
+  double tics_por_us = canal->cfg.resolution_hz / 1e6;
+  for (size_t i = 0; i + 1 < pulsos.size(); i += 2) {
+    if ((n + 1) * sizeof(rmt_symbol_word_t) <= tam) {
+      simbolos[n].duration0 = (uint16_t)(pulsos[i].second * tics_por_us);
+      simbolos[n].level0 = (uint16_t)pulsos[i].first;
+      simbolos[n].duration1 = (uint16_t)(pulsos[i + 1].second * tics_por_us);
+      simbolos[n].level1 = (uint16_t)pulsos[i + 1].first;
+      n++;
+    }
+    duracion += pulsos[i].second + pulsos[i + 1].second;
+  }
+  duracion += cfg->signal_range_max_ns / 1000;
+  hal::programar(hal::reloj_us + duracion, [canal, generacion, simbolos, n] {
+    if (!canal->recibiendo || canal->generacion != generacion) return;
+    canal->recibiendo = false;
+    hal::contadores.interrupciones++;  // Fin de recepción
+    rmt_rx_done_event_data_t ev{simbolos, n};
+    if (canal->fin) canal->fin(canal, &ev, canal->ctx);
+  });
+  return ESP_OK;
+}
+
+// ==================== ESP-IDF: PARTICIONES DE FLASH ====================
+// Emulador de NOR flash: programar solo baja bits (1 -> 0) y solo el borrado de un
+// sector los vuelve a 1. Una escritura que intenta subir bits se aplica como en el
+// chip (AND con lo que había) y se cuenta como violación. Con "flash <ruta>" en el
+// guion la imagen vive en un archivo y sobrevive entre corridas (reinicios).
+typedef enum { ESP_PARTITION_TYPE_APP = 0x00, ESP_PARTITION_TYPE_DATA = 0x01 } esp_partition_type_t;
+typedef enum {
+  ESP_PARTITION_SUBTYPE_DATA_NVS = 0x02,
+  ESP_PARTITION_SUBTYPE_DATA_FAT = 0x81,
+  ESP_PARTITION_SUBTYPE_DATA_SPIFFS = 0x82,
+  ESP_PARTITION_SUBTYPE_ANY = 0xff
+} esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  uint32_t erase_size;
+  char label[17];
+  bool encrypted;
+} esp_partition_t;
+
+#define SPI_FLASH_SEC_SIZE 4096
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+namespace hal {
+// La partición "spiffs" de la tabla por defecto de Arduino (1,375 MB)
+inline const esp_partition_t particion_datos = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS,
+                                                0x290000, 0x160000, SPI_FLASH_SEC_SIZE, "spiffs", false};
+
+struct FlashEmulada {
+  std::string ruta;             // Archivo de respaldo ("" = solo en memoria)
+  std::string imagen;           // Contenido; se crea borrado (0xFF) la primera vez
+  bool usada = false;
+  uint64_t bytes_programados = 0;
+  uint64_t programaciones = 0;  // Llamadas a esp_partition_write
+  uint64_t bytes_leidos = 0;
+  uint64_t violaciones = 0;     // Escrituras sobre bits ya programados sin borrar
+  std::vector<uint32_t> borrados;  // Por sector
+};
+inline FlashEmulada flash;
+
+inline std::string &imagenFlash() {
+  if (!flash.usada) {
+    flash.usada = true;
+    flash.imagen.assign(particion_datos.size, '\xFF');
+    flash.borrados.assign(particion_datos.size / SPI_FLASH_SEC_SIZE, 0);
+    if (FILE *f = flash.ruta.empty() ? nullptr : fopen(flash.ruta.c_str(), "rb")) {
+      size_t n = fread(&flash.imagen[0], 1, flash.imagen.size(), f);
+      (void)n;
+      fclose(f);
+    }
+  }
+  return flash.imagen;
+}
+
+// Escribe en el archivo de respaldo el tramo modificado
+inline void respaldarFlash(size_t desde, size_t n) {
+  if (flash.ruta.empty()) return;
+  FILE *f = fopen(flash.ruta.c_str(), "r+b");
+  if (!f) f = fopen(flash.ruta.c_str(), "w+b");
+  if (!f) return;
+  if (fseek(f, 0, SEEK_END) == 0 && (size_t)ftell(f) < flash.imagen.size()) {
+    fseek(f, 0, SEEK_SET);
+    fwrite(flash.imagen.data(), 1, flash.imagen.size(), f);
+  } else {
+    fseek(f, (long)desde, SEEK_SET);
+    fwrite(flash.imagen.data() + desde, 1, n, f);
+  }
+  fclose(f);
+}
+}  // namespace hal
+
+inline const esp_partition_t *esp_partition_find_first(esp_partition_type_t tipo, esp_partition_subtype_t subtipo,
+                                                       const char *etiqueta) {
+  const esp_partition_t &p = hal::particion_datos;
+  if (tipo != p.type || (subtipo != ESP_PARTITION_SUBTYPE_ANY && subtipo != p.subtype)) return nullptr;
+  if (etiqueta && strcmp(etiqueta, p.label) != 0) return nullptr;
+  return &p;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t *p, size_t desde, void *dst, size_t n) {
+  if (desde + n > p->size) return ESP_ERR_INVALID_SIZE;
+  memcpy(dst, hal::imagenFlash().data() + desde, n);
+  hal::flash.bytes_leidos += n;
+  hal::avanzar(1 + n / 40);  // ~40 MB/s por QIO a 80 MHz
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t *p, size_t desde, const void *src, size_t n) {
+  if (desde + n > p->size) return ESP_ERR_INVALID_SIZE;
+  std::string &img = hal::imagenFlash();
+  const uint8_t *b = (const uint8_t *)src;
+  for (size_t i = 0; i < n; i++) {
+    uint8_t antes = (uint8_t)img[desde + i];
+    if ((antes & b[i]) != b[i]) hal::flash.violaciones++;
+    img[desde + i] = (char)(antes & b[i]);
+  }
+  hal::flash.bytes_programados += n;
+  hal::flash.programaciones++;
+  hal::respaldarFlash(desde, n);
+  hal::avanzar(1 + n * hal::COSTO_PAGINA_US / 256);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t desde, size_t n) {
+  if (desde % SPI_FLASH_SEC_SIZE || n % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+  if (desde + n > p->size) return ESP_ERR_INVALID_SIZE;
+  std::string &img = hal::imagenFlash();
+  memset(&img[desde], 0xFF, n);
+  for (size_t s = desde / SPI_FLASH_SEC_SIZE; s < (desde + n) / SPI_FLASH_SEC_SIZE; s++) hal::flash.borrados[s]++;
+  hal::respaldarFlash(desde, n);
+  hal::avanzar(n / SPI_FLASH_SEC_SIZE * hal::COSTO_BORRADO_US);
+  return ESP_OK;
+}
+
+// ==================== ARDUINO: NÚCLEO ====================
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define F(s) (s)
+
+inline unsigned long millis() { return (unsigned long)(hal::reloj_us / 1000); }
+inline unsigned long micros() { return (unsigned long)hal::reloj_us; }
+inline void delay(unsigned long ms) { hal::bloquear(hal::reloj_us + (uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { hal::avanzar(us); }
+inline void yield() {}
+inline void configTime(long, int, const char *, const char * = nullptr, const char * = nullptr) {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t nivel) { gpio_set_level((gpio_num_t)pin, nivel); }
+inline int digitalRead(uint8_t pin) { return gpio_get_level((gpio_num_t)pin); }
+
+inline uint16_t analogRead(uint8_t pin) {
+  hal::avanzar(hal::COSTO_ADC_US);
+  return (uint16_t)hal::muestraADC(pin);
+}
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// API de arduino-esp32 3.x: el LEDC se maneja por pin. ledcWrite sobre un pin sin
+// canal asignado falla, como en el core.
+inline bool ledcAttachChannel(uint8_t pin, uint32_t, uint8_t bits, uint8_t) {
+  hal::bits_ledc[pin] = bits;
+  return true;
+}
+inline bool ledcAttach(uint8_t pin, uint32_t frecuencia, uint8_t bits) {
+  return ledcAttachChannel(pin, frecuencia, bits, 0);
+}
+
+inline bool ledcWrite(uint8_t pin, uint32_t duty) {
+  if (hal::bits_ledc[pin] == 0) return false;
+  hal::avanzar(hal::COSTO_LEDC_US);
+  hal::duty_ledc[pin] = (int)duty;
+  return true;
+}
+
+// ==================== ARDUINO: TEMPORIZADORES DE HARDWARE ====================
+// API de arduino-esp32 3.x: timerBegin(frecuencia) toma el primer temporizador libre
+// (el ESP32 tiene 4) y timerAlarm fija la alarma en tics de esa frecuencia. Con
+// recarga, las alarmas caen en múltiplos exactos del período (sin deriva).
+struct hw_timer_t {
+  uint32_t frecuencia = 0;  // 0 = libre
+  uint64_t alarma = 0;
+  bool recarga = false;
+  uint64_t restantes = 0;   // Repeticiones que quedan (0 = sin límite)
+  bool activo = false;
+  uint32_t generacion = 0;
+  void (*isr)() = nullptr;
+};
+
+namespace hal {
+inline hw_timer_t temporizadores_hw[4];
+
+inline void armarTimerHw(hw_timer_t *t, uint64_t desde_us) {
+  uint64_t periodo = std::max<uint64_t>(1, t->alarma * 1000000 / t->frecuencia);
+  uint64_t cuando = desde_us + periodo;
+  uint32_t g = ++t->generacion;
+  programar(cuando, [t, g, cuando] {
+    if (!t->activo || t->generacion != g) return;
+    contadores.interrupciones++;
+    if (t->recarga && !(t->restantes > 0 && --t->restantes == 0)) {
+      armarTimerHw(t, cuando);
+    } else {
+      t->activo = false;
+    }
+    if (t->isr) t->isr();
+  });
+}
+}  // namespace hal
+
+inline hw_timer_t *timerBegin(uint32_t frecuencia) {
+  for (hw_timer_t &t : hal::temporizadores_hw) {
+    if (t.frecuencia == 0) {
+      t = hw_timer_t{};
+      t.frecuencia = frecuencia;
+      return &t;
+    }
+  }
+  return nullptr;
+}
+inline void timerEnd(hw_timer_t *t) { *t = hw_timer_t{}; }
+inline void timerAttachInterrupt(hw_timer_t *t, void (*isr)()) { t->isr = isr; }
+inline void timerAlarm(hw_timer_t *t, uint64_t alarma, bool recarga, uint64_t repeticiones) {
+  t->alarma = alarma;
+  t->recarga = recarga;
+  t->restantes = repeticiones;
+  t->activo = true;
+  hal::armarTimerHw(t, hal::reloj_us);
+}
+inline void timerStop(hw_timer_t *t) { t->activo = false; }
+inline void timerStart(hw_timer_t *t) {
+  t->activo = true;
+  hal::armarTimerHw(t, hal::reloj_us);
+}
+
+// Subconjunto de String de Arduino usado por los sketches
+class String {
+ public:
+  String(const char *s = "") : s_(s) {}
+  String(const std::string &s) : s_(s) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(double v, int decimales = 2) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", decimales, v);
+    s_ = buf;
+  }
+
+  const char *c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  bool startsWith(const String &p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  String substring(unsigned int desde) const { return desde < s_.size() ? s_.substr(desde) : ""; }
+  String substring(unsigned int desde, unsigned int hasta) const {
+    return desde < s_.size() ? s_.substr(desde, hasta - desde) : "";
+  }
+  int indexOf(char c) const {
+    size_t p = s_.find(c);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  void trim() {
+    size_t a = s_.find_first_not_of(" \t\r\n");
+    size_t b = s_.find_last_not_of(" \t\r\n");
+    s_ = a == std::string::npos ? "" : s_.substr(a, b - a + 1);
+  }
+  bool operator==(const char *o) const { return s_ == o; }
+  bool operator==(const String &o) const { return s_ == o.s_; }
+  String &operator+=(const String &o) {
+    s_ += o.s_;
+    return *this;
+  }
+  friend String operator+(const String &a, const String &b) { return a.s_ + b.s_; }
+
+ private:
+  std::string s_;
+};
+
+// Clase base de impresión (igual que Print de Arduino): todo termina en write()
+class Print {
+ public:
+  virtual ~Print() = default;
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return imprimir("%d", v); }
+  size_t print(unsigned int v) { return imprimir("%u", v); }
+  size_t print(long v) { return imprimir("%ld", v); }
+  size_t print(unsigned long v) { return imprimir("%lu", v); }
+  size_t print(double v, int decimales = 2) { return imprimir("%.*f", decimales, v); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &v) {
+    size_t n = print(v);
+    return n + println();
+  }
+  size_t println(double v, int decimales) {
+    size_t n = print(v, decimales);
+    return n + println();
+  }
+
+  size_t printf(const char *fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return n > 0 ? write((const uint8_t *)buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1) : 0;
+  }
+
+ private:
+  size_t imprimir(const char *fmt, ...) {
+    char buf[48];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return write((const uint8_t *)buf, n);
+  }
+};
+
+// Serial de Arduino sobre UART0: TX a la velocidad de la línea, RX lee lo guionado.
+// begin() instala el driver de ESP-IDF sin buffer TX, como el núcleo de Arduino 3.
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baudios) {
+    hal::lineas_uart[0].baudios = (int)baudios;
+    hal::lineas_uart[0].driver = true;
+    hal::lineas_uart[0].buffer_tx = 0;
+  }
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t n) override {
+    hal::salidaUART((const char *)buf, n);
+    return n;
+  }
+  int available() { return (int)hal::rx_uart[0].size(); }
+  int read() {
+    if (hal::rx_uart[0].empty()) return -1;
+    int c = (uint8_t)hal::rx_uart[0][0];
+    hal::rx_uart[0].erase(0, 1);
+    return c;
+  }
+  String readStringUntil(char fin) {
+    size_t p = hal::rx_uart[0].find(fin);
+    std::string s = hal::rx_uart[0].substr(0, p);
+    hal::rx_uart[0].erase(0, p == std::string::npos ? std::string::npos : p + 1);
+    hal::avanzar(s.size() * hal::COSTO_BYTE_UART_US);
+    return s;
+  }
+};
+
+inline HardwareSerial Serial;
+
+// ==================== ARDUINO: I2C (Wire) ====================
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire {
+ public:
+  bool begin(int = -1, int = -1, uint32_t frecuencia = 0) {
+    if (frecuencia) hal::i2c_hz = frecuencia;
+    return true;
+  }
+  void setClock(uint32_t frecuencia) { hal::i2c_hz = frecuencia; }
+  uint32_t getClock() const { return hal::i2c_hz; }
+
+  // Transacción de escritura: los bytes se entregan al dispositivo simulado en endTransmission()
+  void beginTransmission(uint8_t direccion) {
+    dir_ = direccion;
+    buf_.clear();
+  }
+  size_t write(uint8_t b) {
+    if (buf_.size() >= I2C_BUFFER_LENGTH) return 0;
+    buf_.push_back(b);
+    return 1;
+  }
+  size_t write(const uint8_t *datos, size_t n) {
+    size_t escritos = 0;
+    while (escritos < n && write(datos[escritos])) escritos++;
+    return escritos;
+  }
+  uint8_t endTransmission(bool = true) {
+    hal::transferirI2C(1 + buf_.size(), 1);  // Dirección + datos
+    if (hal::oleds.count(dir_)) {
+      hal::oleds[dir_].transaccion(buf_.data(), buf_.size());
+    } else {
+      for (uint8_t b : buf_) hal::lcds[dir_].pcf8574(b);
+    }
+    return 0;
+  }
+
+ private:
+  uint8_t dir_ = 0;
+  std::vector<uint8_t> buf_;
+};
+
+inline TwoWire Wire;
+
+// ==================== ARDUINO: WIFI Y ESP-NOW ====================
+#define WIFI_STA 1
+#define WIFI_IF_STA 0
+
+class WiFiClass {
+ public:
+  bool mode(int) { return true; }
+  bool disconnect(bool = false) { return true; }
+};
+
+inline WiFiClass WiFi;
+
+class WiFiClient {};
+
+inline esp_err_t esp_wifi_get_mac(int, uint8_t mac[6]) {
+  const uint8_t propia[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+  memcpy(mac, propia, 6);
+  return ESP_OK;
+}
+
+// Metadatos de radio de cada trama recibida (rx_ctrl de ESP-IDF, recortado)
+typedef struct {
+  signed rssi : 8;
+  unsigned rate : 5;
+  unsigned : 19;
+  unsigned channel : 4;
+  unsigned : 28;
+  unsigned sig_len : 12;
+  unsigned : 20;
+} wifi_pkt_rx_ctrl_t;
+
+typedef enum { ESP_NOW_SEND_SUCCESS, ESP_NOW_SEND_FAIL } esp_now_send_status_t;
+typedef void (*esp_now_send_cb_t)(const uint8_t *mac_addr, esp_now_send_status_t status);
+// ESP-IDF 5: el callback de recepción recibe origen, destino y metadatos de radio
+typedef struct {
+  uint8_t *src_addr;
+  uint8_t *des_addr;
+  wifi_pkt_rx_ctrl_t *rx_ctrl;
+} esp_now_recv_info_t;
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t *esp_now_info, const uint8_t *data, int data_len);
+
+#define ESP_NOW_MAX_DATA_LEN 250
+#define ESP_NOW_MAX_TOTAL_PEER_NUM 20
+#define ESP_ERR_ESPNOW_BASE 0x3000
+#define ESP_ERR_ESPNOW_FULL (ESP_ERR_ESPNOW_BASE + 4)
+#define ESP_ERR_ESPNOW_NOT_FOUND (ESP_ERR_ESPNOW_BASE + 5)
+#define ESP_ERR_ESPNOW_EXIST (ESP_ERR_ESPNOW_BASE + 7)
+
+typedef struct {
+  uint8_t peer_addr[6];
+  uint8_t lmk[16];
+  uint8_t channel;
+  int ifidx;
+  bool encrypt;
+  void *priv;
+} esp_now_peer_info_t;
+
+namespace hal {
+inline esp_now_send_cb_t espnow_cb_envio = nullptr;
+inline esp_now_recv_cb_t espnow_cb_recepcion = nullptr;
+inline std::vector<std::vector<uint8_t>> tramas_enviadas;  // Historial de la radio
+inline std::vector<std::array<uint8_t, 6>> pares_espnow;    // Lista de pares del driver (máximo 20)
+
+inline int buscarPar(const uint8_t *mac) {
+  for (size_t i = 0; i < pares_espnow.size(); i++) {
+    if (memcmp(pares_espnow[i].data(), mac, 6) == 0) return (int)i;
+  }
+  return -1;
+}
+
+// Llega una trama por radio; el RSSI viaja en rx_ctrl, como en ESP-IDF 5
+inline void recibirEspnow(const uint8_t *mac, const uint8_t *datos, int len, int rssi) {
+  if (espnow_cb_recepcion) {
+    uint8_t origen[6], destino[6];
+    esp_wifi_get_mac(0, destino);
+    memcpy(origen, mac, 6);
+    wifi_pkt_rx_ctrl_t rx_ctrl{};
+    rx_ctrl.rssi = rssi;
+    rx_ctrl.sig_len = 24 + len;
+    esp_now_recv_info_t info{origen, destino, &rx_ctrl};
+    espnow_cb_recepcion(&info, datos, len);
+  }
+}
+
+// Latencia extremo a extremo: desde cada cambio guionado del ADC hasta el primer
+// envío ESP-NOW confirmado después de él
+inline std::vector<uint64_t> cambios_adc;
+inline std::vector<uint64_t> latencias_radio;
+
+inline uint32_t semilla_radio = 777;
+inline bool envioPerdido() {
+  if (radio_falla) return true;
+  if (radio_perdida <= 0) return false;
+  semilla_radio = semilla_radio * 1103515245u + 12345u;
+  return (int)((semilla_radio >> 16) % 100) < radio_perdida;
+}
+}  // namespace hal
+
+inline esp_err_t esp_now_init() { return ESP_OK; }
+inline esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+  hal::espnow_cb_envio = cb;
+  return ESP_OK;
+}
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  hal::espnow_cb_recepcion = cb;
+  return ESP_OK;
+}
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t *par) {
+  if (hal::buscarPar(par->peer_addr) >= 0) return ESP_ERR_ESPNOW_EXIST;
+  if (hal::pares_espnow.size() >= ESP_NOW_MAX_TOTAL_PEER_NUM) return ESP_ERR_ESPNOW_FULL;
+  std::array<uint8_t, 6> mac;
+  memcpy(mac.data(), par->peer_addr, 6);
+  hal::pares_espnow.push_back(mac);
+  return ESP_OK;
+}
+inline esp_err_t esp_now_del_peer(const uint8_t *mac) {
+  int i = hal::buscarPar(mac);
+  if (i < 0) return ESP_ERR_ESPNOW_NOT_FOUND;
+  hal::pares_espnow.erase(hal::pares_espnow.begin() + i);
+  return ESP_OK;
+}
+inline bool esp_now_is_peer_exist(const uint8_t *mac) { return hal::buscarPar(mac) >= 0; }
+
+inline esp_err_t esp_now_send(const uint8_t *mac, const uint8_t *data, size_t len) {
+  if (len > ESP_NOW_MAX_DATA_LEN) return ESP_FAIL;
+  if (hal::buscarPar(mac) < 0) return ESP_ERR_ESPNOW_NOT_FOUND;
+  hal::avanzar(hal::COSTO_ESPNOW_US);
+  hal::contadores.bytes_radio += len;
+  hal::contadores.tramas_radio++;
+  hal::tramas_enviadas.emplace_back(data, data + len);
+  uint8_t destino[6];
+  memcpy(destino, mac, 6);
+  esp_now_send_status_t estado = hal::envioPerdido() ? ESP_NOW_SEND_FAIL : ESP_NOW_SEND_SUCCESS;
+  hal::programar(hal::reloj_us + hal::latencia_radio_us, [destino, estado]() {
+    if (estado == ESP_NOW_SEND_SUCCESS) {
+      for (uint64_t t : hal::cambios_adc) hal::latencias_radio.push_back(hal::reloj_us - t);
+      hal::cambios_adc.clear();
+    } else {
+      hal::contadores.tramas_radio_fallidas++;
+    }
+    if (hal::espnow_cb_envio) hal::espnow_cb_envio(destino, estado);
+  });
+  return ESP_OK;
+}
+
+// ==================== BLYNK ====================
+#define V0 0
+#define V1 1
+#define V2 2
+#define V3 3
+#define V4 4
+#define V5 5
+
+class BlynkParam {
+ public:
+  explicit BlynkParam(const std::string &v) : v_(v) {}
+  int asInt() const { return atoi(v_.c_str()); }
+  double asDouble() const { return atof(v_.c_str()); }
+  float asFloat() const { return (float)asDouble(); }
+  const char *asStr() const { return v_.c_str(); }
+
+ private:
+  std::string v_;
+};
+
+namespace hal {
+typedef void (*ManejadorBlynk)(const BlynkParam &);
+inline std::map<int, ManejadorBlynk> manejadores_blynk;
+inline std::vector<std::pair<int, std::string>> blynk_pendientes;  // Escrituras V desde la app
+inline std::vector<uint64_t> blynk_llegadas;                       // Instante de llegada de cada una
+inline std::vector<uint64_t> latencias_blynk;                      // Llegada -> BLYNK_WRITE (us)
+inline std::map<int, std::string> blynk_valores;                  // Último valor publicado por pin
+
+struct RegistroBlynk {
+  RegistroBlynk(int pin, ManejadorBlynk m) { manejadores_blynk[pin] = m; }
+};
+}  // namespace hal
+
+#define BLYNK_WRITE(pin)                                                     \
+  void blynkWrite_##pin(const BlynkParam &param);                            \
+  static hal::RegistroBlynk registroBlynk_##pin(pin, blynkWrite_##pin);     \
+  void blynkWrite_##pin(const BlynkParam &param)
+
+class BlynkHost {
+ public:
+  void begin(const char *, const char *, const char *, const char * = "blynk.cloud", int = 80) {}
+  bool connected() const { return hal::nube_conectada; }
+
+  // Entrega a los BLYNK_WRITE las escrituras que llegaron desde la app
+  void run() {
+    hal::avanzar(hal::COSTO_GPIO_US);
+    if (!hal::nube_conectada) return;
+    auto pendientes = std::move(hal::blynk_pendientes);
+    auto llegadas = std::move(hal::blynk_llegadas);
+    hal::blynk_pendientes.clear();
+    hal::blynk_llegadas.clear();
+    for (size_t i = 0; i < pendientes.size(); i++) {
+      auto m = hal::manejadores_blynk.find(pendientes[i].first);
+      if (m == hal::manejadores_blynk.end()) continue;
+      hal::latencias_blynk.push_back(hal::reloj_us - llegadas[i]);
+      m->second(BlynkParam(pendientes[i].second));
+    }
+  }
+
+  template <typename T>
+  void virtualWrite(int pin, const T &valor) {
+    std::string v = String(valor).c_str();
+    if (!hal::nube_conectada) return;
+    hal::avanzar(hal::COSTO_BLYNK_US);
+    // Encabezado del protocolo Blynk (5 bytes) + "vw\0<pin>\0<valor>"
+    hal::contadores.bytes_nube += 5 + 3 + std::to_string(pin).size() + 1 + v.size();
+    hal::contadores.mensajes_nube++;
+    if (marcado_) hal::contadores.valores_historicos++;
+    hal::blynk_valores[pin] = v;
+  }
+
+  // Las escrituras entre beginGroup y endGroup viajan juntas; con marca de tiempo
+  // (ms desde 1970) quedan registradas en ese instante en lugar del de llegada
+  void beginGroup() {
+    if (!hal::nube_conectada) return;
+    hal::avanzar(hal::COSTO_BLYNK_US);
+    hal::contadores.bytes_nube += 5 + 1;  // "g"
+    hal::contadores.mensajes_nube++;
+  }
+  void beginGroup(uint64_t marcaMs) {
+    if (!hal::nube_conectada) return;
+    hal::avanzar(hal::COSTO_BLYNK_US);
+    hal::contadores.bytes_nube += 5 + 2 + std::to_string(marcaMs).size();  // "t\0<ms>"
+    hal::contadores.mensajes_nube++;
+    marcado_ = true;
+  }
+  void endGroup() {
+    marcado_ = false;
+  }
+
+ private:
+  bool marcado_ = false;
+};
+
+inline BlynkHost Blynk;
+
+// Temporizador de Blynk (SimpleTimer): intervalos consultados por run()
+class BlynkTimer {
+ public:
+  typedef void (*Manejador)();
+
+  int setInterval(unsigned long ms, Manejador f) { return agregar(ms, f, 0); }
+  int setTimeout(unsigned long ms, Manejador f) { return agregar(ms, f, 1); }
+  int setTimer(unsigned long ms, Manejador f, unsigned n) { return agregar(ms, f, n); }
+
+  void run() {
+    unsigned long ahora = millis();
+    for (size_t i = 0; i < t_.size(); i++) {
+      Temporizador &t = t_[i];
+      if (!t.activo || ahora - t.anterior < t.periodo) continue;
+      t.anterior += t.periodo;
+      if (ahora - t.anterior >= t.periodo) t.anterior = ahora;  // No acumula atrasos
+      t.f();
+      if (t.repeticiones && ++t.hechas >= t.repeticiones) t.activo = false;
+    }
+  }
+
+  void restartTimer(int id) { t_[id].anterior = millis(); }
+  void enable(int id) { t_[id].activo = true; }
+  void disable(int id) { t_[id].activo = false; }
+  void deleteTimer(int id) { t_[id].activo = false; }
+  bool isEnabled(int id) const { return t_[id].activo; }
+
+ private:
+  struct Temporizador {
+    unsigned long periodo;
+    unsigned long anterior;
+    Manejador f;
+    unsigned repeticiones;
+    unsigned hechas;
+    bool activo;
+  };
+  int agregar(unsigned long ms, Manejador f, unsigned n) {
+    t_.push_back({ms, millis(), f, n, 0, true});
+    return (int)t_.size() - 1;
+  }
+  std::vector<Temporizador> t_;
+};
+
+// ==================== PANTALLA LCD 16x2 I2C (PCF8574) ====================
+class LiquidCrystal_I2C : public Print {
+ public:
+  LiquidCrystal_I2C(uint8_t dir, uint8_t columnas, uint8_t filas)
+      : dir_(dir), columnas_(columnas), filas_(filas), texto_(filas, std::string(columnas, ' ')) {}
+
+  void init() {
+    for (int i = 0; i < 6; i++) comando();
+  }
+  void begin() { init(); }
+  void backlight() { hal::transferirI2C(2); }
+  void noBacklight() { hal::transferirI2C(2); }
+  void clear() {
+    comando();
+    delayMicroseconds(2000);  // El HD44780 tarda ~2 ms en limpiar la DDRAM
+    hal::lcds[dir_].comando(0x01);
+    for (auto &f : texto_) f.assign(columnas_, ' ');
+    col_ = fila_ = 0;
+  }
+  void home() {
+    comando();
+    delayMicroseconds(2000);
+    col_ = fila_ = 0;
+  }
+  void setCursor(uint8_t col, uint8_t fila) {
+    comando();
+    col_ = col;
+    fila_ = fila < filas_ ? fila : filas_ - 1;
+    hal::lcds[dir_].comando((uint8_t)(0x80 | ((fila_ & 1 ? 0x40 : 0) + (fila_ & 2 ? 0x14 : 0) + col)));
+  }
+
+  using Print::write;
+  size_t write(uint8_t c) override {
+    comando();
+    hal::lcds[dir_].dato(c);
+    if (col_ < columnas_) texto_[fila_][col_] = (char)c;
+    col_++;
+    return 1;
+  }
+
+  // Contenido visible (solo en el host, para inspección)
+  const std::string &linea(uint8_t fila) const { return texto_[fila]; }
+
+ private:
+  // Cada byte al HD44780 son 2 nibbles x 3 escrituras al PCF8574 (dato, EN alto, EN bajo),
+  // cada una en su propia transacción I2C (dirección + dato)
+  void comando() { hal::transferirI2C(12, 6); }
+
+  uint8_t dir_, columnas_, filas_;
+  uint8_t col_ = 0, fila_ = 0;
+  std::vector<std::string> texto_;
+};
+
+// ==================== PANTALLA OLED SSD1306 ====================
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define BLACK SSD1306_BLACK
+#define WHITE SSD1306_WHITE
+
+class Adafruit_SSD1306 : public Print {
+ public:
+  Adafruit_SSD1306(uint8_t ancho, uint8_t alto, TwoWire *, int8_t)
+      : ancho_(ancho), alto_(alto), buffer_(ancho * ((alto + 7) / 8), 0) {}
+
+  bool begin(uint8_t, uint8_t dir, bool = true, bool = true) {
+    dir_ = dir;
+    hal::oleds[dir_];
+    hal::transferirI2C(26, 1);  // Secuencia de inicialización
+    return true;
+  }
+
+  // Envía el framebuffer completo: comandos de ventana + datos en bloques de 32 bytes
+  void display() {
+    hal::transferirI2C(8, 1);
+    size_t n = buffer_.size();
+    size_t bloques = (n + 30) / 31;
+    hal::transferirI2C(n + bloques * 2, bloques);
+    memcpy(hal::oleds[dir_].gddram, buffer_.data(), std::min(n, sizeof(hal::MockOLED::gddram)));
+  }
+
+  void clearDisplay() { std::fill(buffer_.begin(), buffer_.end(), 0); }
+  void setTextSize(uint8_t s) { tam_ = s ? s : 1; }
+  void setTextColor(uint16_t c) { color_ = c; }
+  void setCursor(int16_t x, int16_t y) {
+    x_ = x;
+    y_ = y;
+  }
+
+  // Dibuja cada carácter como una celda de 6x8 (patrón derivado del código del carácter)
+  using Print::write;
+  size_t write(uint8_t c) override {
+    if (c == '\n') {
+      x_ = 0;
+      y_ += 8 * tam_;
+      return 1;
+    }
+    if (c == '\r') return 1;
+    for (int i = 0; i < 6 * tam_; i++) {
+      int x = x_ + i;
+      int pagina = y_ / 8;
+      if (x >= ancho_ || pagina >= alto_ / 8) break;
+      uint8_t col = (i / tam_ < 5 && c != ' ') ? (uint8_t)((c * 31 + (i / tam_) * 17) | 0x01) : 0;
+      buffer_[pagina * ancho_ + x] = color_ ? col : 0;
+    }
+    x_ += 6 * tam_;
+    return 1;
+  }
+
+  uint8_t *getBuffer() { return buffer_.data(); }
+  int16_t width() const { return ancho_; }
+  int16_t height() const { return alto_; }
+
+ private:
+  int16_t ancho_, alto_;
+  uint8_t dir_ = 0x3C;
+  std::vector<uint8_t> buffer_;
+  int16_t x_ = 0, y_ = 0;
+  uint8_t tam_ = 1;
+  uint16_t color_ = 1;
+};
+
+// ==================== PLANTA TÉRMICA (guion) ====================
+// Primer orden: la temperatura tiende a 'ambiente - ganancia * u' con constante de
+// tiempo 'tau', donde u (0..1) es el duty LEDC del pin del actuador (enfría).
+// El DHT22 lee la temperatura de la planta con su resolución de 0,1 °C.
+namespace hal {
+constexpr uint64_t PASO_PLANTA_US = 100000;
+
+struct PlantaTermica {
+  bool activa = false;
+  int pin = 0;
+  double ambiente = 25, tau_s = 60, ganancia = 10;
+  double temperatura = 25;
+  uint64_t inicio_us = 0;
+  std::vector<std::pair<uint64_t, double>> traza;  // (instante, temperatura) en cada paso
+};
+inline PlantaTermica planta;
+
+inline void pasoPlanta() {
+  double maximo = (double)((1u << bits_ledc[planta.pin]) - 1);
+  double u = bits_ledc[planta.pin] ? std::min(1.0, std::max(0.0, duty_ledc[planta.pin] / maximo)) : 0.0;
+  double destino = planta.ambiente - planta.ganancia * u;
+  planta.temperatura = destino + (planta.temperatura - destino) * std::exp(-(PASO_PLANTA_US / 1e6) / planta.tau_s);
+  planta.traza.emplace_back(reloj_us, planta.temperatura);
+  dht_temperatura = (float)(std::round(planta.temperatura * 10) / 10);
+  programar(reloj_us + PASO_PLANTA_US, pasoPlanta);
+}
+
+inline void iniciarPlanta(int pin, double ambiente, double tau_s, double ganancia) {
+  planta.activa = true;
+  planta.pin = pin;
+  planta.ambiente = ambiente;
+  planta.tau_s = tau_s;
+  planta.ganancia = ganancia;
+  planta.temperatura = dht_temperatura;
+  planta.inicio_us = reloj_us;
+  pasoPlanta();
+}
+}  // namespace hal
+
+// ==================== SENSOR DHT22 ====================
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+ public:
+  DHT(uint8_t, uint8_t) {}
+  void begin() {}
+  // Bit-bang del protocolo de un hilo: bloquea ~5 ms con interrupciones deshabilitadas
+  float readTemperature() {
+    hal::avanzar(hal::COSTO_DHT_US);
+    return hal::dht_temperatura;
+  }
+  float readHumidity() {
+    hal::avanzar(hal::COSTO_DHT_US);
+    return hal::dht_humedad;
+  }
+};
@@ -0,0 +1,437 @@
+/*
+ * EJECUTOR DE SKETCHES EN LINUX Y BENCHMARK DE LATENCIA DEL LAZO
+ *
+ * Corre setup()/loop() (Arduino) o app_main() (ESP-IDF) de cualquier sketch del
+ * repositorio contra la HAL simulada, aplicando un guion de entradas en tiempo
+ * simulado. Al terminar reporta latencia por iteración, tiempo de CPU, reposo
+ * (despertares y sueño ligero) y bytes emitidos por I2C, UART, radio y nube.
+ *
+ * Compilación (desde la raíz del repositorio), por ejemplo para el sistema de riego:
+ *   g++ -std=c++20 -O2 -I simulacion-host -include simulacion-host/hal_host.h \
+ *       -x c++ proyecto-de-aula/Code_Sistema_de_Riego.c++ \
+ *       -x none simulacion-host/main_host.cpp -pthread -o riego_sim
+ *
+ * Uso:
+ *   ./riego_sim [guion.txt] [-t duracion_ms] [-q] [-c]
+ *     -t  Tiempo simulado total (por defecto 10000 ms)
+ *     -q  No copia la salida serial del sketch a stdout
+ *     -c  Imprime el resumen también como una línea CSV (para comparar corridas)
+ *
+ * Formato del guion (una entrada por línea, '#' inicia un comentario):
+ *   <t_ms> adc <gpio> <crudo>         Valor del ADC en un GPIO (0-4095)
+ *   <t_ms> ruido <gpio> <amplitud>    Ruido uniforme (+/- amplitud) sumado a cada conversión
+ *   <t_ms> gpio <gpio> <nivel>        Nivel de un pin de entrada (dispara su interrupción)
+ *   <t_ms> touch <pad> <lectura>      Lectura de un pad táctil (menor = tocado; dispara la
+ *                                     interrupción si cruza el umbral)
+ *   <t_ms> uart <puerto> <texto>      Llega una línea por UART (se agrega '\n')
+ *   <t_ms> uart_archivo <puerto> <baudios> <ruta>
+ *                                     El contenido del archivo llega por UART a esa velocidad
+ *   <t_ms> uart_rafaga <puerto> <baudios> <líneas>
+ *                                     Llegan 'líneas' números (0-99, con un 5 % de inválidos)
+ *                                     seguidos, a esa velocidad
+ *   <t_ms> blynk <vpin> <valor>       Escritura desde la app Blynk (BLYNK_WRITE)
+ *   <t_ms> espnow <mac> <hex> [rssi]  Llega una trama ESP-NOW (mac aa:bb:cc:dd:ee:ff, RSSI en dBm)
+ *   <t_ms> emisores <n> <hz> <ms> [pérdida]
+ *                                     'n' emisores virtuales (formato de trama_espnow.h) piden
+ *                                     emparejarse y envían 'hz' tramas por segundo durante 'ms';
+ *                                     'pérdida' es el porcentaje de tramas que no llegan
+ *   <t_ms> dht <temp> <humedad>       Lectura del DHT22 ("nan" simula un error; por RMT, que no
+ *                                     responde)
+ *   <t_ms> dht corruptas <porcentaje> Tramas del DHT22 capturadas por RMT con un bit invertido
+ *   <t_ms> planta <gpio> <ambiente> <tau_s> <ganancia>
+ *                                     Desde aquí la temperatura del DHT22 la da una planta
+ *                                     térmica de primer orden: tiende a 'ambiente' con
+ *                                     constante 'tau_s' y el duty LEDC de ese pin la enfría
+ *                                     hasta 'ganancia' °C; el informe incluye su asentamiento
+ *   <t_ms> radio ok|falla             Resultado de los siguientes envíos ESP-NOW
+ *   <t_ms> radio perdida <porcentaje> Pérdida aleatoria de envíos ESP-NOW
+ *   <t_ms> radio latencia <us>        Tiempo del envío a OnDataSent
+ *   <t_ms> nube 1|0                   Conexión con Blynk disponible o perdida
+ *   <t_ms> flash <ruta>               La partición de datos vive en ese archivo: lo que quedó de
+ *                                     una corrida anterior se lee al montar (se aplica al cargar)
+ *   <t_ms> epoca <segundos>           Hora UTC (time()) al arrancar la simulación (se aplica al
+ *                                     cargar); por defecto 2026-01-01 00:00:00
+ */
+
+#include "hal_host.h"
+#include "../Práctica ESPNOW + ADC + PWM/trama_espnow.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <time.h>
+
+// Puntos de entrada del sketch: según el tipo de programa existe uno u otro
+void setup() __attribute__((weak));
+void loop() __attribute__((weak));
+void app_main(void) __attribute__((weak));
+
+// ==================== RÁFAGAS DE LÍNEAS POR UART ====================
+// Números de 0 a 99, uno por línea, con un 5 % de líneas inválidas. La secuencia
+// es siempre la misma para poder comparar corridas.
+static std::string generarLineas(long lineas) {
+  static const char *const INVALIDAS[] = {"abc", "100", "-3", "07", " 5"};
+  uint32_t semilla = 12345;
+  std::string datos;
+  for (long i = 0; i < lineas; i++) {
+    semilla = semilla * 1103515245u + 12345u;
+    uint32_t r = (semilla >> 8) % 2000;
+    if (r < 100) {
+      datos += INVALIDAS[r % 5];
+    } else {
+      datos += std::to_string(r % 100);
+    }
+    datos += '\n';
+  }
+  return datos;
+}
+
+// ==================== EMISORES ESP-NOW VIRTUALES ====================
+// Cada emisor tiene MAC 24:0a:c4:00:<i>, pide emparejarse y luego envía una muestra
+// por trama (una rampa distinta por emisor) con su propio número de secuencia y RSSI.
+static void programarEmisores(uint64_t t0, int n, int hz, uint64_t duracion_us, int perdida) {
+  uint32_t semilla = 4242;
+  uint64_t periodo = 1000000 / (hz > 0 ? hz : 1);
+  for (int e = 0; e < n; e++) {
+    std::array<uint8_t, 6> mac = {0x24, 0x0A, 0xC4, 0x00, (uint8_t)(e >> 8), (uint8_t)e};
+    int rssi = -35 - (e * 7) % 55;
+    uint64_t inicio = t0 + (uint64_t)e * periodo / n;  // Escalonados dentro del periodo
+
+    std::vector<uint8_t> solicitud(trama::TAM_CONTROL);
+    trama::codificarControl(trama::Control::Solicitud, (uint8_t)e, solicitud.data(), solicitud.size());
+    hal::programar(inicio, [=] { hal::recibirEspnow(mac.data(), solicitud.data(), (int)solicitud.size(), rssi); });
+
+    uint16_t seq = 0;
+    for (uint64_t t = inicio + periodo; t < t0 + duracion_us; t += periodo, seq++) {
+      semilla = semilla * 1103515245u + 12345u;
+      if ((int)((semilla >> 16) % 100) < perdida) continue;
+      trama::Muestra m = {(uint32_t)(t / 1000), (uint16_t)((seq * 16 + e * 512) % 4096)};
+      std::vector<uint8_t> datos(trama::tamano(1));
+      trama::codificar((uint8_t)e, 6, seq, &m, 1, datos.data(), datos.size());
+      hal::programar(t, [=] { hal::recibirEspnow(mac.data(), datos.data(), (int)datos.size(), rssi); });
+    }
+  }
+}
+
+// ==================== CARGA DEL GUION ====================
+static bool cargarGuion(const char *ruta) {
+  std::ifstream f(ruta);
+  if (!f) {
+    fprintf(stderr, "No se pudo abrir el guion: %s\n", ruta);
+    return false;
+  }
+  std::string linea;
+  int n = 0;
+  while (std::getline(f, linea)) {
+    n++;
+    if (!linea.empty() && linea.back() == '\r') linea.pop_back();
+    size_t c = linea.find('#');
+    if (c != std::string::npos) linea.erase(c);
+    std::istringstream in(linea);
+    double t_ms;
+    std::string tipo;
+    if (!(in >> t_ms >> tipo)) continue;
+    uint64_t t = (uint64_t)(t_ms * 1000);
+
+    if (tipo == "adc" || tipo == "ruido" || tipo == "gpio" || tipo == "touch") {
+      int canal, valor;
+      in >> canal >> valor;
+      if (tipo == "adc") {
+        hal::programar(t, [=] {
+          hal::adc_gpio[canal] = valor;
+          hal::cambios_adc.push_back(hal::reloj_us);
+        });
+      }
+      if (tipo == "ruido") hal::programar(t, [=] { hal::ruido_adc[canal] = valor; });
+      if (tipo == "gpio") hal::programar(t, [=] { hal::cambiarNivel(canal, valor); });
+      if (tipo == "touch") hal::programar(t, [=] { hal::cambiarTouch(canal, (uint16_t)valor); });
+    } else if (tipo == "uart") {
+      int puerto;
+      in >> puerto;
+      std::string texto;
+      std::getline(in >> std::ws, texto);
+      hal::programar(t, [=] { hal::recibirUart((uart_port_t)puerto, texto + "\n"); });
+    } else if (tipo == "uart_archivo") {
+      int puerto, baudios;
+      std::string ruta;
+      in >> puerto >> baudios;
+      std::getline(in >> std::ws, ruta);
+      std::ifstream archivo(ruta, std::ios::binary);
+      if (!archivo) {
+        fprintf(stderr, "No se pudo abrir %s\n", ruta.c_str());
+        continue;
+      }
+      std::stringstream datos;
+      datos << archivo.rdbuf();
+      hal::programarRafagaUart((uart_port_t)puerto, t, baudios, datos.str());
+    } else if (tipo == "uart_rafaga") {
+      int puerto, baudios;
+      long lineas;
+      in >> puerto >> baudios >> lineas;
+      hal::programarRafagaUart((uart_port_t)puerto, t, baudios, generarLineas(lineas));
+    } else if (tipo == "blynk") {
+      int pin;
+      std::string valor;
+      in >> pin >> valor;
+      hal::programar(t, [=] {
+        hal::blynk_pendientes.emplace_back(pin, valor);
+        hal::blynk_llegadas.push_back(hal::reloj_us);
+      });
+    } else if (tipo == "espnow") {
+      std::string mac_txt, hex;
+      in >> mac_txt >> hex;
+      int rssi = -60, r;
+      if (in >> r) rssi = r;
+      uint8_t mac[6] = {};
+      sscanf(mac_txt.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &mac[0], &mac[1], &mac[2], &mac[3],
+             &mac[4], &mac[5]);
+      std::vector<uint8_t> datos;
+      for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        datos.push_back((uint8_t)strtoul(hex.substr(i, 2).c_str(), nullptr, 16));
+      }
+      hal::programar(t, [=] {
+        hal::recibirEspnow(mac, datos.data(), (int)datos.size(), rssi);
+      });
+    } else if (tipo == "emisores") {
+      int n = 0, hz = 0, perdida = 0;
+      double ms = 0;
+      in >> n >> hz >> ms >> perdida;
+      programarEmisores(t, n, hz, (uint64_t)(ms * 1000), perdida);
+    } else if (tipo == "dht") {
+      std::string temp, hum;
+      in >> temp >> hum;
+      if (temp == "corruptas") {
+        int porcentaje = atoi(hum.c_str());
+        hal::programar(t, [=] { hal::dht_corruptas = porcentaje; });
+      } else {
+        float tv = strtof(temp.c_str(), nullptr), hv = strtof(hum.c_str(), nullptr);
+        hal::programar(t, [=] {
+          hal::dht_temperatura = tv;
+          hal::dht_humedad = hv;
+        });
+      }
+    } else if (tipo == "planta") {
+      int pin;
+      double ambiente, tau, ganancia;
+      in >> pin >> ambiente >> tau >> ganancia;
+      hal::programar(t, [=] { hal::iniciarPlanta(pin, ambiente, tau, ganancia); });
+    } else if (tipo == "radio") {
+      std::string estado;
+      in >> estado;
+      if (estado == "perdida" || estado == "latencia") {
+        long valor = 0;
+        in >> valor;
+        if (estado == "perdida") hal::programar(t, [=] { hal::radio_perdida = (int)valor; });
+        if (estado == "latencia") hal::programar(t, [=] { hal::latencia_radio_us = (uint64_t)valor; });
+      } else {
+        bool falla = estado == "falla";
+        hal::programar(t, [=] { hal::radio_falla = falla; });
+      }
+    } else if (tipo == "nube") {
+      int conectada;
+      in >> conectada;
+      hal::programar(t, [=] { hal::nube_conectada = conectada != 0; });
+    } else if (tipo == "flash") {
+      std::getline(in >> std::ws, hal::flash.ruta);
+    } else if (tipo == "epoca") {
+      long long segundos = 0;
+      in >> segundos;
+      hal::epoca_inicio = (time_t)segundos;
+    } else {
+      fprintf(stderr, "%s:%d: tipo de evento desconocido '%s'\n", ruta, n, tipo.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// ==================== MEDICIÓN POR ITERACIÓN ====================
+struct Iteracion {
+  uint64_t sim_us;      // Duración simulada (incluye esperas)
+  uint64_t ocupado_us;  // Trabajo simulado de CPU dentro de la iteración
+  uint64_t cpu_ns;      // Tiempo de CPU real del host
+};
+
+static std::vector<Iteracion> iteraciones;
+static uint64_t marca_sim = 0, marca_ocupado = 0, marca_cpu = 0;
+
+static uint64_t cpuHostNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void marcarIteracion() {
+  uint64_t cpu = cpuHostNs();
+  iteraciones.push_back({hal::reloj_us - marca_sim, hal::us_ocupado - marca_ocupado, cpu - marca_cpu});
+  marca_sim = hal::reloj_us;
+  marca_ocupado = hal::us_ocupado;
+  marca_cpu = cpu;
+}
+
+static uint64_t percentil(std::vector<uint64_t> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5))];
+}
+
+// Asentamiento de la planta térmica: el valor final es el promedio del último 20 % de
+// la traza; se considera asentada desde el último instante en que salió de la banda
+static void informePlanta() {
+  constexpr double BANDA = 0.5;  // °C
+  const auto &traza = hal::planta.traza;
+  size_t desde = traza.size() - traza.size() / 5;
+  double final = 0, minimo = 1e9, maximo = -1e9;
+  for (size_t i = desde; i < traza.size(); i++) {
+    final += traza[i].second;
+    minimo = std::min(minimo, traza[i].second);
+    maximo = std::max(maximo, traza[i].second);
+  }
+  final /= (double)(traza.size() - desde);
+  uint64_t asentada = hal::planta.inicio_us;
+  double sobrepaso = 0;
+  double inicial = traza.front().second;
+  for (const auto &[t, temp] : traza) {
+    if (std::fabs(temp - final) > BANDA) asentada = t;
+    // Pasarse del final en el sentido del movimiento
+    sobrepaso = std::max(sobrepaso, inicial > final ? final - temp : temp - final);
+  }
+  fprintf(stderr, "Planta térmica         : final %.2f °C, rizado %.2f °C p-p, asentada (±%.1f °C) a los %.1f s, "
+                  "sobrepaso %.2f °C\n",
+          final, maximo - minimo, BANDA, (asentada - hal::planta.inicio_us) / 1e6, sobrepaso);
+}
+
+static void informe(bool csv) {
+  std::vector<uint64_t> sim, ocupado, cpu;
+  for (const auto &it : iteraciones) {
+    sim.push_back(it.sim_us);
+    ocupado.push_back(it.ocupado_us);
+    cpu.push_back(it.cpu_ns);
+  }
+  auto promedio = [](const std::vector<uint64_t> &v) {
+    uint64_t s = 0;
+    for (auto x : v) s += x;
+    return v.empty() ? 0.0 : (double)s / v.size();
+  };
+  double seg = hal::reloj_us / 1e6;
+  const hal::Contadores &c = hal::contadores;
+
+  fprintf(stderr, "\n==================== INFORME DE SIMULACIÓN ====================\n");
+  fprintf(stderr, "Tiempo simulado        : %.1f ms\n", hal::reloj_us / 1000.0);
+  fprintf(stderr, "Iteraciones            : %zu\n", iteraciones.size());
+  fprintf(stderr, "Latencia de iteración  : min %llu  p50 %llu  p99 %llu  max %llu us (simulado)\n",
+          (unsigned long long)percentil(sim, 0), (unsigned long long)percentil(sim, 0.5),
+          (unsigned long long)percentil(sim, 0.99), (unsigned long long)percentil(sim, 1));
+  fprintf(stderr, "Trabajo por iteración  : prom %.1f  p99 %llu  max %llu us (CPU simulada)\n",
+          promedio(ocupado), (unsigned long long)percentil(ocupado, 0.99),
+          (unsigned long long)percentil(ocupado, 1));
+  fprintf(stderr, "CPU del host           : prom %.0f  max %llu ns por iteración\n", promedio(cpu),
+          (unsigned long long)percentil(cpu, 1));
+  fprintf(stderr, "Ocupación de CPU       : %.1f %% (simulada)\n",
+          hal::reloj_us ? 100.0 * hal::us_ocupado / hal::reloj_us : 0.0);
+  fprintf(stderr, "Reposo                 : %.1f %% ociosa (%.1f %% en sueño ligero), %llu despertares "
+                  "(%.1f/s), %llu interrupciones\n",
+          hal::reloj_us ? 100.0 * hal::us_dormido / hal::reloj_us : 0.0,
+          hal::reloj_us ? 100.0 * hal::us_sueno_ligero / hal::reloj_us : 0.0,
+          (unsigned long long)c.despertares, seg ? c.despertares / seg : 0.0,
+          (unsigned long long)c.interrupciones);
+  fprintf(stderr, "I2C                    : %llu bytes en %llu transacciones (%.0f B/s a %u Hz)\n",
+          (unsigned long long)c.bytes_i2c, (unsigned long long)c.transacciones_i2c,
+          seg ? c.bytes_i2c / seg : 0.0, (unsigned)hal::i2c_hz);
+  fprintf(stderr, "UART                   : %llu bytes\n", (unsigned long long)c.bytes_uart);
+  if (c.bytes_uart_rx) {
+    fprintf(stderr, "UART (recepción)       : %llu bytes al driver, %llu perdidos por buffer lleno\n",
+            (unsigned long long)c.bytes_uart_rx, (unsigned long long)c.bytes_uart_perdidos);
+  }
+  fprintf(stderr, "Radio ESP-NOW          : %llu bytes en %llu tramas (%llu fallidas, %.1f tramas/min)\n",
+          (unsigned long long)c.bytes_radio, (unsigned long long)c.tramas_radio,
+          (unsigned long long)c.tramas_radio_fallidas, seg ? c.tramas_radio * 60.0 / seg : 0.0);
+  fprintf(stderr, "Nube Blynk             : %llu bytes en %llu mensajes\n",
+          (unsigned long long)c.bytes_nube, (unsigned long long)c.mensajes_nube);
+  if (c.valores_historicos) {
+    fprintf(stderr, "Nube (diferida)        : %llu valores enviados con su marca de tiempo\n",
+            (unsigned long long)c.valores_historicos);
+  }
+  if (hal::flash.usada) {
+    auto [menos, mas] = std::minmax_element(hal::flash.borrados.begin(), hal::flash.borrados.end());
+    fprintf(stderr, "Flash (partición)      : %llu bytes programados en %llu escrituras, %llu leídos, "
+                    "borrados por sector %u-%u, %llu violaciones\n",
+            (unsigned long long)hal::flash.bytes_programados, (unsigned long long)hal::flash.programaciones,
+            (unsigned long long)hal::flash.bytes_leidos, *menos, *mas,
+            (unsigned long long)hal::flash.violaciones);
+  }
+  for (const auto &[dir, lcd] : hal::lcds) {
+    fprintf(stderr, "LCD 0x%02X (final)       : [%s] [%s]\n", dir, lcd.fila(0, 16).c_str(), lcd.fila(1, 16).c_str());
+  }
+  if (!hal::latencias_radio.empty()) {
+    fprintf(stderr, "Latencia ADC->radio    : p50 %llu  max %llu us (%zu cambios)\n",
+            (unsigned long long)percentil(hal::latencias_radio, 0.5),
+            (unsigned long long)percentil(hal::latencias_radio, 1), hal::latencias_radio.size());
+  }
+  if (!hal::latencias_blynk.empty()) {
+    fprintf(stderr, "Latencia app->BLYNK_WRITE: p50 %llu  max %llu us (%zu comandos)\n",
+            (unsigned long long)percentil(hal::latencias_blynk, 0.5),
+            (unsigned long long)percentil(hal::latencias_blynk, 1), hal::latencias_blynk.size());
+  }
+  if (!hal::planta.traza.empty()) informePlanta();
+
+  if (csv) {
+    fprintf(stderr, "csv,tiempo_ms,iteraciones,p50_us,p99_us,max_us,cpu_host_ns,ocupacion,i2c,uart,radio,"
+                    "tramas,nube,mensajes\n");
+    fprintf(stderr, "csv,%.1f,%zu,%llu,%llu,%llu,%.0f,%.4f,%llu,%llu,%llu,%llu,%llu,%llu\n",
+            hal::reloj_us / 1000.0, iteraciones.size(), (unsigned long long)percentil(sim, 0.5),
+            (unsigned long long)percentil(sim, 0.99), (unsigned long long)percentil(sim, 1),
+            promedio(cpu), hal::reloj_us ? (double)hal::us_ocupado / hal::reloj_us : 0.0,
+            (unsigned long long)c.bytes_i2c, (unsigned long long)c.bytes_uart,
+            (unsigned long long)c.bytes_radio, (unsigned long long)c.tramas_radio,
+            (unsigned long long)c.bytes_nube, (unsigned long long)c.mensajes_nube);
+  }
+}
+
+// ==================== PROGRAMA PRINCIPAL ====================
+int main(int argc, char **argv) {
+  uint64_t duracion_ms = 10000;
+  bool csv = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      duracion_ms = strtoull(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "-q")) {
+      hal::eco = false;
+    } else if (!strcmp(argv[i], "-c")) {
+      csv = true;
+    } else if (!cargarGuion(argv[i])) {
+      return 1;
+    }
+  }
+
+  hal::limite_us = duracion_ms * 1000;
+  hal::alCeder = marcarIteracion;
+  marca_cpu = cpuHostNs();
+
+  try {
+    hal::aplicarEventos();  // Entradas guionadas en t = 0
+    if (app_main) {
+      app_main();
+    } else if (setup && loop) {
+      setup();
+      marcarIteracion();
+      iteraciones.clear();  // setup() no cuenta como iteración del lazo
+      while (true) {
+        uint64_t antes = hal::reloj_us;
+        loop();
+        hal::ceder();
+        // loop() vacío: el núcleo quedaría girando, se salta hasta el próximo evento
+        if (hal::reloj_us == antes) hal::dormirHastaEvento(hal::limite_us);
+      }
+    } else {
+      fprintf(stderr, "El sketch no define setup()/loop() ni app_main()\n");
+      return 1;
+    }
+  } catch (const hal::FinSimulacion &) {
+  }
+
+  fflush(stdout);
+  informe(csv);
+  fflush(stderr);
+  _Exit(0);  // Las tareas simuladas quedan bloqueadas en sus hilos: no se esperan
+}
@@ -0,0 +1,192 @@
+/*
+ * PRUEBA Y BENCHMARK DE LA CALIBRACIÓN DEL ADC EN PUNTO FIJO
+ *
+ * Compara calibracion_centesimas() y calibracion_entero() con una referencia en
+ * doble precisión (las dos curvas interpoladas por separado, sin tabla) en los
+ * 4096 valores crudos, con las curvas que usan los programas del repositorio y
+ * con una curva de sensor de tres puntos con valores negativos. Revisa aparte los
+ * extremos de la tabla, los nodos, los puntos entre nodos y los crudos fuera de
+ * rango, y que la conversión por lotes dé lo mismo que la de una muestra.
+ *
+ * Informa además el error frente al polinomio de la curva típica a 11 dB (del que
+ * salen los puntos de ADC_11DB_TIPICA) y el de la conversión lineal anterior, y
+ * mide cada forma de convertir.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/calibracion_adc.cpp -o /tmp/prueba_calibracion
+ *   /tmp/prueba_calibracion
+ */
+
+#include "prueba.h"
+#include "../../comun/calibracion_adc.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Las curvas de los programas (ambas direcciones) y una de tres puntos que cruza 0
+constexpr punto_calibracion_t PUNTOS_PORCENTAJE[] = {{ADC_11DB_MIN_MV, 0}, {ADC_11DB_MAX_MV, 100}};
+constexpr punto_calibracion_t PUNTOS_SUELO[] = {{ADC_11DB_MIN_MV, 100}, {ADC_11DB_MAX_MV, 0}};
+constexpr punto_calibracion_t PUNTOS_TERMISTOR[] = {{500, 80}, {1500, 40}, {2800, -10}};
+
+constexpr calibracion_adc_t CAL_PORCENTAJE = calibracion::tabla(PUNTOS_PORCENTAJE);
+constexpr calibracion_adc_t CAL_SUELO = calibracion::tabla(PUNTOS_SUELO);
+constexpr calibracion_adc_t CAL_TERMISTOR = calibracion::tabla(PUNTOS_TERMISTOR);
+
+static_assert(calibracion_entero(&CAL_PORCENTAJE, 0) == 0 && calibracion_entero(&CAL_PORCENTAJE, 4095) == 100,
+              "la tabla se genera en tiempo de compilación");
+
+// Interpolación lineal en doble precisión, prolongando los tramos extremos
+static double interpolar(const punto_calibracion_t *p, size_t n, double x) {
+  size_t i = 1;
+  while (i + 1 < n && x > p[i].x) i++;
+  return p[i - 1].y + (p[i].y - p[i - 1].y) * (x - p[i - 1].x) / (p[i].x - p[i - 1].x);
+}
+
+static const punto_calibracion_t CURVA_ADC[] = ADC_11DB_TIPICA;
+constexpr size_t N_ADC = sizeof(CURVA_ADC) / sizeof(CURVA_ADC[0]);
+
+template <size_t N>
+static double referencia(const punto_calibracion_t (&sensor)[N], uint32_t crudo) {
+  return interpolar(sensor, N, interpolar(CURVA_ADC, N_ADC, crudo));
+}
+
+// Polinomio de la curva típica a 11 dB, crudo -> mV
+static double polinomio(double x) {
+  return (-0.000000000000016 * std::pow(x, 4) + 0.000000000118171 * std::pow(x, 3) -
+          0.000000301211691 * x * x + 0.001109019271794 * x + 0.034143524634089) *
+         1000;
+}
+
+// Toda la escala contra la referencia. 'tolerancia' en centésimas.
+template <size_t N>
+static void probarCurva(const char *nombre, const calibracion_adc_t &t, const punto_calibracion_t (&sensor)[N],
+                        double tolerancia) {
+  double peorCent = 0, peorEntero = 0;
+  uint32_t crudoPeor = 0;
+  for (uint32_t crudo = 0; crudo < 4096; crudo++) {
+    double ref = referencia(sensor, crudo);
+    double errCent = std::fabs(calibracion_centesimas(&t, crudo) - ref * 100);
+    double errEntero = std::fabs(calibracion_entero(&t, crudo) - ref);
+    if (errCent > peorCent) {
+      peorCent = errCent;
+      crudoPeor = crudo;
+    }
+    if (errEntero > peorEntero) peorEntero = errEntero;
+  }
+  COMPROBAR(peorCent <= tolerancia, "%s: %.2f centésimas de error en crudo %u", nombre, peorCent, crudoPeor);
+  // Redondeado a unidades: no más de media unidad más lo que ya se desvía la tabla
+  COMPROBAR(peorEntero <= 0.5 + tolerancia / 100, "%s: %.3f unidades de error", nombre, peorEntero);
+  std::printf("%-18s : error máximo %.2f centésimas (crudo %u), %.3f en unidades\n", nombre, peorCent, crudoPeor,
+              peorEntero);
+}
+
+static void probarPuntos() {
+  // Extremos: el primer y el último punto de la curva del sensor, exactos
+  COMPROBAR(calibracion_centesimas(&CAL_PORCENTAJE, 0) == 0, "0 -> 0,00 %%");
+  COMPROBAR(calibracion_centesimas(&CAL_PORCENTAJE, 4095) == 10000, "4095 -> %d",
+            calibracion_centesimas(&CAL_PORCENTAJE, 4095));
+  COMPROBAR(calibracion_entero(&CAL_SUELO, 0) == 100 && calibracion_entero(&CAL_SUELO, 4095) == 0, "suelo invertido");
+  COMPROBAR(calibracion_centesimas(&CAL_SUELO, 0) == 10000 && calibracion_centesimas(&CAL_SUELO, 4095) == 0,
+            "suelo: %d %d", calibracion_centesimas(&CAL_SUELO, 0), calibracion_centesimas(&CAL_SUELO, 4095));
+
+  // Fuera de rango: se queda en el extremo
+  for (uint32_t crudo : {4096u, 5000u, 65535u, 0xffffffffu}) {
+    COMPROBAR(calibracion_q(&CAL_PORCENTAJE, crudo) == calibracion_q(&CAL_PORCENTAJE, 4095), "crudo %u", crudo);
+  }
+
+  // En los nodos la tabla es exacta (salvo el redondeo a Q.8) y entre nodos es la
+  // recta entre ellos
+  for (uint32_t k = 0; k + 1 < CAL_NODOS; k++) {
+    uint32_t crudo = k << CAL_BITS_PASO;
+    double ref = referencia(PUNTOS_TERMISTOR, crudo);
+    COMPROBAR(std::fabs(calibracion_q(&CAL_TERMISTOR, crudo) - ref * CAL_UNO) <= 0.5, "nodo %u: %d, referencia %.2f",
+              k, calibracion_q(&CAL_TERMISTOR, crudo), ref * CAL_UNO);
+    int32_t medio = calibracion_q(&CAL_TERMISTOR, crudo + 32);
+    int32_t recta = (CAL_TERMISTOR.nodo[k] + CAL_TERMISTOR.nodo[k + 1]) >> 1;
+    COMPROBAR(medio == recta, "entre los nodos %u y %u: %d, se esperaba %d", k, k + 1, medio, recta);
+  }
+
+  // Los puntos de la curva del ADC caen en nodos: ahí la referencia es el punto mismo
+  for (const punto_calibracion_t &p : CURVA_ADC) {
+    if ((uint32_t)p.x % (1u << CAL_BITS_PASO) != 0) continue;  // 4095 no es nodo
+    double esperado = (p.y - ADC_11DB_MIN_MV) * 100.0 / (ADC_11DB_MAX_MV - ADC_11DB_MIN_MV);
+    COMPROBAR(std::fabs(calibracion_centesimas(&CAL_PORCENTAJE, (uint32_t)p.x) - esperado * 100) <= 1,
+              "punto %.0f: %d centésimas, se esperaba %.2f", p.x, calibracion_centesimas(&CAL_PORCENTAJE, (uint32_t)p.x),
+              esperado * 100);
+  }
+
+  // Por lotes, igual que de a una (incluidos crudos fuera de rango)
+  std::vector<uint16_t> crudos;
+  for (uint32_t c = 0; c < 4200; c++) crudos.push_back((uint16_t)c);
+  crudos.push_back(UINT16_MAX);
+  std::vector<int32_t> salida(crudos.size());
+  calibracion_convertir(&CAL_TERMISTOR, crudos.data(), crudos.size(), salida.data());
+  int distintos = 0;
+  for (size_t i = 0; i < crudos.size(); i++) distintos += salida[i] != calibracion_q(&CAL_TERMISTOR, crudos[i]);
+  COMPROBAR(distintos == 0, "%d muestras del lote difieren", distintos);
+}
+
+// La tabla contra el polinomio y la conversión lineal anterior contra el mismo
+static void probarPolinomio() {
+  double peorTabla = 0, peorLineal = 0;
+  uint32_t crudoLineal = 0;
+  for (uint32_t crudo = 0; crudo < 4096; crudo++) {
+    double ref = (polinomio(crudo) - ADC_11DB_MIN_MV) / (ADC_11DB_MAX_MV - ADC_11DB_MIN_MV) * 100;
+    peorTabla = std::fmax(peorTabla, std::fabs(calibracion_q(&CAL_PORCENTAJE, crudo) / (double)CAL_UNO - ref));
+    double lineal = std::fabs(crudo / 4095.0 * 100 - ref);
+    if (lineal > peorLineal) {
+      peorLineal = lineal;
+      crudoLineal = crudo;
+    }
+  }
+  COMPROBAR(peorTabla < 0.25, "tabla contra el polinomio: %.3f puntos", peorTabla);
+  COMPROBAR(peorLineal > 7, "la conversión lineal debía desviarse: %.2f puntos", peorLineal);
+  std::printf("Contra el polinomio: tabla %.3f puntos, (crudo / 4095.0) * 100 hasta %.2f puntos (crudo %u)\n",
+              peorTabla, peorLineal, crudoLineal);
+}
+
+static void medir() {
+  const size_t N = 1 << 16;
+  std::vector<uint16_t> crudos(N);
+  uint32_t s = 1;
+  for (uint16_t &c : crudos) {
+    s = s * 1664525u + 1013904223u;
+    c = (uint16_t)((s >> 16) & 4095);
+  }
+  std::vector<int32_t> salida(N);
+  std::vector<float> salidaFloat(N);
+
+  double ns = prueba::medirNs(50, [&] {
+    for (size_t i = 0; i < N; i++) salidaFloat[i] = (float)((crudos[i] / 4095.0) * 100.0);
+    prueba::usar(salidaFloat[0]);
+  });
+  std::printf("(crudo/4095.0)*100 : %.2f ns/muestra (doble precisión, sin corregir la curva)\n", ns / N);
+  ns = prueba::medirNs(50, [&] {
+    for (size_t i = 0; i < N; i++) salida[i] = (crudos[i] - 0) * (100 - 0) / (4095 - 0) + 0;  // map()
+    prueba::usar(salida[0]);
+  });
+  std::printf("map()              : %.2f ns/muestra (sin corregir la curva)\n", ns / N);
+  ns = prueba::medirNs(50, [&] {
+    for (size_t i = 0; i < N; i++) salida[i] = calibracion_centesimas(&CAL_PORCENTAJE, crudos[i]);
+    prueba::usar(salida[0]);
+  });
+  std::printf("Tabla, de a una    : %.2f ns/muestra\n", ns / N);
+  ns = prueba::medirNs(50, [&] {
+    calibracion_convertir(&CAL_PORCENTAJE, crudos.data(), N, salida.data());
+    prueba::usar(salida[0]);
+  });
+  std::printf("Tabla, por lotes   : %.2f ns/muestra\n", ns / N);
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarCurva("Porcentaje", CAL_PORCENTAJE, PUNTOS_PORCENTAJE, 1);
+  probarCurva("Suelo (invertida)", CAL_SUELO, PUNTOS_SUELO, 1);
+  // El quiebre en 1500 mV cae entre dos nodos: la tabla lo recorta con una cuerda
+  probarCurva("Termistor", CAL_TERMISTOR, PUNTOS_TERMISTOR, 3);
+  probarPuntos();
+  probarPolinomio();
+  medir();
+  return prueba::resultado("calibracion_adc");
+}
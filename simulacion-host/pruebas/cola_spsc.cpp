@@ -0,0 +1,205 @@
+/*
+ * PRUEBA DE ESTRÉS Y BENCHMARK DE LA COLA SPSC
+ *
+ * Un hilo productor y uno consumidor, como el callback de ESP-NOW y la tarea
+ * consumidora del receptor:
+ * - Sin pérdidas: el productor espera si la cola está llena. Todo llega, en orden
+ *   y sin tramas rotas (cada elemento lleva un patrón derivado de su número).
+ * - Con pérdidas: el productor nunca espera y el consumidor es más lento. Lo que
+ *   llega sigue en orden; recibidos + descartes() = producidos, descartes() coincide
+ *   con los rechazos que vio el productor y maximaOcupacion() llega a la capacidad.
+ * - Benchmark: elementos por segundo entre los dos hilos y costo de encolar y
+ *   desencolar en un solo hilo.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra -pthread simulacion-host/pruebas/cola_spsc.cpp -o /tmp/prueba_cola
+ *   /tmp/prueba_cola
+ * Para buscar carreras de datos, compilar además con -fsanitize=thread (más lento).
+ */
+
+#include "prueba.h"
+#include "../../comun/cola_spsc.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// Del tamaño de una trama ESP-NOW recibida: número, largo y carga útil
+struct Elemento {
+  uint32_t numero;
+  uint8_t len;
+  uint8_t datos[250];
+
+  void llenar(uint32_t n) {
+    numero = n;
+    len = (uint8_t)(n % 250 + 1);
+    for (size_t i = 0; i < len; i++) datos[i] = (uint8_t)(n * 31 + i);
+  }
+  bool integro() const {
+    if (len != (uint8_t)(numero % 250 + 1)) return false;
+    for (size_t i = 0; i < len; i++) {
+      if (datos[i] != (uint8_t)(numero * 31 + i)) return false;
+    }
+    return true;
+  }
+};
+
+constexpr size_t CAPACIDAD = 64;  // La del receptor
+using Cola = ColaSPSC<Elemento, CAPACIDAD>;
+
+static void probarUnHilo() {
+  static Cola c;
+  COMPROBAR(c.frente() == nullptr && c.tamano() == 0, "vacía");
+  for (uint32_t i = 0; i < CAPACIDAD; i++) {
+    Elemento *e = c.reservar();
+    COMPROBAR(e != nullptr, "casilla %u", i);
+    if (e) e->llenar(i);
+    c.publicar();
+  }
+  COMPROBAR(c.tamano() == CAPACIDAD && c.reservar() == nullptr && c.descartes() == 1, "llena");
+  COMPROBAR(c.maximaOcupacion() == CAPACIDAD, "máximo %u", c.maximaOcupacion());
+
+  // Vuelta completa de los índices varias veces
+  uint32_t siguiente = 0, escrito = CAPACIDAD;
+  for (int ronda = 0; ronda < 1000; ronda++) {
+    for (int k = 0; k < 37; k++) {
+      const Elemento *e = c.frente();
+      COMPROBAR(e && e->numero == siguiente && e->integro(), "ronda %d: se esperaba %u", ronda, siguiente);
+      c.retirar();
+      siguiente++;
+    }
+    for (int k = 0; k < 37; k++) {
+      Elemento e;
+      e.llenar(escrito++);
+      COMPROBAR(c.encolar(e), "ronda %d", ronda);
+    }
+  }
+  Elemento e;
+  uint32_t n = 0;
+  while (c.desencolar(e)) COMPROBAR(e.numero == siguiente + n++, "vaciado");
+  COMPROBAR(n == CAPACIDAD && c.tamano() == 0 && c.descartes() == 1, "quedaban %u", n);
+}
+
+struct Resultado {
+  uint32_t recibidos = 0, desordenados = 0, rotos = 0, rechazos = 0;
+  double segundos = 0;
+};
+
+// 'total' elementos de un hilo al otro. Con 'esperar' el productor no pierde nada;
+// sin él descarta cuando la cola está llena. 'trabajo' demora al consumidor.
+static Resultado pasar(Cola &c, uint32_t total, bool esperar, int trabajo) {
+  Resultado r;
+  std::atomic<bool> fin{false};
+  auto inicio = std::chrono::steady_clock::now();
+
+  std::thread consumidor([&] {
+    int64_t anterior = -1;
+    volatile uint32_t demora = 0;
+    while (true) {
+      const Elemento *e = c.frente();
+      if (!e) {
+        if (fin.load(std::memory_order_acquire) && c.frente() == nullptr) break;
+        std::this_thread::yield();  // Con un solo núcleo, girar sin ceder no deja avanzar al otro hilo
+        continue;
+      }
+      if ((int64_t)e->numero <= anterior) r.desordenados++;
+      if (!e->integro()) r.rotos++;
+      anterior = e->numero;
+      c.retirar();
+      r.recibidos++;
+      for (int i = 0; i < trabajo; i++) demora = demora + 1;
+    }
+  });
+
+  for (uint32_t n = 0; n < total; n++) {
+    Elemento *e;
+    while ((e = c.reservar()) == nullptr) {
+      if (!esperar) break;
+      std::this_thread::yield();
+    }
+    if (!e) {
+      r.rechazos++;
+      std::this_thread::yield();  // Descarta igual, pero deja correr al consumidor
+      continue;
+    }
+    e->llenar(n);
+    c.publicar();
+  }
+  fin.store(true, std::memory_order_release);
+  consumidor.join();
+  r.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+  return r;
+}
+
+static void probarSinPerdidas() {
+  static Cola c;
+  const uint32_t total = 2000000;
+  Resultado r = pasar(c, total, true, 0);
+  COMPROBAR(r.recibidos == total, "llegaron %u de %u", r.recibidos, total);
+  COMPROBAR(r.desordenados == 0 && r.rotos == 0, "%u fuera de orden, %u rotos", r.desordenados, r.rotos);
+  COMPROBAR(c.maximaOcupacion() >= 1 && c.maximaOcupacion() <= CAPACIDAD, "máximo %u", c.maximaOcupacion());
+  // Con espera activa cada intento fallido de reservar cuenta como descarte
+  COMPROBAR(c.descartes() >= r.rechazos, "descartes %u", c.descartes());
+  std::printf("Sin pérdidas       : %u elementos de %zu B en %.3f s (%.1f M/s), máximo %u/%zu\n", r.recibidos,
+              sizeof(Elemento), r.segundos, r.recibidos / r.segundos / 1e6, c.maximaOcupacion(), CAPACIDAD);
+}
+
+static void probarConPerdidas() {
+  static Cola c;
+  const uint32_t total = 2000000;
+  Resultado r = pasar(c, total, false, 200);
+  COMPROBAR(r.recibidos + c.descartes() == total, "recibidos %u + descartes %u != %u", r.recibidos, c.descartes(),
+            total);
+  COMPROBAR(c.descartes() == r.rechazos, "descartes %u, el productor vio %u", c.descartes(), r.rechazos);
+  COMPROBAR(r.rechazos > 0, "el consumidor lento debía llenar la cola");
+  COMPROBAR(c.maximaOcupacion() == CAPACIDAD, "con descartes el máximo es la capacidad: %u", c.maximaOcupacion());
+  COMPROBAR(r.desordenados == 0 && r.rotos == 0, "%u fuera de orden, %u rotos", r.desordenados, r.rotos);
+  std::printf("Con pérdidas       : %u recibidos, %u descartados (%.1f %%)\n", r.recibidos, c.descartes(),
+              100.0 * c.descartes() / total);
+}
+
+static void medir() {
+  // Entre hilos con elementos pequeños: mide la sincronización, no la copia
+  static ColaSPSC<uint32_t, CAPACIDAD> chica;
+  const uint32_t total = 20000000;
+  auto inicio = std::chrono::steady_clock::now();
+  std::thread consumidor([&] {
+    uint32_t v, n = 0;
+    while (n < total) {
+      if (chica.desencolar(v)) n++;
+      else std::this_thread::yield();
+    }
+  });
+  for (uint32_t n = 0; n < total;) {
+    if (chica.encolar(n)) n++;
+    else std::this_thread::yield();
+  }
+  consumidor.join();
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+  std::printf("Entre hilos        : %.1f M uint32/s (%.1f ns por elemento)\n", total / s / 1e6, s * 1e9 / total);
+
+  static Cola c;
+  Elemento e;
+  e.llenar(7);
+  double ns = prueba::medirNs(2000000, [&] {
+    Elemento *casilla = c.reservar();
+    casilla->numero = e.numero;
+    casilla->len = e.len;
+    memcpy(casilla->datos, e.datos, e.len);
+    c.publicar();
+    const Elemento *f = c.frente();
+    prueba::usar(f->numero);
+    c.retirar();
+  });
+  std::printf("Un hilo            : %.1f ns por reservar + publicar + frente + retirar (trama de %u B)\n", ns, e.len);
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarUnHilo();
+  probarSinPerdidas();
+  probarConPerdidas();
+  medir();
+  return prueba::resultado("cola_spsc");
+}
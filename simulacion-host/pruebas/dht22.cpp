@@ -0,0 +1,179 @@
+/*
+ * PRUEBA Y BENCHMARK DEL DECODIFICADOR DEL DHT22
+ *
+ * - Capturas grabadas (trazas/dht22_capturas.txt), como las entrega el RMT:
+ *   lecturas buenas (con y sin restos del arranque, temperaturas negativas,
+ *   extremos del rango), suma incorrecta, valores fuera de rango, capturas
+ *   truncadas o vacías y pulsos fuera de los tiempos del datasheet. Cada una
+ *   indica el error y los valores esperados.
+ * - Al azar: tramas con valores y tiempos dentro de tolerancia se leen exactas, y
+ *   cualquier bit invertido se detecta por la suma.
+ * - UltimaLectura: vigencia del último valor bueno y contadores por resultado.
+ * - Benchmark: costo de decodificar una captura completa.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/dht22.cpp -o /tmp/prueba_dht22
+ *   /tmp/prueba_dht22
+ */
+
+#include "prueba.h"
+#include "../../comun/dht22.h"
+
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Captura {
+  std::string descripcion;
+  dht22::Error error;
+  int humedad, temperatura;
+  std::vector<dht22::Pulso> pulsos;
+};
+
+// Cada captura va precedida por un comentario que la describe
+static std::vector<Captura> leerCapturas(const std::string &archivo) {
+  std::vector<Captura> capturas;
+  std::ifstream in(prueba::carpeta_trazas + "/" + archivo);
+  COMPROBAR(in.good(), "no se pudo abrir %s", archivo.c_str());
+  std::string linea, descripcion;
+  while (std::getline(in, linea)) {
+    if (linea.empty()) continue;
+    if (linea[0] == '#') {
+      descripcion = linea.substr(linea.find_first_not_of("# "));
+      continue;
+    }
+    std::istringstream campos(linea);
+    Captura c;
+    int error;
+    campos >> error >> c.humedad >> c.temperatura;
+    c.error = (dht22::Error)error;
+    c.descripcion = descripcion;
+    std::string pulso;
+    while (campos >> pulso) c.pulsos.push_back({pulso[0] == '+', (uint16_t)std::stoi(pulso.substr(1))});
+    capturas.push_back(c);
+  }
+  return capturas;
+}
+
+static void probarCapturas() {
+  std::vector<Captura> capturas = leerCapturas("dht22_capturas.txt");
+  COMPROBAR(capturas.size() >= 25, "%zu capturas", capturas.size());
+  size_t porError[dht22::ERRORES] = {};
+  for (const Captura &c : capturas) {
+    dht22::Lectura l{-999, 9999};
+    dht22::Error e = dht22::decodificar(c.pulsos.data(), c.pulsos.size(), l);
+    porError[(size_t)e]++;
+    COMPROBAR(e == c.error, "%s: %s, se esperaba %s", c.descripcion.c_str(), dht22::nombre(e), dht22::nombre(c.error));
+    if (c.error != dht22::Error::Ninguno) continue;
+    COMPROBAR(l.humedadDecimas == c.humedad && l.temperaturaDecimas == c.temperatura, "%s: %d y %d", c.descripcion.c_str(),
+              l.humedadDecimas, l.temperaturaDecimas);
+  }
+  // La traza cubre todos los resultados posibles
+  for (size_t e = 0; e < dht22::ERRORES; e++) {
+    COMPROBAR(porError[e] > 0, "ninguna captura da '%s'", dht22::nombre((dht22::Error)e));
+  }
+
+  // Con suma incorrecta, los bytes leídos quedan para diagnóstico
+  for (const Captura &c : capturas) {
+    if (c.error != dht22::Error::Checksum) continue;
+    dht22::Lectura l{};
+    uint8_t bytes[5] = {};
+    dht22::decodificar(c.pulsos.data(), c.pulsos.size(), l, &bytes);
+    COMPROBAR((uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]) != bytes[4], "%s: bytes de diagnóstico",
+              c.descripcion.c_str());
+  }
+}
+
+// Codificación de referencia: la trama que mandaría el sensor, con ruido en los tiempos
+static std::vector<dht22::Pulso> codificar(const uint8_t (&b)[5], uint32_t &semilla, int ruido) {
+  auto tiempo = [&](int nominal) {
+    semilla = semilla * 1103515245u + 12345u;
+    return (uint16_t)(nominal + (int)((semilla >> 16) % (2 * ruido + 1)) - ruido);
+  };
+  std::vector<dht22::Pulso> p = {{false, tiempo(80)}, {true, tiempo(80)}};
+  for (int i = 0; i < 40; i++) {
+    bool uno = b[i / 8] >> (7 - i % 8) & 1;
+    p.push_back({false, tiempo(50)});
+    p.push_back({true, tiempo(uno ? 70 : 26)});
+  }
+  p.push_back({false, tiempo(50)});
+  p.push_back({true, 0});
+  return p;
+}
+
+static void probarAlAzar() {
+  uint32_t semilla = 7;
+  int casos = 0;
+  for (int h = 0; h <= 1000; h += 7) {
+    for (int t = -400; t <= 800; t += 37) {
+      uint16_t modulo = (uint16_t)std::abs(t);
+      uint8_t b[5] = {(uint8_t)(h >> 8), (uint8_t)h, (uint8_t)(modulo >> 8 | (t < 0 ? 0x80 : 0)), (uint8_t)modulo, 0};
+      b[4] = (uint8_t)(b[0] + b[1] + b[2] + b[3]);
+      std::vector<dht22::Pulso> p = codificar(b, semilla, 8);
+      dht22::Lectura l{};
+      dht22::Error e = dht22::decodificar(p.data(), p.size(), l);
+      COMPROBAR(e == dht22::Error::Ninguno && l.humedadDecimas == h && l.temperaturaDecimas == t,
+                "%d y %d: %s, leído %d y %d", h, t, dht22::nombre(e), l.humedadDecimas, l.temperaturaDecimas);
+
+      // Un bit invertido en cualquier posición: la suma lo detecta
+      int bit = casos % 40;
+      b[bit / 8] ^= (uint8_t)(0x80 >> (bit % 8));
+      p = codificar(b, semilla, 8);
+      e = dht22::decodificar(p.data(), p.size(), l);
+      COMPROBAR(e == dht22::Error::Checksum, "%d y %d con el bit %d invertido: %s", h, t, bit, dht22::nombre(e));
+      casos++;
+    }
+  }
+  std::printf("Al azar            : %d tramas buenas y %d con un bit invertido\n", casos, casos);
+}
+
+static void probarUltimaLectura() {
+  dht22::UltimaLectura u(2500);
+  dht22::Lectura l{};
+  COMPROBAR(!u.obtener(l, 0) && std::isnan(u.temperatura(0)) && std::isnan(u.humedad(0)), "sin lecturas: NaN");
+
+  u.registrar(dht22::Error::Ninguno, {-123, 483}, 1000);
+  COMPROBAR(u.obtener(l, 1000) && l.temperaturaDecimas == -123 && l.humedadDecimas == 483, "temperatura negativa");
+  COMPROBAR(std::fabs(u.temperatura(2000) + 12.3f) < 1e-4f && std::fabs(u.humedad(2000) - 48.3f) < 1e-4f, "en float");
+
+  // Las fallidas no reemplazan el valor; vence 'vigencia' después de la última buena
+  u.registrar(dht22::Error::Checksum, {999, 999}, 2000);
+  u.registrar(dht22::Error::Tiempos, {999, 999}, 3000);
+  COMPROBAR(u.obtener(l, 3500) && l.temperaturaDecimas == -123, "sigue vigente a los 2500 ms");
+  COMPROBAR(!u.obtener(l, 3501) && std::isnan(u.humedad(3501)), "vencida");
+  u.registrar(dht22::Error::Ninguno, {235, 652}, 4000);
+  COMPROBAR(u.obtener(l, 4000) && l.temperaturaDecimas == 235, "una buena la renueva");
+  COMPROBAR(u.obtener(l, 4000u + 0xFFFFFFFFu - 100000u) == false, "muy vieja");
+
+  COMPROBAR(u.intentos() == 4 && u.resultados(dht22::Error::Ninguno) == 2 && u.resultados(dht22::Error::Checksum) == 1 &&
+                u.resultados(dht22::Error::Tiempos) == 1,
+            "contadores: %u intentos", u.intentos());
+}
+
+static void medir() {
+  std::vector<Captura> capturas = leerCapturas("dht22_capturas.txt");
+  if (capturas.empty()) return;
+  const Captura &buena = capturas[0];
+  dht22::Lectura l{};
+  double ns = prueba::medirNs(1000000, [&] {
+    prueba::usar(dht22::decodificar(buena.pulsos.data(), buena.pulsos.size(), l));
+    prueba::usar(l);
+  });
+  std::printf("Decodificar        : %.1f ns por captura de %zu pulsos\n", ns, buena.pulsos.size());
+  ns = prueba::medirNs(2000, [&] {
+    for (const Captura &c : capturas) prueba::usar(dht22::decodificar(c.pulsos.data(), c.pulsos.size(), l));
+  });
+  std::printf("Todas las capturas : %.1f ns por captura (%zu, buenas y malas)\n", ns / capturas.size(),
+              capturas.size());
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarCapturas();
+  probarAlAzar();
+  probarUltimaLectura();
+  medir();
+  return prueba::resultado("dht22");
+}
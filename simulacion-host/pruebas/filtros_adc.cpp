@@ -0,0 +1,132 @@
+/*
+ * PRUEBA DE LA CADENA DE FILTROS DEL ADC CON UNA TRAZA GRABADA
+ *
+ * Pasa trazas/suelo_20khz.txt por diezmado(64) -> mediana(5) -> EMA(k=2), la
+ * misma cadena que usa adc_continuo.h, y compara cada salida con
+ * trazas/suelo_20khz_filtrada.txt. La traza entra por tramas de 128 muestras (como
+ * las del DMA) y también partida al azar, para cubrir los bloques de diezmado que
+ * quedan entre dos llamadas. Además prueba los núcleos sueltos y mide su costo.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/filtros_adc.cpp -o /tmp/prueba_filtros
+ *   /tmp/prueba_filtros
+ */
+
+#include "prueba.h"
+#include "../../comun/filtros_adc.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+constexpr uint16_t DIEZMADO = 64;
+constexpr uint8_t K_EMA = 2;
+
+// Salida de la cadena tras cada bloque completo de diezmado, con la traza partida
+// en tramos de los tamaños que da 'tramo'
+template <typename F>
+static std::vector<uint16_t> filtrar(const std::vector<uint16_t> &traza, F &&tramo) {
+  cadena_filtro_t c;
+  cadena_filtro_iniciar(&c, DIEZMADO, K_EMA);
+  std::vector<uint16_t> salida;
+  size_t i = 0, bloques = 0;
+  while (i < traza.size()) {
+    size_t n = std::min(tramo(), traza.size() - i);
+    cadena_filtro_procesar(&c, traza.data() + i, n);
+    i += n;
+    // Solo se compara el valor que quedó justo al cerrar un bloque
+    for (; bloques < i / DIEZMADO; bloques++) {
+      if ((bloques + 1) * DIEZMADO == i) salida.push_back(cadena_filtro_valor(&c));
+      else salida.push_back(UINT16_MAX);
+    }
+  }
+  return salida;
+}
+
+static void probarNucleos() {
+  const uint16_t muestras[] = {10, 20, 30, 40, 50, 60, 70};
+  uint16_t salida[3];
+  COMPROBAR(filtro_diezmar(muestras, 7, 3, salida) == 2, "debe ignorar la muestra sobrante");
+  COMPROBAR(salida[0] == 20 && salida[1] == 50, "promedios %u %u", salida[0], salida[1]);
+
+  const uint16_t ventana[] = {900, 5, 300, 4095, 310};
+  COMPROBAR(filtro_mediana(ventana, 5) == 310, "mediana %u", filtro_mediana(ventana, 5));
+  COMPROBAR(filtro_mediana(ventana, 2) == 900, "mediana par toma el superior");
+  COMPROBAR(filtro_mediana(ventana, 0) == 0, "ventana vacía");
+  COMPROBAR(ventana[0] == 900 && ventana[3] == 4095, "no debe modificar la entrada");
+
+  // La EMA arranca en la primera muestra y converge al escalón sin quedarse corta
+  filtro_ema_t ema;
+  filtro_ema_iniciar(&ema, K_EMA);
+  COMPROBAR(filtro_ema_actualizar(&ema, 1000) == 1000, "primer valor");
+  uint16_t y = 0;
+  for (int i = 0; i < 60; i++) y = filtro_ema_actualizar(&ema, 3000);
+  COMPROBAR(y == 3000, "EMA asentada en %u", y);
+  for (int i = 0; i < 60; i++) y = filtro_ema_actualizar(&ema, 4095);
+  COMPROBAR(y == 4095, "EMA a fondo de escala en %u", y);
+}
+
+static void probarTraza() {
+  std::vector<long> crudo = prueba::leerNumeros("suelo_20khz.txt");
+  std::vector<long> esperado = prueba::leerNumeros("suelo_20khz_filtrada.txt");
+  std::vector<uint16_t> traza(crudo.begin(), crudo.end());
+  COMPROBAR(traza.size() == 100 * DIEZMADO, "%zu muestras", traza.size());
+  COMPROBAR(esperado.size() == traza.size() / DIEZMADO, "%zu salidas esperadas", esperado.size());
+
+  // Tramas del DMA: 128 muestras, cada una cierra dos bloques
+  std::vector<uint16_t> dma = filtrar(traza, [] { return (size_t)128; });
+  COMPROBAR(dma.size() == esperado.size(), "%zu salidas", dma.size());
+  for (size_t i = 0; i < std::min(dma.size(), esperado.size()); i++) {
+    if (i % 2 == 0) continue;  // El primer bloque de cada trama queda tapado por el segundo
+    COMPROBAR(dma[i] == esperado[i], "trama DMA, bloque %zu: %u, se esperaba %ld", i, dma[i], esperado[i]);
+  }
+
+  // Muestra por muestra: todas las salidas son observables
+  std::vector<uint16_t> una = filtrar(traza, [] { return (size_t)1; });
+  for (size_t i = 0; i < std::min(una.size(), esperado.size()); i++) {
+    COMPROBAR(una[i] == esperado[i], "muestra a muestra, bloque %zu: %u, se esperaba %ld", i, una[i], esperado[i]);
+  }
+
+  // Tramos al azar: el resultado no depende de cómo se parte la entrada
+  uint32_t semilla = 99;
+  std::vector<uint16_t> azar = filtrar(traza, [&semilla] {
+    semilla = semilla * 1103515245u + 12345u;
+    return (size_t)((semilla >> 16) % 200 + 1);
+  });
+  for (size_t i = 0; i < std::min(azar.size(), esperado.size()); i++) {
+    if (azar[i] == UINT16_MAX) continue;
+    COMPROBAR(azar[i] == esperado[i], "tramos al azar, bloque %zu: %u, se esperaba %ld", i, azar[i], esperado[i]);
+  }
+
+  // Lo que la traza ejercita: la ráfaga del relé (bloques 20-21) y el bloque en 0
+  // (70) no deben mover la salida más que el ruido
+  for (size_t b : {20, 21, 22, 70, 71, 72}) {
+    long ref = b < 50 ? 2100 : 1500;
+    COMPROBAR(una[b] > ref - 25 && una[b] < ref + 25, "bloque %zu perturbado: %u", b, una[b]);
+  }
+}
+
+static void medir() {
+  std::vector<long> crudo = prueba::leerNumeros("suelo_20khz.txt");
+  std::vector<uint16_t> traza(crudo.begin(), crudo.end());
+  cadena_filtro_t c;
+  cadena_filtro_iniciar(&c, DIEZMADO, K_EMA);
+  double ns = prueba::medirNs(2000, [&] {
+    for (size_t i = 0; i + 128 <= traza.size(); i += 128) cadena_filtro_procesar(&c, traza.data() + i, 128);
+    prueba::usar(c.valor);
+  });
+  std::printf("Cadena completa    : %.2f ns/muestra (%.0f Mmuestras/s)\n", ns / traza.size(),
+              traza.size() / ns * 1e3);
+  ns = prueba::medirNs(20000, [&] { prueba::usar(filtro_sumar(traza.data(), traza.size())); });
+  std::printf("Suma (diezmado)    : %.3f ns/muestra\n", ns / traza.size());
+  ns = prueba::medirNs(1000000, [&] { prueba::usar(filtro_mediana(traza.data() + 1000, FILTRO_VENTANA_MEDIANA)); });
+  std::printf("Mediana de %d       : %.1f ns\n", FILTRO_VENTANA_MEDIANA, ns);
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarNucleos();
+  probarTraza();
+  medir();
+  return prueba::resultado("filtros_adc");
+}
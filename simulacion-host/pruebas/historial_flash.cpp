@@ -0,0 +1,252 @@
+/*
+ * PRUEBA Y BENCHMARK DEL HISTORIAL EN FLASH DEL SISTEMA DE RIEGO
+ *
+ * Corre HistorialFlash.h sobre el emulador de NOR flash de la simulación de host,
+ * con la imagen respaldada en un archivo como con el evento "flash" de los guiones:
+ * - 30 días a una muestra por minuto con cambios del relé, vaciando cada 10
+ *   minutos como el programa: bytes por muestra codificados y programados,
+ *   amplificación de escritura, recorrido completo idéntico a lo agregado y
+ *   consultas de una hora (registros, bytes leídos, tiempo de flash simulado y de
+ *   CPU del host).
+ * - Reinicio: otro HistorialFlash monta la imagen releída del archivo, recupera la
+ *   marca de subida y sigue agregando.
+ * - Corte de luz: la mitad final del último tramo vuelve a 0xFF en el archivo; al
+ *   montar se pierde solo ese tramo y la escritura sigue.
+ * - 1M de muestras con vuelta del anillo: borrados parejos por sector y lo que
+ *   queda se lee exacto.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra -I simulacion-host simulacion-host/pruebas/historial_flash.cpp -o /tmp/prueba_historial
+ *   /tmp/prueba_historial
+ */
+
+#include "../hal_host.h"
+// La prueba escribe en la terminal, no en la UART simulada
+#undef printf
+#undef scanf
+
+#include "prueba.h"
+#include "../../proyecto-de-aula/HistorialFlash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+constexpr const char *ARCHIVO_FLASH = "/tmp/prueba_historial_flash.bin";
+constexpr uint32_t INICIO = 1767225600;  // 2026-01-01 00:00 UTC
+constexpr long MUESTRAS_30_DIAS = 30 * 24 * 60;
+
+struct Esperado {
+  uint32_t t;
+  TipoRegistro tipo;
+  int32_t valor;
+};
+
+static const esp_partition_t *particion() {
+  return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "spiffs");
+}
+
+// Flash nueva (borrada), respaldada en ARCHIVO_FLASH
+static void flashNueva() {
+  std::remove(ARCHIVO_FLASH);
+  hal::flash = hal::FlashEmulada{};
+  hal::flash.ruta = ARCHIVO_FLASH;
+}
+
+// Reinicio de la placa: lo que había en RAM se pierde y la imagen se relee del archivo
+static void reiniciarPlaca() {
+  hal::flash = hal::FlashEmulada{};
+  hal::flash.ruta = ARCHIVO_FLASH;
+}
+
+// Humedad que cambia de a poco, una muestra por minuto, y de vez en cuando el relé.
+// Vacía cada 10 muestras, como el programa.
+struct Generador {
+  uint32_t semilla = 1;
+  uint32_t t = INICIO;
+  int32_t humedad = 50;
+  uint32_t azar(uint32_t n) {
+    semilla = semilla * 1103515245u + 12345u;
+    return (semilla >> 8) % n;
+  }
+  void correr(HistorialFlash &h, long muestras, std::vector<Esperado> &esperado) {
+    for (long i = 0; i < muestras; i++) {
+      t += 60;
+      if (azar(500) == 0) {
+        bool encendido = i & 1;
+        t += azar(50);
+        h.agregarRele(t, encendido);
+        esperado.push_back({t, encendido ? TipoRegistro::ReleEncendido : TipoRegistro::ReleApagado, encendido});
+      }
+      humedad = std::clamp(humedad + (int32_t)azar(5) - 2, 0, 100);
+      h.agregarMuestra(t, humedad);
+      esperado.push_back({t, TipoRegistro::Muestra, humedad});
+      if (i % 10 == 9) {
+        h.marcarSubido(t);
+        h.vaciar();
+      }
+    }
+  }
+};
+
+static std::vector<Esperado> leerTodo(const HistorialFlash &h, uint32_t desde = 0) {
+  std::vector<Esperado> leidos;
+  h.consultar(desde, UINT32_MAX, [&](const RegistroHistorial &r) {
+    leidos.push_back({r.t, r.tipo, r.valor});
+    return true;
+  });
+  return leidos;
+}
+
+// 'leidos' debe ser el final de 'esperado'
+static size_t compararFinal(const char *caso, const std::vector<Esperado> &esperado,
+                            const std::vector<Esperado> &leidos) {
+  COMPROBAR(leidos.size() <= esperado.size(), "%s: %zu leídos de %zu", caso, leidos.size(), esperado.size());
+  if (leidos.size() > esperado.size()) return 0;
+  size_t desde = esperado.size() - leidos.size();
+  for (size_t i = 0; i < leidos.size(); i++) {
+    const Esperado &a = leidos[i], &b = esperado[desde + i];
+    if (a.t != b.t || a.tipo != b.tipo || a.valor != b.valor) {
+      COMPROBAR(false, "%s, registro %zu: t %u tipo %d valor %d, se esperaba t %u tipo %d valor %d", caso, i, a.t,
+                (int)a.tipo, a.valor, b.t, (int)b.tipo, b.valor);
+      break;
+    }
+  }
+  return desde;
+}
+
+static double ahoraNs() {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void probarUnMes() {
+  flashNueva();
+  auto h = std::make_unique<HistorialFlash>();
+  COMPROBAR(h->montar(particion()), "montar la partición vacía");
+  std::vector<Esperado> esperado;
+  Generador g;
+  uint64_t reloj0 = hal::reloj_us;
+  g.correr(*h, MUESTRAS_30_DIAS, esperado);
+
+  double porMuestra = (double)h->bytesCodificados() / h->muestras();
+  double programadosPorMuestra = (double)hal::flash.bytes_programados / h->muestras();
+  double amplificacion = (double)hal::flash.bytes_programados / h->bytesCodificados();
+  COMPROBAR(h->muestras() == MUESTRAS_30_DIAS, "%u muestras", h->muestras());
+  COMPROBAR(hal::flash.bytes_programados == h->bytesProgramados(), "la cuenta propia coincide con el emulador");
+  COMPROBAR(porMuestra < 2.1, "%.2f B por muestra codificados", porMuestra);
+  COMPROBAR(amplificacion < 1.35, "amplificación de escritura %.3f", amplificacion);
+  COMPROBAR(hal::flash.violaciones == 0, "%llu escrituras sobre bits programados",
+            (unsigned long long)hal::flash.violaciones);
+  std::printf("30 días            : %u muestras, %u registros; %.2f B/muestra codificados, %.2f programados\n",
+              h->muestras(), h->registros(), porMuestra, programadosPorMuestra);
+  std::printf("Escritura          : amplificación %.3f, %llu escrituras, %u sectores borrados, %.1f s de flash\n",
+              amplificacion, (unsigned long long)hal::flash.programaciones, h->borrados(),
+              (hal::reloj_us - reloj0) / 1e6);
+
+  // Sin vuelta del anillo: el recorrido completo es todo lo agregado
+  std::vector<Esperado> leidos = leerTodo(*h);
+  COMPROBAR(leidos.size() == esperado.size(), "recorrido: %zu de %zu", leidos.size(), esperado.size());
+  compararFinal("recorrido de 30 días", esperado, leidos);
+
+  uint64_t leidos0 = hal::flash.bytes_leidos, reloj1 = hal::reloj_us;
+  double host0 = ahoraNs();
+  h->consultar(0, UINT32_MAX, [](const RegistroHistorial &) { return true; });
+  std::printf("Recorrido completo : %.1f KB leídos, %.1f ms de flash, %.2f ms en el host\n",
+              (hal::flash.bytes_leidos - leidos0) / 1024.0, (hal::reloj_us - reloj1) / 1e3, (ahoraNs() - host0) / 1e6);
+
+  // Consultas de una hora en instantes al azar
+  const int CONSULTAS = 2000;
+  uint64_t registros = 0;
+  leidos0 = hal::flash.bytes_leidos;
+  reloj1 = hal::reloj_us;
+  double hostNs = 0;
+  int distintas = 0;
+  for (int q = 0; q < CONSULTAS; q++) {
+    uint32_t desde = INICIO + g.azar(g.t - INICIO);
+    host0 = ahoraNs();
+    uint32_t n = h->consultar(desde, desde + 3600, [](const RegistroHistorial &) { return true; });
+    hostNs += ahoraNs() - host0;
+    size_t cuenta = std::count_if(esperado.begin(), esperado.end(),
+                                  [&](const Esperado &e) { return e.t >= desde && e.t <= desde + 3600; });
+    distintas += n != cuenta;
+    registros += n;
+  }
+  double hostUs = hostNs / 1e3 / CONSULTAS;
+  COMPROBAR(distintas == 0, "%d consultas de una hora con otra cantidad de registros", distintas);
+  double bytesPorConsulta = (double)(hal::flash.bytes_leidos - leidos0) / CONSULTAS;
+  COMPROBAR(bytesPorConsulta < 4096, "una consulta de una hora lee %.0f B", bytesPorConsulta);
+  std::printf("Consulta de 1 h    : %.1f registros, %.0f B leídos, %.3f ms de flash, %.1f us en el host\n",
+              (double)registros / CONSULTAS, bytesPorConsulta, (hal::reloj_us - reloj1) / 1e3 / CONSULTAS, hostUs);
+
+  // Reinicio: la imagen se relee del archivo
+  uint32_t subido = h->subidoHasta();
+  int32_t humedad = g.humedad;
+  h.reset();
+  reiniciarPlaca();
+  auto h2 = std::make_unique<HistorialFlash>();
+  uint64_t reloj2 = hal::reloj_us;
+  COMPROBAR(h2->montar(particion()), "montar tras el reinicio");
+  std::printf("Montaje            : %.1f KB leídos, %.2f ms de flash\n", hal::flash.bytes_leidos / 1024.0,
+              (hal::reloj_us - reloj2) / 1e3);
+  COMPROBAR(h2->subidoHasta() == subido && !h2->hayPendientes(), "marca de subida %u, se esperaba %u",
+            h2->subidoHasta(), subido);
+  compararFinal("tras el reinicio", esperado, leerTodo(*h2));
+  h2->agregarMuestra(g.t + 60, humedad + 1);
+  h2->vaciar();
+  esperado.push_back({g.t + 60, TipoRegistro::Muestra, humedad + 1});
+  COMPROBAR(h2->hayPendientes(), "la muestra nueva queda pendiente de subir");
+  std::vector<Esperado> ultimos = leerTodo(*h2, g.t - 600);
+  COMPROBAR(ultimos.size() == 12 || ultimos.size() == 11, "%zu registros en los últimos 11 minutos", ultimos.size());
+  compararFinal("agregado tras el reinicio", esperado, ultimos);
+
+  // Corte de luz a mitad de un tramo: la mitad final no llegó a programarse
+  h2->agregarMuestra(g.t + 120, 5);
+  h2->agregarMuestra(g.t + 180, 6);
+  uint64_t antes = hal::flash.bytes_programados;
+  h2->vaciar();
+  size_t escritos = hal::flash.bytes_programados - antes;
+  h2.reset();
+  std::string &img = hal::imagenFlash();
+  size_t fin = img.find_last_not_of('\xFF');
+  for (size_t i = fin + 1 - escritos / 2; i <= fin; i++) img[i] = (char)0xFF;
+  hal::respaldarFlash(fin + 1 - escritos / 2, escritos / 2);
+  reiniciarPlaca();
+  auto h3 = std::make_unique<HistorialFlash>();
+  COMPROBAR(h3->montar(particion()), "montar con un tramo cortado");
+  compararFinal("con el tramo cortado", esperado, leerTodo(*h3));
+  h3->agregarMuestra(g.t + 240, 7);
+  h3->vaciar();
+  esperado.push_back({g.t + 240, TipoRegistro::Muestra, 7});
+  std::vector<Esperado> tras = leerTodo(*h3, g.t + 1);
+  COMPROBAR(tras.size() == 2 && tras.back().valor == 7, "tras el corte: %zu registros nuevos", tras.size());
+  compararFinal("agregado tras el corte", esperado, tras);
+  COMPROBAR(hal::flash.violaciones == 0, "escrituras sobre bits programados tras el corte");
+}
+
+static void probarVueltaDelAnillo() {
+  flashNueva();
+  auto h = std::make_unique<HistorialFlash>();
+  h->montar(particion());
+  std::vector<Esperado> esperado;
+  Generador g;
+  g.correr(*h, 1000000, esperado);
+  auto [menos, mas] = std::minmax_element(hal::flash.borrados.begin(), hal::flash.borrados.end());
+  COMPROBAR(*menos > 0 && *mas - *menos <= 1, "borrados por sector entre %u y %u", *menos, *mas);
+  COMPROBAR(hal::flash.violaciones == 0, "%llu escrituras sobre bits programados",
+            (unsigned long long)hal::flash.violaciones);
+  std::vector<Esperado> leidos = leerTodo(*h);
+  COMPROBAR(leidos.size() > esperado.size() / 3, "quedan %zu de %zu", leidos.size(), esperado.size());
+  compararFinal("con vuelta del anillo", esperado, leidos);
+  std::printf("1M de muestras     : borrados por sector %u-%u, se leen exactos los últimos %zu registros\n", *menos,
+              *mas, leidos.size());
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarUnMes();
+  probarVueltaDelAnillo();
+  std::remove(ARCHIVO_FLASH);
+  return prueba::resultado("historial_flash");
+}
@@ -0,0 +1,342 @@
+/*
+ * PRUEBA Y BENCHMARK DEL ARMADO DE LÍNEAS, LA LECTURA DE NÚMEROS Y LAS ESTADÍSTICAS
+ *
+ * - Traza grabada (trazas/uart_lineas.txt): las lecturas de la UART de ejercicio-1,
+ *   con líneas partidas entre lecturas (también "\r\n"), varias por lectura, fines
+ *   \n, \r\n y \r, líneas de más de LINEA_MAX bytes y pérdidas de datos. Cada línea
+ *   entregada y su número se comparan con trazas/uart_lineas_esperada.txt.
+ * - numero_leer: signos, ceros a la izquierda, límites de 32 bits y desbordes, y al
+ *   azar contra lo que imprimiría "%d".
+ * - Estadísticas: mínimo, máximo, media, varianza y percentiles de los números
+ *   válidos de la traza, a lo largo de toda la traza, contra un cálculo ingenuo de
+ *   dos pasadas que guarda las muestras y las ordena.
+ * - Benchmark: bytes por segundo al armar líneas y leer números, y costo de
+ *   agregar una muestra a las estadísticas.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/lineas_numeros.cpp -o /tmp/prueba_lineas
+ *   /tmp/prueba_lineas
+ */
+
+#include "prueba.h"
+#include "../../c2-01/lineas_numeros.h"
+#include "../../c2-01/estadisticas_flujo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Un renglón de la traza: una lectura de la UART o una pérdida de datos
+struct Lectura {
+  bool descarte;
+  std::vector<uint8_t> datos;
+};
+
+static std::vector<Lectura> leerTraza(const std::string &archivo) {
+  std::vector<Lectura> lecturas;
+  for (const std::string &r : prueba::leerLineas(archivo)) {
+    Lectura l{r == "descarte", {}};
+    for (size_t i = 0; !l.descarte && i + 1 < r.size(); i += 2) {
+      l.datos.push_back((uint8_t)std::stoi(r.substr(i, 2), nullptr, 16));
+    }
+    lecturas.push_back(l);
+  }
+  return lecturas;
+}
+
+static std::string aHex(const char *s, size_t n) {
+  std::string h;
+  char b[3];
+  for (size_t i = 0; i < n; i++) {
+    std::snprintf(b, sizeof(b), "%02x", (uint8_t)s[i]);
+    h += b;
+  }
+  return h;
+}
+
+// Pasa la traza por lineas_agregar y numero_leer como procesarBloque de ejercicio-1:
+// una salida 'texto_hex desbordada valor' por línea
+static std::vector<std::string> procesar(const std::vector<Lectura> &lecturas, std::vector<int32_t> *validos) {
+  std::vector<std::string> salida;
+  lineas_t lineas;
+  lineas_iniciar(&lineas);
+  for (const Lectura &l : lecturas) {
+    if (l.descarte) {
+      lineas_descartar(&lineas);
+      continue;
+    }
+    size_t i = 0;
+    linea_t linea;
+    while (i < l.datos.size()) {
+      i += lineas_agregar(&lineas, l.datos.data() + i, l.datos.size() - i, &linea);
+      if (linea.texto == NULL) continue;
+      int32_t v = 0;
+      bool ok = !linea.desbordada && numero_leer(linea.texto, linea.largo, &v);
+      salida.push_back(aHex(linea.texto, linea.largo) + " " + std::to_string(linea.desbordada) + " " +
+                       (ok ? std::to_string(v) : "x"));
+      if (ok && v >= 0 && v <= 99 && validos) validos->push_back(v);  // El rango de ejercicio-1
+    }
+  }
+  return salida;
+}
+
+static void probarTraza() {
+  std::vector<Lectura> lecturas = leerTraza("uart_lineas.txt");
+  std::vector<std::string> esperado = prueba::leerLineas("uart_lineas_esperada.txt");
+  std::vector<std::string> obtenido = procesar(lecturas, nullptr);
+  size_t n = std::min(esperado.size(), obtenido.size());
+  for (size_t i = 0; i < n; i++) {
+    if (obtenido[i] != esperado[i]) {
+      COMPROBAR(false, "línea %zu: '%s', se esperaba '%s'", i, obtenido[i].c_str(), esperado[i].c_str());
+      return;
+    }
+  }
+  COMPROBAR(obtenido.size() == esperado.size(), "%zu líneas, se esperaban %zu", obtenido.size(), esperado.size());
+
+  size_t descartes = 0, desbordadas = 0, rechazadas = 0;
+  for (const Lectura &l : lecturas) descartes += l.descarte;
+  for (const std::string &s : esperado) {
+    desbordadas += s.find(" 1 ") != std::string::npos;
+    rechazadas += s.back() == 'x';
+  }
+  COMPROBAR(descartes > 0 && desbordadas > 0 && rechazadas > 0, "cobertura de la traza");
+  std::printf("Traza              : %zu lecturas (%zu descartes), %zu líneas, %zu rechazadas, %zu desbordadas\n",
+              lecturas.size(), descartes, esperado.size(), rechazadas, desbordadas);
+}
+
+// Casos chicos con el reparto exacto de los bytes entre lecturas
+static std::vector<std::string> armar(const std::vector<std::string> &bloques) {
+  std::vector<std::string> salida;
+  lineas_t l;
+  lineas_iniciar(&l);
+  for (const std::string &b : bloques) {
+    const uint8_t *d = (const uint8_t *)b.data();
+    size_t i = 0;
+    linea_t linea;
+    while (i < b.size()) {
+      i += lineas_agregar(&l, d + i, b.size() - i, &linea);
+      if (linea.texto) salida.emplace_back(linea.texto, linea.largo);
+    }
+  }
+  return salida;
+}
+
+static void probarArmado() {
+  using V = std::vector<std::string>;
+  COMPROBAR(armar({"12", "3\r", "\n45\n"}) == V({"123", "45"}), "partida en dos lecturas y \\r\\n repartido");
+  COMPROBAR(armar({"1\n2\r\n3\r4\n\n\r\n5\n"}) == V({"1", "2", "3", "4", "5"}), "varias por lectura, vacías ignoradas");
+  COMPROBAR(armar({"7", "", "8", "9", "\r", "\n"}) == V({"789"}), "de a un byte");
+  COMPROBAR(armar({"sin fin"}).empty(), "sin fin de línea no se entrega");
+
+  // La línea entera dentro del bloque se entrega sin copiar
+  lineas_t l;
+  lineas_iniciar(&l);
+  const char bloque[] = "42\r\n";
+  linea_t linea;
+  lineas_agregar(&l, (const uint8_t *)bloque, 4, &linea);
+  COMPROBAR(linea.texto == bloque && linea.largo == 2, "sin copia");
+
+  // Desbordada: se entrega el comienzo y la marca, también si venía partida
+  std::string larga(LINEA_MAX + 5, '9');
+  lineas_iniciar(&l);
+  lineas_agregar(&l, (const uint8_t *)larga.data(), 20, &linea);
+  std::string resto = larga.substr(20) + "\n";
+  lineas_agregar(&l, (const uint8_t *)resto.data(), resto.size(), &linea);
+  COMPROBAR(linea.texto && linea.largo == LINEA_MAX && linea.desbordada, "desbordada entre lecturas");
+  lineas_agregar(&l, (const uint8_t *)"1\n", 2, &linea);
+  COMPROBAR(linea.texto && linea.largo == 1 && !linea.desbordada, "la marca no pasa a la siguiente");
+
+  // Un descarte tira la línea abierta y lo que llegue hasta el próximo fin de línea
+  lineas_iniciar(&l);
+  lineas_agregar(&l, (const uint8_t *)"12", 2, &linea);
+  lineas_descartar(&l);
+  const char tras[] = "34\n56\n";
+  size_t usados = lineas_agregar(&l, (const uint8_t *)tras, 6, &linea);
+  COMPROBAR(linea.texto && std::string(linea.texto, linea.largo) == "56" && usados == 6, "descarte");
+}
+
+static bool leer(const char *s, int32_t &v) { return numero_leer(s, std::strlen(s), &v); }
+
+static void probarNumeros() {
+  int32_t v = 0;
+  COMPROBAR(leer("0", v) && v == 0, "0");
+  COMPROBAR(leer("-1", v) && v == -1, "-1");
+  COMPROBAR(leer("99", v) && v == 99, "99");
+  COMPROBAR(leer("2147483647", v) && v == INT32_MAX, "INT32_MAX");
+  COMPROBAR(leer("-2147483648", v) && v == INT32_MIN, "INT32_MIN");
+  for (const char *malo : {"", "-", "+1", "-0", "00", "07", "-07", " 1", "1 ", "1-", "--1", "2147483648",
+                           "-2147483649", "4294967296", "4294967295", "99999999999", "10000000000", "1e3", "0x1"}) {
+    COMPROBAR(!leer(malo, v), "'%s' debía rechazarse", malo);
+  }
+
+  // Al azar: se acepta exactamente lo que "%d" imprimiría, con el mismo valor
+  uint32_t semilla = 5;
+  auto azar = [&semilla] {
+    semilla ^= semilla << 13;
+    semilla ^= semilla >> 17;
+    semilla ^= semilla << 5;
+    return semilla;
+  };
+  const char alfabeto[] = "0123456789-";
+  int aceptados = 0;
+  for (int caso = 0; caso < 300000; caso++) {
+    char s[16];
+    if (caso % 2) {
+      // Valores cerca de los límites y de todos los largos
+      int64_t x = (int64_t)(int32_t)azar() >> (azar() % 32);
+      if (caso % 10 == 1) x += (azar() % 2 ? 1 : -1) * (int64_t)INT32_MAX;
+      std::snprintf(s, sizeof(s), "%lld", (long long)x);
+    } else {
+      size_t n = azar() % 13;
+      for (size_t i = 0; i < n; i++) s[i] = alfabeto[azar() % 11];
+      s[n] = 0;
+    }
+    char *fin;
+    long long ref = std::strtoll(s, &fin, 10);
+    char canonica[24];
+    std::snprintf(canonica, sizeof(canonica), "%lld", ref);
+    bool esperado = s[0] && *fin == 0 && std::strcmp(canonica, s) == 0 && ref >= INT32_MIN && ref <= INT32_MAX;
+    bool ok = leer(s, v);
+    if (ok != esperado || (ok && v != ref)) {
+      COMPROBAR(false, "'%s': %d (valor %d), se esperaba %d", s, ok, v, esperado);
+      return;
+    }
+    aceptados += ok;
+  }
+  std::printf("Números al azar    : 300000 cadenas, %d aceptadas\n", aceptados);
+}
+
+// Referencia: guarda todas las muestras, media y varianza en dos pasadas, percentil
+// por rango más cercano sobre las muestras ordenadas
+struct Ingenuo {
+  std::vector<int32_t> muestras;
+
+  double media() const {
+    double s = 0;
+    for (int32_t x : muestras) s += x;
+    return s / muestras.size();
+  }
+  double varianza() const {
+    double m = media(), s = 0;
+    for (int32_t x : muestras) s += (x - m) * (x - m);
+    return s / muestras.size();
+  }
+  int32_t percentil(uint32_t p) const {
+    std::vector<int32_t> o = muestras;
+    std::sort(o.begin(), o.end());
+    size_t rango = (size_t)std::ceil(p / 100.0 * o.size());
+    return o[rango ? rango - 1 : 0];
+  }
+};
+
+static bool compararEstadisticas(const estadisticas_t &e, const Ingenuo &ref, const char *donde) {
+  const std::vector<int32_t> &m = ref.muestras;
+  bool ok = e.cantidad == m.size() && e.minimo == *std::min_element(m.begin(), m.end()) &&
+            e.maximo == *std::max_element(m.begin(), m.end()) && e.ultimo == m.back();
+  COMPROBAR(ok, "%s: cantidad, mínimo, máximo o último", donde);
+  double media = ref.media(), varianza = ref.varianza();
+  COMPROBAR(std::fabs(estadisticas_media(&e) - media) <= 1e-9 * std::fmax(1, media), "%s: media %.12f / %.12f", donde,
+            estadisticas_media(&e), media);
+  COMPROBAR(std::fabs(estadisticas_varianza(&e) - varianza) <= 1e-9 * std::fmax(1, varianza),
+            "%s: varianza %.12f / %.12f", donde, estadisticas_varianza(&e), varianza);
+  bool percentiles = true;
+  for (uint32_t p : {0u, 1u, 10u, 25u, 50u, 75u, 90u, 99u, 100u}) {
+    if (estadisticas_percentil(&e, p) != ref.percentil(p)) {
+      COMPROBAR(false, "%s: P%u %d, se esperaba %d", donde, p, estadisticas_percentil(&e, p), ref.percentil(p));
+      percentiles = false;
+    }
+  }
+  return ok && percentiles;
+}
+
+static void probarEstadisticas() {
+  estadisticas_t e;
+  estadisticas_iniciar(&e);
+  COMPROBAR(e.cantidad == 0 && estadisticas_percentil(&e, 50) == -1 && estadisticas_media(&e) == 0 &&
+                estadisticas_varianza(&e) == 0,
+            "sin muestras");
+
+  // Los números válidos de la traza, revisados a medida que llegan
+  std::vector<int32_t> validos;
+  procesar(leerTraza("uart_lineas.txt"), &validos);
+  COMPROBAR(validos.size() > 1000, "%zu números válidos en la traza", validos.size());
+  Ingenuo ref;
+  for (size_t i = 0; i < validos.size(); i++) {
+    estadisticas_agregar(&e, validos[i]);
+    ref.muestras.push_back(validos[i]);
+    if ((i < 20 || i % 97 == 0 || i + 1 == validos.size()) && !compararEstadisticas(e, ref, "traza")) return;
+  }
+  std::printf("Estadísticas       : %zu números de la traza, media %.3f, desviación %.3f, P50 %d, P99 %d\n",
+              validos.size(), estadisticas_media(&e), std::sqrt(estadisticas_varianza(&e)),
+              estadisticas_percentil(&e, 50), estadisticas_percentil(&e, 99));
+
+  // Un solo valor repetido: varianza 0 y todos los percentiles iguales
+  estadisticas_iniciar(&e);
+  ref.muestras.clear();
+  for (int i = 0; i < 1000; i++) {
+    estadisticas_agregar(&e, 37);
+    ref.muestras.push_back(37);
+  }
+  compararEstadisticas(e, ref, "constante");
+
+  // Flujo largo y sesgado a los extremos: la varianza en un paso sigue a la de dos pasadas
+  estadisticas_iniciar(&e);
+  ref.muestras.clear();
+  uint32_t s = 77;
+  for (int i = 0; i < 2000000; i++) {
+    s = s * 1664525u + 1013904223u;
+    int32_t x = (s >> 8) % 4 == 0 ? (int32_t)((s >> 12) % 100) : 98 + (int32_t)((s >> 12) % 2);
+    estadisticas_agregar(&e, x);
+    ref.muestras.push_back(x);
+  }
+  compararEstadisticas(e, ref, "2e6 muestras");
+}
+
+static void medir() {
+  std::vector<Lectura> lecturas = leerTraza("uart_lineas.txt");
+  size_t bytes = 0;
+  for (const Lectura &l : lecturas) bytes += l.datos.size();
+  double ns = prueba::medirNs(200, [&] {
+    lineas_t lineas;
+    lineas_iniciar(&lineas);
+    int32_t suma = 0;
+    for (const Lectura &l : lecturas) {
+      size_t i = 0;
+      linea_t linea;
+      while (i < l.datos.size()) {
+        i += lineas_agregar(&lineas, l.datos.data() + i, l.datos.size() - i, &linea);
+        int32_t v;
+        if (linea.texto && numero_leer(linea.texto, linea.largo, &v)) suma += v;
+      }
+    }
+    prueba::usar(suma);
+  });
+  std::printf("Líneas y números   : %.2f ns/byte (%.0f MB/s)\n", ns / bytes, bytes / ns * 1e3);
+
+  std::vector<int32_t> valores(1 << 16);
+  uint32_t s = 1;
+  for (int32_t &v : valores) {
+    s = s * 1664525u + 1013904223u;
+    v = (int32_t)((s >> 16) % 100);
+  }
+  estadisticas_t e;
+  estadisticas_iniciar(&e);
+  ns = prueba::medirNs(100, [&] {
+    for (int32_t v : valores) estadisticas_agregar(&e, v);
+    prueba::usar(e);
+  });
+  std::printf("Agregar muestra    : %.2f ns\n", ns / valores.size());
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarTraza();
+  probarArmado();
+  probarNumeros();
+  probarEstadisticas();
+  medir();
+  return prueba::resultado("lineas_numeros");
+}
@@ -0,0 +1,97 @@
+/*
+ * APOYO PARA LAS PRUEBAS Y BENCHMARKS DE LOS NÚCLEOS EN LINUX
+ *
+ * Cada archivo de esta carpeta es un programa independiente que prueba un módulo
+ * de comun/ (o del proyecto que lo usa) y mide su costo en el host. Termina con
+ * código 0 si todas las comprobaciones pasan y 1 si alguna falla; los números del
+ * benchmark son informativos y no hacen fallar la prueba.
+ *
+ * Las trazas grabadas y las salidas esperadas están en pruebas/trazas/. Por
+ * defecto se buscan relativas a la raíz del repositorio; el primer argumento del
+ * programa puede indicar otra carpeta.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace prueba {
+
+inline int comprobaciones = 0;
+inline int fallas = 0;
+inline std::string carpeta_trazas = "simulacion-host/pruebas/trazas";
+
+// Registra una comprobación; si falla, imprime dónde y el detalle
+#define COMPROBAR(cond, ...)                                  \
+  do {                                                        \
+    prueba::comprobaciones++;                                 \
+    if (!(cond)) {                                            \
+      prueba::fallas++;                                       \
+      std::printf("FALLA %s:%d: %s: ", __FILE__, __LINE__, #cond); \
+      std::printf(__VA_ARGS__);                               \
+      std::printf("\n");                                      \
+    }                                                         \
+  } while (0)
+
+inline void iniciar(int argc, char **argv) {
+  if (argc > 1) carpeta_trazas = argv[1];
+}
+
+// Números de una traza: separados por espacios o saltos de línea, '#' inicia un comentario
+inline std::vector<long> leerNumeros(const std::string &archivo) {
+  std::ifstream in(carpeta_trazas + "/" + archivo);
+  COMPROBAR(in.good(), "no se pudo abrir %s/%s", carpeta_trazas.c_str(), archivo.c_str());
+  std::vector<long> numeros;
+  std::string linea;
+  while (std::getline(in, linea)) {
+    std::istringstream campos(linea.substr(0, linea.find('#')));
+    long v;
+    while (campos >> v) numeros.push_back(v);
+  }
+  return numeros;
+}
+
+// Líneas no vacías de una traza, sin comentarios
+inline std::vector<std::string> leerLineas(const std::string &archivo) {
+  std::ifstream in(carpeta_trazas + "/" + archivo);
+  COMPROBAR(in.good(), "no se pudo abrir %s/%s", carpeta_trazas.c_str(), archivo.c_str());
+  std::vector<std::string> lineas;
+  std::string linea;
+  while (std::getline(in, linea)) {
+    linea = linea.substr(0, linea.find('#'));
+    while (!linea.empty() && (linea.back() == ' ' || linea.back() == '\r')) linea.pop_back();
+    if (!linea.empty()) lineas.push_back(linea);
+  }
+  return lineas;
+}
+
+// Evita que el compilador descarte un resultado que solo se calcula para medir
+template <typename T>
+inline void usar(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+// Nanosegundos por repetición de 'f' (mejor de 5 corridas de 'repeticiones')
+template <typename F>
+inline double medirNs(long repeticiones, F &&f) {
+  double mejor = 1e300;
+  for (int corrida = 0; corrida < 5; corrida++) {
+    auto inicio = std::chrono::steady_clock::now();
+    for (long i = 0; i < repeticiones; i++) f();
+    std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - inicio;
+    if (d.count() / repeticiones < mejor) mejor = d.count() / repeticiones;
+  }
+  return mejor;
+}
+
+inline int resultado(const char *nombre) {
+  std::printf("%s: %d comprobaciones, %d fallas\n", nombre, comprobaciones, fallas);
+  return fallas ? 1 : 0;
+}
+
+}  // namespace prueba
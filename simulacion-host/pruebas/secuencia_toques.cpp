@@ -0,0 +1,221 @@
+/*
+ * PRUEBA Y BENCHMARK DEL RECONOCEDOR DE SECUENCIAS DE TOQUES
+ *
+ * - Trazas grabadas: los dos guiones de ejercicio-3 y una sesión larga (400
+ *   intentos con errores, rebotes, liberaciones sin presión y la vuelta del reloj
+ *   de 32 bits) pasan por el autómata con el patrón del ejercicio y cada
+ *   liberación y validación se compara con trazas/toques_*_esperada.txt.
+ * - Fuzz: patrones y eventos al azar contra un reconocedor ingenuo escrito
+ *   directamente a partir de la semántica de secuencia_toques.h (lista de toques
+ *   esperados y un índice), sin tabla.
+ * - Benchmark: eventos por segundo al reproducir la sesión, con la tabla y con el
+ *   reconocedor ingenuo.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/secuencia_toques.cpp -o /tmp/prueba_toques
+ *   /tmp/prueba_toques
+ */
+
+#include "prueba.h"
+#include "../../c2-01/secuencia_toques.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint32_t CORTO_MS = 1000;  // Los de ejercicio-3.c
+constexpr uint32_t LARGO_MS = 3000;
+constexpr uint8_t VALIDAR = 2;       // Evento de las trazas: toque en el pad de validación
+
+static const grupo_toques_t PATRON_EJERCICIO[] = {
+    {3, TOQUE_LARGO},
+    {3, TOQUE_CORTO},
+    {3, TOQUE_LARGO},
+};
+
+// Reconocedor de referencia: la semántica del encabezado, paso a paso
+struct Ingenuo {
+  std::vector<uint8_t> esperados;  // Un tipo por toque del patrón
+  uint32_t corto_ms, largo_ms;
+  size_t estado = 0;
+  bool presionado = false;
+  uint32_t inicio_ms = 0;
+
+  // false si secuencia_compilar debe rechazar el patrón
+  bool compilar(const std::vector<grupo_toques_t> &patron, uint32_t corto, uint32_t largo) {
+    esperados.clear();
+    corto_ms = corto;
+    largo_ms = largo;
+    for (const grupo_toques_t &g : patron) {
+      if (g.tipo != TOQUE_CORTO && g.tipo != TOQUE_LARGO) return false;
+      for (int k = 0; k < g.cantidad; k++) esperados.push_back(g.tipo);
+    }
+    return esperados.size() < SECUENCIA_MAX_ESTADOS;
+  }
+
+  resultado_toque_t evento(evento_toque_t ev) {
+    resultado_toque_t res = {TOQUE_INVALIDO, false};
+    if (ev.tipo == TOQUE_PRESION) {
+      inicio_ms = ev.t_ms;
+      presionado = true;
+      return res;
+    }
+    uint32_t duracion = presionado ? ev.t_ms - inicio_ms : 0;
+    presionado = false;
+    if (duracion < corto_ms) res.tipo = TOQUE_INVALIDO;
+    else if (duracion < largo_ms) res.tipo = TOQUE_CORTO;
+    else res.tipo = TOQUE_LARGO;
+    if (estado == esperados.size() || res.tipo == TOQUE_INVALIDO) return res;  // Completo o inválido: nada
+    if (res.tipo == esperados[estado]) {
+      estado++;
+    } else {
+      estado = 0;
+      res.reinicio = true;
+    }
+    return res;
+  }
+};
+
+static std::vector<evento_toque_t> leerEventos(const std::string &archivo) {
+  std::vector<long> n = prueba::leerNumeros(archivo);
+  COMPROBAR(n.size() % 2 == 0, "%s: número impar de campos", archivo.c_str());
+  std::vector<evento_toque_t> eventos;
+  for (size_t i = 0; i + 1 < n.size(); i += 2) eventos.push_back({(uint32_t)n[i], (uint8_t)n[i + 1]});
+  return eventos;
+}
+
+static void probarTraza(const std::string &nombre, const tabla_secuencia_t &tabla, bool aprobadaFinal) {
+  std::vector<evento_toque_t> eventos = leerEventos(nombre + ".txt");
+  std::vector<std::string> esperado = prueba::leerLineas(nombre + "_esperada.txt");
+  reconocedor_toques_t r;
+  secuencia_iniciar(&r, &tabla);
+  size_t linea = 0;
+  bool aprobada = false;
+  for (size_t i = 0; i < eventos.size(); i++) {
+    char obtenido[32];
+    if (eventos[i].tipo == VALIDAR) {
+      aprobada = secuencia_completa(&r);
+      std::snprintf(obtenido, sizeof(obtenido), "V %d", aprobada);
+      secuencia_reiniciar(&r);
+    } else {
+      resultado_toque_t res = secuencia_evento(&r, eventos[i]);
+      if (eventos[i].tipo == TOQUE_PRESION) continue;
+      std::snprintf(obtenido, sizeof(obtenido), "L %u %d %u", res.tipo, res.reinicio, r.estado);
+    }
+    if (linea >= esperado.size()) {
+      COMPROBAR(false, "%s: sobran salidas desde el evento %zu", nombre.c_str(), i);
+      return;
+    }
+    COMPROBAR(esperado[linea] == obtenido, "%s, evento %zu (t=%u): '%s', se esperaba '%s'", nombre.c_str(), i,
+              eventos[i].t_ms, obtenido, esperado[linea].c_str());
+    linea++;
+  }
+  COMPROBAR(linea == esperado.size(), "%s: %zu salidas, se esperaban %zu", nombre.c_str(), linea, esperado.size());
+  COMPROBAR(aprobada == aprobadaFinal, "%s: la última validación debía dar %d", nombre.c_str(), aprobadaFinal);
+}
+
+static void probarTrazas() {
+  tabla_secuencia_t tabla;
+  COMPROBAR(secuencia_compilar(&tabla, PATRON_EJERCICIO, 3, CORTO_MS, LARGO_MS), "patrón del ejercicio");
+  COMPROBAR(tabla.final == 9, "estado final %u", tabla.final);
+  probarTraza("toques_correcta", tabla, true);
+  probarTraza("toques_errores", tabla, false);
+  probarTraza("toques_sesion", tabla, false);
+}
+
+static void probarFuzz() {
+  uint32_t semilla = 12345;
+  auto azar = [&semilla](uint32_t n) {
+    semilla ^= semilla << 13;
+    semilla ^= semilla >> 17;
+    semilla ^= semilla << 5;
+    return semilla % n;
+  };
+  int patrones = 0, rechazados = 0;
+  long eventos = 0;
+  for (int caso = 0; caso < 20000; caso++) {
+    std::vector<grupo_toques_t> patron(azar(6));
+    for (grupo_toques_t &g : patron) {
+      g.cantidad = (uint8_t)azar(caso % 50 == 0 ? 40 : 5);       // A veces no cabe en la tabla
+      g.tipo = (uint8_t)(azar(100) == 0 ? azar(4) : 1 + azar(2));  // A veces un tipo inválido
+    }
+    uint32_t corto = 1 + azar(1500), largo = corto + azar(3000);  // Incluye largo == corto
+    tabla_secuencia_t tabla;
+    Ingenuo ref;
+    bool compila = secuencia_compilar(&tabla, patron.data(), patron.size(), corto, largo);
+    COMPROBAR(compila == ref.compilar(patron, corto, largo), "caso %d: compilar %d", caso, compila);
+    if (!compila) {
+      rechazados++;
+      continue;
+    }
+    patrones++;
+    COMPROBAR(tabla.final == ref.esperados.size(), "caso %d: final %u", caso, tabla.final);
+
+    reconocedor_toques_t r;
+    secuencia_iniciar(&r, &tabla);
+    uint32_t t = azar(2) ? azar(1000) : 0u - azar(100000);  // Cerca de la vuelta del reloj
+    bool presionado = false;
+    for (int i = 0; i < 300; i++, eventos++) {
+      if (azar(200) == 0) {
+        COMPROBAR(secuencia_completa(&r) == (ref.estado == ref.esperados.size()), "caso %d: completa", caso);
+        secuencia_reiniciar(&r);
+        ref.estado = 0;
+        continue;
+      }
+      // Casi siempre alternan; a veces una presión o una liberación sueltas
+      uint8_t tipo = azar(20) == 0 ? (uint8_t)azar(2) : (uint8_t)(presionado ? TOQUE_LIBERACION : TOQUE_PRESION);
+      presionado = tipo == TOQUE_PRESION;
+      uint32_t paso = azar(3) == 0 ? azar(2 * largo + 2) : (azar(2) ? largo + azar(3) - 1 : corto + azar(3) - 1);
+      t += paso;  // Los umbrales exactos y sus vecinos aparecen seguido
+      evento_toque_t ev = {t, tipo};
+      resultado_toque_t a = secuencia_evento(&r, ev);
+      resultado_toque_t b = ref.evento(ev);
+      if (a.tipo != b.tipo || a.reinicio != b.reinicio || r.estado != ref.estado) {
+        COMPROBAR(false, "caso %d, evento %d: tipo %u/%u reinicio %d/%d estado %u/%zu", caso, i, a.tipo, b.tipo,
+                  a.reinicio, b.reinicio, r.estado, ref.estado);
+        break;
+      }
+    }
+  }
+  COMPROBAR(rechazados > 0 && patrones > rechazados, "cobertura: %d patrones, %d rechazados", patrones, rechazados);
+  std::printf("Fuzz               : %d patrones (%d rechazados), %ld eventos\n", patrones, rechazados, eventos);
+}
+
+static void medir() {
+  std::vector<evento_toque_t> eventos;
+  for (const evento_toque_t &e : leerEventos("toques_sesion.txt")) {
+    if (e.tipo != VALIDAR) eventos.push_back(e);
+  }
+  if (eventos.empty()) return;
+  tabla_secuencia_t tabla;
+  secuencia_compilar(&tabla, PATRON_EJERCICIO, 3, CORTO_MS, LARGO_MS);
+  reconocedor_toques_t r;
+  secuencia_iniciar(&r, &tabla);
+  double ns = prueba::medirNs(2000, [&] {
+    uint32_t suma = 0;
+    for (const evento_toque_t &e : eventos) suma += secuencia_evento(&r, e).tipo;
+    prueba::usar(suma);
+    secuencia_reiniciar(&r);
+  });
+  std::printf("Tabla              : %.2f ns/evento (%.0f M eventos/s)\n", ns / eventos.size(),
+              eventos.size() / ns * 1e3);
+
+  Ingenuo ref;
+  ref.compilar({PATRON_EJERCICIO, PATRON_EJERCICIO + 3}, CORTO_MS, LARGO_MS);
+  ns = prueba::medirNs(2000, [&] {
+    uint32_t suma = 0;
+    for (const evento_toque_t &e : eventos) suma += ref.evento(e).tipo;
+    prueba::usar(suma);
+    ref.estado = 0;
+  });
+  std::printf("Ingenuo            : %.2f ns/evento (%.0f M eventos/s)\n", ns / eventos.size(),
+              eventos.size() / ns * 1e3);
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarTrazas();
+  probarFuzz();
+  medir();
+  return prueba::resultado("secuencia_toques");
+}
@@ -0,0 +1,209 @@
+/*
+ * PRUEBA Y BENCHMARK DE LA TABLA DE PARES DEL RECEPTOR
+ *
+ * - Altas, búsquedas, tabla llena y MAC de cada casilla.
+ * - Borrado con cadenas de sondeo que dan la vuelta al final del arreglo: los
+ *   pares que se corren conservan sus estadísticas y todos se siguen encontrando.
+ * - Al azar: altas, bajas y búsquedas contra un std::map, con la tabla casi llena.
+ * - Vencimiento recorriendo la tabla y borrando, como lo hace el receptor: se
+ *   borran exactamente los vencidos aunque otros pares se corran a la casilla.
+ * - Benchmark: búsquedas encontradas y fallidas, y alta más baja.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/tabla_pares.cpp -o /tmp/prueba_pares
+ *   /tmp/prueba_pares
+ */
+
+#include "prueba.h"
+#include "../../Práctica ESPNOW + ADC + PWM/tabla_pares.h"
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+static uint32_t semilla = 99;
+static uint32_t azar() {
+  semilla = semilla * 1103515245u + 12345u;
+  return semilla >> 8;
+}
+
+struct Mac {
+  uint8_t b[6];
+};
+
+// MAC de un emisor del montaje: prefijo de Espressif y un número de serie
+static Mac macNumero(uint32_t n) { return {{0x5c, 0x01, 0x3b, (uint8_t)(n >> 16), (uint8_t)(n >> 8), (uint8_t)n}}; }
+
+// Valor que cada par guarda para comprobar que sus datos viajan con la clave
+static uint16_t marca(const Mac &m) { return (uint16_t)(pares::clave(m.b) * 0x9E37u >> 3); }
+
+static size_t alta(pares::Tabla &t, const Mac &m) {
+  bool nuevo;
+  size_t i = t.registrar(m.b, nuevo);
+  if (i != pares::NINGUNO && nuevo) t[i].ultimoValor = marca(m);
+  return i;
+}
+
+static void probarAltas() {
+  pares::Tabla t;
+  bool nuevo;
+  Mac a = macNumero(1);
+  size_t i = t.registrar(a.b, nuevo);
+  COMPROBAR(i != pares::NINGUNO && nuevo && t.cantidad() == 1, "primera alta");
+  COMPROBAR(t[i].salida == trama::SIN_SALIDA && t[i].secuencia.recibidas() == 0, "par nuevo sin salida");
+  COMPROBAR(t.registrar(a.b, nuevo) == i && !nuevo && t.cantidad() == 1, "segunda vez: el mismo par");
+  COMPROBAR(t.buscar(a.b) == i && t.buscar(macNumero(2).b) == pares::NINGUNO, "búsquedas");
+  uint8_t mac[6];
+  t.mac(i, mac);
+  COMPROBAR(pares::clave(mac) == pares::clave(a.b), "MAC de la casilla");
+
+  for (uint32_t n = 2; t.cantidad() < pares::MAXIMO; n++) alta(t, macNumero(n));
+  COMPROBAR(t.registrar(macNumero(1000).b, nuevo) == pares::NINGUNO, "tabla llena");
+  COMPROBAR(t.registrar(a.b, nuevo) == i && !nuevo, "llena, un par conocido se sigue encontrando");
+  t.borrar(t.buscar(macNumero(7).b));
+  COMPROBAR(t.cantidad() == pares::MAXIMO - 1 && alta(t, macNumero(1000)) != pares::NINGUNO, "una baja libera lugar");
+}
+
+// Todos los pares de 'vivos' se encuentran con sus datos y no hay otros
+static bool coincide(const pares::Tabla &t, const std::map<uint64_t, Mac> &vivos) {
+  if (t.cantidad() != vivos.size()) return false;
+  for (const auto &[clave, m] : vivos) {
+    size_t i = t.buscar(m.b);
+    if (i == pares::NINGUNO || t[i].ultimoValor != marca(m)) return false;
+  }
+  size_t ocupadas = 0;
+  for (size_t i = 0; i < pares::CAPACIDAD; i++) ocupadas += t.ocupada(i);
+  return ocupadas == vivos.size();
+}
+
+static void probarBorradoConVuelta() {
+  // Pares cuyo sondeo empieza en las últimas casillas: sus cadenas siguen en la 0, 1...
+  pares::Tabla t;
+  std::map<uint64_t, Mac> vivos;
+  for (uint32_t n = 0; vivos.size() < 12 && n < 100000; n++) {
+    Mac m = macNumero(n);
+    pares::Tabla prueba;
+    if (alta(prueba, m) < pares::CAPACIDAD - 3) continue;
+    alta(t, m);
+    vivos[pares::clave(m.b)] = m;
+  }
+  COMPROBAR(vivos.size() == 12, "%zu pares al final del arreglo", vivos.size());
+  COMPROBAR(t.ocupada(0) && t.ocupada(pares::CAPACIDAD - 1), "la cadena da la vuelta");
+  COMPROBAR(coincide(t, vivos), "antes de borrar");
+
+  // Borra desde el comienzo de la cadena, del medio y del final
+  while (!vivos.empty()) {
+    auto it = vivos.begin();
+    std::advance(it, azar() % vivos.size());
+    size_t i = t.buscar(it->second.b);
+    if (i == pares::NINGUNO) {
+      COMPROBAR(false, "quedan %zu pares: se perdió uno", vivos.size());
+      return;
+    }
+    t.borrar(i);
+    vivos.erase(it);
+    COMPROBAR(coincide(t, vivos), "quedan %zu pares", vivos.size());
+  }
+}
+
+static void probarAlAzar() {
+  pares::Tabla t;
+  std::map<uint64_t, Mac> vivos;
+  long altas = 0, bajas = 0, busquedas = 0;
+  for (int op = 0; op < 200000; op++) {
+    Mac m = macNumero(azar() % 80);  // Más MAC que lugares: la tabla pasa la mayor parte del tiempo llena
+    uint64_t k = pares::clave(m.b);
+    uint32_t accion = azar() % 3;
+    if (accion == 0) {
+      size_t i = alta(t, m);
+      bool lleno = vivos.size() == pares::MAXIMO && !vivos.count(k);
+      COMPROBAR((i == pares::NINGUNO) == lleno, "op %d: alta con %zu pares", op, vivos.size());
+      if (!lleno) vivos[k] = m;
+      altas++;
+    } else if (accion == 1 && vivos.count(k)) {
+      size_t i = t.buscar(m.b);
+      if (i == pares::NINGUNO) {
+        COMPROBAR(false, "op %d: se perdió un par", op);
+        return;
+      }
+      t.borrar(i);
+      vivos.erase(k);
+      bajas++;
+    } else {
+      size_t i = t.buscar(m.b);
+      COMPROBAR((i != pares::NINGUNO) == (vivos.count(k) > 0), "op %d: búsqueda", op);
+      busquedas++;
+    }
+    if (op % 1000 == 0 && !coincide(t, vivos)) {
+      COMPROBAR(false, "op %d: la tabla no coincide con la referencia", op);
+      return;
+    }
+  }
+  COMPROBAR(coincide(t, vivos), "al final");
+  std::printf("Al azar            : %ld altas, %ld bajas y %ld búsquedas\n", altas, bajas, busquedas);
+}
+
+// El recorrido del receptor: borrar y volver a examinar la misma casilla
+static void probarVencimiento() {
+  for (int ronda = 0; ronda < 2000; ronda++) {
+    pares::Tabla t;
+    std::map<uint64_t, Mac> vivos;
+    for (size_t n = 0; n < pares::MAXIMO; n++) {
+      Mac m = macNumero(azar() % 100000);
+      if (alta(t, m) != pares::NINGUNO) vivos[pares::clave(m.b)] = m;
+    }
+    // Vence un par de cada tres, elegido por su MAC
+    auto vence = [](uint64_t clave) { return clave % 3 == 0; };
+    for (size_t i = 0; i < pares::CAPACIDAD;) {
+      uint8_t mac[6];
+      if (t.ocupada(i) && (t.mac(i, mac), vence(pares::clave(mac)))) {
+        t.borrar(i);
+      } else {
+        i++;
+      }
+    }
+    for (auto it = vivos.begin(); it != vivos.end();) it = vence(it->first) ? vivos.erase(it) : std::next(it);
+    if (!coincide(t, vivos)) {
+      COMPROBAR(false, "ronda %d: quedaron vencidos o se borraron pares vigentes", ronda);
+      return;
+    }
+  }
+}
+
+static void medir() {
+  pares::Tabla t;
+  std::vector<Mac> presentes, ausentes;
+  for (uint32_t n = 0; presentes.size() < 20; n++) {
+    presentes.push_back(macNumero(n * 7919));
+    alta(t, presentes.back());
+  }
+  for (uint32_t n = 0; n < 20; n++) ausentes.push_back(macNumero(500000 + n));
+
+  double ns = prueba::medirNs(200000, [&] {
+    size_t suma = 0;
+    for (const Mac &m : presentes) suma += t.buscar(m.b);
+    prueba::usar(suma);
+  });
+  std::printf("Buscar (está)      : %.2f ns con %zu pares\n", ns / presentes.size(), t.cantidad());
+  ns = prueba::medirNs(200000, [&] {
+    size_t suma = 0;
+    for (const Mac &m : ausentes) suma += t.buscar(m.b);
+    prueba::usar(suma);
+  });
+  std::printf("Buscar (no está)   : %.2f ns con %zu pares\n", ns / ausentes.size(), t.cantidad());
+  ns = prueba::medirNs(200000, [&] {
+    for (const Mac &m : ausentes) t.borrar(alta(t, m));
+  });
+  std::printf("Alta y baja        : %.2f ns\n", ns / ausentes.size());
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarAltas();
+  probarBorradoConVuelta();
+  probarAlAzar();
+  probarVencimiento();
+  medir();
+  return prueba::resultado("tabla_pares");
+}
@@ -0,0 +1,301 @@
+/*
+ * PRUEBA Y BENCHMARK DEL FORMATO DE TRAMAS ESP-NOW
+ *
+ * - Ida y vuelta codificar -> decodificar para 1 a 59 muestras.
+ * - Corrupción: todo error de uno o dos bits en la trama se rechaza; largos
+ *   truncados, extendidos o que no coinciden con la cantidad de muestras también.
+ * - Tramas de control del emparejamiento y el lote del emisor.
+ * - Secuencia del receptor: pérdidas, tardías, duplicados, vuelta de 65535 a 0 y
+ *   reinicio del emisor.
+ * - Benchmark: tramas por segundo al codificar, validar y decodificar.
+ *
+ * Compilación y ejecución (desde la raíz del repositorio):
+ *   g++ -std=c++20 -O2 -Wall -Wextra simulacion-host/pruebas/trama_espnow.cpp -o /tmp/prueba_trama
+ *   /tmp/prueba_trama
+ */
+
+#include "prueba.h"
+#include "../../Práctica ESPNOW + ADC + PWM/trama_espnow.h"
+
+#include <cstring>
+#include <vector>
+
+static uint32_t semilla = 2024;
+static uint32_t azar() {
+  semilla = semilla * 1103515245u + 12345u;
+  return semilla >> 8;
+}
+
+// 'n' muestras con marcas crecientes dentro de los 65.5 s que admite una trama
+static std::vector<trama::Muestra> muestrasAlAzar(size_t n) {
+  std::vector<trama::Muestra> m(n);
+  uint32_t t = azar();
+  uint32_t paso = 65535 / (uint32_t)(n > 1 ? n - 1 : 1);
+  for (size_t i = 0; i < n; i++) {
+    m[i] = {t, (uint16_t)(azar() % 4096)};
+    t += azar() % (paso + 1);
+  }
+  return m;
+}
+
+static void probarCrc() {
+  const char *texto = "123456789";
+  COMPROBAR(trama::crc16((const uint8_t *)texto, 9) == 0x29B1, "vector de CRC-16/CCITT-FALSE: %04x",
+            trama::crc16((const uint8_t *)texto, 9));
+}
+
+static void probarIdaYVuelta() {
+  for (size_t n = 1; n <= trama::MAX_MUESTRAS; n++) {
+    std::vector<trama::Muestra> m = muestrasAlAzar(n);
+    uint8_t buf[trama::TAM_MAXIMO];
+    uint16_t seq = (uint16_t)azar();
+    size_t len = trama::codificar(7, 3, seq, m.data(), n, buf, sizeof(buf));
+    COMPROBAR(len == trama::tamano(n), "n=%zu: largo %zu", n, len);
+
+    trama::Encabezado enc = {};
+    trama::Muestra leidas[trama::MAX_MUESTRAS];
+    COMPROBAR(trama::decodificar(buf, len, enc, leidas, trama::MAX_MUESTRAS) == trama::Error::Ninguno, "n=%zu", n);
+    COMPROBAR(enc.emisor == 7 && enc.canal == 3 && enc.cantidad == n && enc.secuencia == seq &&
+                  enc.t0_ms == m[0].t_ms,
+              "n=%zu: encabezado", n);
+    bool iguales = true;
+    for (size_t i = 0; i < n; i++) iguales &= leidas[i].t_ms == m[i].t_ms && leidas[i].valor == m[i].valor;
+    COMPROBAR(iguales, "n=%zu: muestras", n);
+
+    // Con menos capacidad solo se copian las primeras
+    trama::Muestra pocas[2] = {};
+    COMPROBAR(trama::decodificar(buf, len, enc, pocas, 1) == trama::Error::Ninguno && pocas[0].valor == m[0].valor &&
+                  pocas[1].valor == 0,
+              "n=%zu: capacidad 1", n);
+  }
+  COMPROBAR(trama::tamano(1) == 16 && trama::tamano(trama::MAX_MUESTRAS) <= trama::TAM_MAXIMO, "tamaños");
+
+  // Lo que no se puede codificar
+  std::vector<trama::Muestra> m = muestrasAlAzar(trama::MAX_MUESTRAS + 1);
+  uint8_t buf[trama::TAM_MAXIMO + 8];
+  COMPROBAR(trama::codificar(1, 0, 0, m.data(), 0, buf, sizeof(buf)) == 0, "cero muestras");
+  COMPROBAR(trama::codificar(1, 0, 0, m.data(), trama::MAX_MUESTRAS + 1, buf, sizeof(buf)) == 0, "60 muestras");
+  COMPROBAR(trama::codificar(1, 0, 0, m.data(), 3, buf, trama::tamano(3) - 1) == 0, "sin capacidad");
+  trama::Muestra lejos[2] = {{1000, 1}, {1000 + 65536, 2}};
+  COMPROBAR(trama::codificar(1, 0, 0, lejos, 2, buf, sizeof(buf)) == 0, "desfase de más de 65535 ms");
+  lejos[1].t_ms = 1000 + 65535;
+  COMPROBAR(trama::codificar(1, 0, 0, lejos, 2, buf, sizeof(buf)) == trama::tamano(2), "desfase límite");
+}
+
+static void probarCorrupcion() {
+  for (size_t n : {(size_t)1, (size_t)4, trama::MAX_MUESTRAS}) {
+    std::vector<trama::Muestra> m = muestrasAlAzar(n);
+    uint8_t original[trama::TAM_MAXIMO], buf[trama::TAM_MAXIMO];
+    size_t len = trama::codificar(2, 0, 500, m.data(), n, original, sizeof(original));
+    COMPROBAR(len == trama::tamano(n), "n=%zu: largo %zu", n, len);
+    if (len == 0) continue;
+    size_t bits = len * 8;
+
+    // Todo error de un bit, y de dos bits en las tramas cortas (el CRC-16 los
+    // detecta todos en tramas de menos de 32767 bits)
+    size_t aceptadas = 0, casos = 0;
+    for (size_t a = 0; a < bits; a++) {
+      for (size_t b = a; b < (n <= 4 ? bits : a + 1); b++) {
+        memcpy(buf, original, len);
+        buf[a / 8] ^= (uint8_t)(1 << (a % 8));
+        if (b != a) buf[b / 8] ^= (uint8_t)(1 << (b % 8));
+        casos++;
+        if (trama::validar(buf, len) == trama::Error::Ninguno) aceptadas++;
+      }
+    }
+    COMPROBAR(aceptadas == 0, "n=%zu: %zu de %zu tramas con 1-2 bits invertidos pasaron", n, aceptadas, casos);
+
+    // El error reportado depende de dónde cayó
+    memcpy(buf, original, len);
+    buf[len - 1] ^= 0x40;
+    COMPROBAR(trama::validar(buf, len) == trama::Error::CRC, "CRC dañado");
+    memcpy(buf, original, len);
+    buf[trama::TAM_ENCABEZADO] ^= 0x01;
+    COMPROBAR(trama::validar(buf, len) == trama::Error::CRC, "muestra mala");
+    memcpy(buf, original, len);
+    buf[0] = trama::VERSION + 1;
+    COMPROBAR(trama::validar(buf, len) == trama::Error::Version, "versión");
+
+    // Largos que no corresponden
+    COMPROBAR(trama::validar(original, len - 1) == trama::Error::Longitud, "n=%zu: truncada", n);
+    COMPROBAR(trama::validar(original, len + 1) == trama::Error::Longitud, "n=%zu: extendida", n);
+    COMPROBAR(trama::validar(original, trama::TAM_ENCABEZADO + 1) == trama::Error::Corta, "n=%zu: corta", n);
+    COMPROBAR(trama::validar(original, 0) == trama::Error::Corta, "vacía");
+  }
+
+  // Cantidad reescrita con el CRC recalculado: la longitud la delata
+  std::vector<trama::Muestra> m = muestrasAlAzar(5);
+  uint8_t buf[trama::TAM_MAXIMO];
+  size_t len = trama::codificar(2, 0, 1, m.data(), 5, buf, sizeof(buf));
+  for (uint8_t cantidad : {(uint8_t)0, (uint8_t)4, (uint8_t)6, (uint8_t)(trama::MAX_MUESTRAS + 1), (uint8_t)255}) {
+    buf[3] = cantidad;
+    trama::escribir16(buf + len - trama::TAM_CRC, trama::crc16(buf, len - trama::TAM_CRC));
+    COMPROBAR(trama::validar(buf, len) == trama::Error::Longitud, "cantidad %u con largo de 5", cantidad);
+  }
+}
+
+static void probarControl() {
+  uint8_t buf[trama::TAM_CONTROL];
+  COMPROBAR(trama::codificarControl(trama::Control::Solicitud, 42, buf, 4) == 0, "sin capacidad");
+  COMPROBAR(trama::codificarControl(trama::Control::Solicitud, 42, buf, sizeof(buf)) == trama::TAM_CONTROL, "largo");
+  COMPROBAR(trama::esControl(buf, sizeof(buf)), "marca");
+  trama::Control tipo = {};
+  uint8_t dato = 0;
+  COMPROBAR(trama::decodificarControl(buf, sizeof(buf), tipo, dato) == trama::Error::Ninguno &&
+                tipo == trama::Control::Solicitud && dato == 42,
+            "ida y vuelta");
+  COMPROBAR(trama::decodificarControl(buf, sizeof(buf) - 1, tipo, dato) == trama::Error::Longitud, "truncada");
+  for (size_t bit = 8; bit < trama::TAM_CONTROL * 8; bit++) {
+    uint8_t mala[trama::TAM_CONTROL];
+    memcpy(mala, buf, sizeof(buf));
+    mala[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    COMPROBAR(trama::decodificarControl(mala, sizeof(mala), tipo, dato) == trama::Error::CRC, "bit %zu", bit);
+  }
+
+  // Una trama de datos nunca parece de control
+  std::vector<trama::Muestra> m = muestrasAlAzar(1);
+  uint8_t datos[trama::TAM_MAXIMO];
+  size_t len = trama::codificar(1, 0, 0, m.data(), 1, datos, sizeof(datos));
+  COMPROBAR(!trama::esControl(datos, len), "trama de datos");
+}
+
+static void probarLote() {
+  trama::Lote lote;
+  for (size_t i = 0; i < trama::MAX_MUESTRAS; i++) COMPROBAR(lote.agregar(1000 + (uint32_t)i * 10, (uint16_t)i), "%zu", i);
+  COMPROBAR(!lote.agregar(2000, 0), "el lote lleno rechaza");
+  uint8_t buf[trama::TAM_MAXIMO];
+  COMPROBAR(lote.cerrar(1, 0, buf, 100) == 0 && lote.cantidad() == trama::MAX_MUESTRAS && lote.secuencia() == 0,
+            "sin capacidad no se vacía");
+  COMPROBAR(lote.cerrar(1, 0, buf, sizeof(buf)) == trama::tamano(trama::MAX_MUESTRAS), "cierra");
+  COMPROBAR(lote.cantidad() == 0 && lote.secuencia() == 1, "vacío con la secuencia siguiente");
+  COMPROBAR(lote.agregar(5000, 1) && !lote.agregar(5000 + 65536, 2), "desfase de más de 65535 ms");
+}
+
+static void probarSecuencia() {
+  {
+    trama::Secuencia s;
+    for (uint16_t i = 100; i < 110; i++) COMPROBAR(s.registrar(i), "en orden %u", i);
+    COMPROBAR(s.registrar(113) && s.perdidas() == 3, "salto de 3: %u perdidas", s.perdidas());
+    COMPROBAR(!s.registrar(111) && s.perdidas() == 2 && s.desordenadas() == 1, "tardía descuenta una pérdida");
+    COMPROBAR(!s.registrar(111) && s.perdidas() == 2 && s.duplicadas() == 1, "segunda copia: duplicado");
+    COMPROBAR(!s.registrar(113) && s.duplicadas() == 2, "duplicado de la última");
+    COMPROBAR(!s.registrar(105) && s.perdidas() == 2 && s.duplicadas() == 3, "ya recibida dentro de la ventana");
+    COMPROBAR(s.recibidas() == 11 && s.reinicios() == 0, "recibidas %u", s.recibidas());
+
+    // Reinicio del emisor: la secuencia vuelve a 0 y las tramas se aceptan
+    COMPROBAR(s.registrar(0) && s.reinicios() == 1, "reinicio");
+    for (uint16_t i = 1; i < 20; i++) COMPROBAR(s.registrar(i), "tras el reinicio %u", i);
+    COMPROBAR(s.perdidas() == 2 && s.recibidas() == 31, "el reinicio no suma pérdidas: %u", s.perdidas());
+  }
+  {
+    // Reinicio avisado por una solicitud de emparejamiento: un retroceso pequeño,
+    // que sin el aviso se tomaría como duplicado, se acepta
+    trama::Secuencia s;
+    s.reiniciar();
+    COMPROBAR(s.reinicios() == 0, "reiniciar antes de la primera trama no cuenta");
+    for (uint16_t i = 0; i < 20; i++) s.registrar(i);
+    COMPROBAR(!s.registrar(3) && s.duplicadas() == 1, "sin aviso es un duplicado");
+    s.reiniciar();
+    COMPROBAR(s.registrar(0) && s.registrar(1) && s.reinicios() == 1, "con aviso se acepta");
+    COMPROBAR(s.recibidas() == 22 && s.perdidas() == 0 && s.duplicadas() == 1, "conserva las estadísticas");
+  }
+  {
+    // Límite de la ventana: 32 atrás es tardía, 33 atrás es reinicio
+    trama::Secuencia s;
+    s.registrar(1000);
+    s.registrar(1040);  // Pierde 1001-1039
+    COMPROBAR(!s.registrar(1009) && s.desordenadas() == 1 && s.perdidas() == 38, "32 atrás: tardía");
+    COMPROBAR(s.registrar(1008) && s.reinicios() == 1 && s.perdidas() == 38, "33 atrás: reinicio");
+  }
+  {
+    // Antes de la primera trama no hubo pérdidas que descontar
+    trama::Secuencia s;
+    s.registrar(50);
+    COMPROBAR(!s.registrar(49) && s.perdidas() == 0 && s.desordenadas() == 0, "anterior a la primera");
+  }
+  {
+    // La vuelta de 65535 a 0 no es un reinicio
+    trama::Secuencia s;
+    for (uint32_t i = 65530; i < 65540; i++) COMPROBAR(s.registrar((uint16_t)i), "vuelta %u", i);
+    COMPROBAR(s.reinicios() == 0 && s.perdidas() == 0 && s.recibidas() == 10, "vuelta de la secuencia");
+  }
+  {
+    // Pérdidas, duplicados y reordenamiento al azar dentro de la ventana: cada número
+    // entre la primera y la última trama aceptadas queda como recibido, perdido o
+    // tardío, una sola vez
+    trama::Secuencia s;
+    uint32_t primera = 0, ultima = 0, repetidas = 0;
+    bool alguna = false;
+    std::vector<uint32_t> pendientes;
+    auto entregar = [&](uint32_t seq) {
+      if (s.registrar((uint16_t)seq)) {
+        if (!alguna) primera = seq;
+        alguna = true;
+        ultima = seq;
+      }
+    };
+    for (uint32_t seq = 0; seq < 200000; seq++) {
+      uint32_t r = azar() % 100;
+      if (r < 5) continue;                    // Se pierde
+      if (r < 10) {                           // Llega más tarde
+        pendientes.push_back(seq);
+        continue;
+      }
+      entregar(seq);
+      if (r < 13) {                           // Llega dos veces
+        entregar(seq);
+        repetidas++;
+      }
+      if (!pendientes.empty() && azar() % 4 == 0) {
+        // Una demora de más de la ventana ya no es un reordenamiento: se descarta
+        if (seq - pendientes.front() < trama::Secuencia::VENTANA_REORDEN) entregar(pendientes.front());
+        pendientes.erase(pendientes.begin());
+      }
+    }
+    COMPROBAR(s.recibidas() + s.perdidas() + s.desordenadas() == ultima - primera + 1,
+              "recibidas %u + perdidas %u + tardías %u != %u", s.recibidas(), s.perdidas(), s.desordenadas(),
+              ultima - primera + 1);
+    COMPROBAR(s.duplicadas() == repetidas && s.reinicios() == 0, "duplicadas %u de %u, reinicios %u", s.duplicadas(),
+              repetidas, s.reinicios());
+    COMPROBAR(s.desordenadas() > 1000 && s.perdidas() > 1000, "la prueba ejercita tardías (%u) y pérdidas (%u)",
+              s.desordenadas(), s.perdidas());
+  }
+}
+
+static void medir() {
+  uint8_t buf[trama::TAM_MAXIMO];
+  trama::Encabezado enc = {};
+  trama::Muestra leidas[trama::MAX_MUESTRAS];
+  for (size_t n : {(size_t)1, trama::MAX_MUESTRAS}) {
+    std::vector<trama::Muestra> m = muestrasAlAzar(n);
+    uint16_t seq = 0;
+    double cod = prueba::medirNs(200000, [&] {
+      prueba::usar(trama::codificar(1, 0, seq++, m.data(), n, buf, sizeof(buf)));
+    });
+    size_t len = trama::tamano(n);
+    double val = prueba::medirNs(200000, [&] { prueba::usar(trama::validar(buf, len)); });
+    double dec = prueba::medirNs(200000, [&] {
+      prueba::usar(trama::decodificar(buf, len, enc, leidas, trama::MAX_MUESTRAS));
+      prueba::usar(leidas[0]);
+    });
+    std::printf("%2zu muestras (%3zu B): codificar %6.0f ns (%5.2f Mtramas/s), validar %6.0f ns, "
+                "decodificar %6.0f ns (%5.2f Mtramas/s, %.0f Mmuestras/s)\n",
+                n, len, cod, 1e3 / cod, val, dec, 1e3 / dec, n * 1e3 / dec);
+  }
+  trama::Secuencia s;
+  uint16_t seq = 0;
+  double ns = prueba::medirNs(1000000, [&] { prueba::usar(s.registrar(seq++)); });
+  std::printf("Secuencia          : %.1f ns por trama\n", ns);
+}
+
+int main(int argc, char **argv) {
+  prueba::iniciar(argc, argv);
+  probarCrc();
+  probarIdaYVuelta();
+  probarCorrupcion();
+  probarControl();
+  probarLote();
+  probarSecuencia();
+  medir();
+  return prueba::resultado("trama_espnow");
+}